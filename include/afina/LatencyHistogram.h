@@ -0,0 +1,135 @@
+#ifndef AFINA_LATENCY_HISTOGRAM_H
+#define AFINA_LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+
+/**
+ * # Log-linear histogram of latencies
+ * Buckets are laid out as in HdrHistogram: values below kSubBuckets have a bucket each, every next power
+ * of two is split into kSubBuckets equal buckets. So bucket width is within 1/kSubBuckets of the value,
+ * about 3%, whatever the value is, and whole range up to kMaxValue takes about a thousand counters.
+ * Values are nanoseconds, greater ones are counted as kMaxValue.
+ *
+ * Only one thread records into the histogram: counters are updated with plain relaxed load and store,
+ * without locked instructions. Any thread could Add the histogram into its own copy meanwhile, it sees
+ * counts of some recent moment.
+ */
+class LatencyHistogram {
+public:
+    static const int kSubBits = 5;
+    static const uint64_t kSubBuckets = 1 << kSubBits;
+    // Highest power of two values are split by
+    static const int kMaxShift = 31;
+    static const uint64_t kMaxValue = (kSubBuckets << (kMaxShift + 1)) - 1;
+    static const std::size_t kBuckets = (kMaxShift + 2) * kSubBuckets;
+
+    LatencyHistogram() { Reset(); }
+
+    void Reset() {
+        for (auto &count : _counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        _count.store(0, std::memory_order_relaxed);
+        _sum.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    // Owner thread only
+    void Record(uint64_t value) {
+        if (value > kMaxValue) {
+            value = kMaxValue;
+        }
+        increment(_counts[index_of(value)], 1);
+        increment(_count, 1);
+        increment(_sum, value);
+        if (value > _max.load(std::memory_order_relaxed)) {
+            _max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    // Merges other histogram into this one, which must not be recorded into at the same time
+    void Add(const LatencyHistogram &other) {
+        for (std::size_t i = 0; i < kBuckets; i++) {
+            increment(_counts[i], other._counts[i].load(std::memory_order_relaxed));
+        }
+        increment(_count, other._count.load(std::memory_order_relaxed));
+        increment(_sum, other._sum.load(std::memory_order_relaxed));
+        uint64_t max = other._max.load(std::memory_order_relaxed);
+        if (max > _max.load(std::memory_order_relaxed)) {
+            _max.store(max, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t Count() const { return _count.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return _max.load(std::memory_order_relaxed); }
+
+    uint64_t Mean() const {
+        uint64_t count = Count();
+        return count == 0 ? 0 : _sum.load(std::memory_order_relaxed) / count;
+    }
+
+    /**
+     * Value not less than the given percent of recorded ones, that is the upper bound of the bucket the
+     * percentile falls into, but never above the max recorded value. Zero for empty histogram
+     */
+    uint64_t Percentile(double percent) const {
+        uint64_t count = Count();
+        if (count == 0) {
+            return 0;
+        }
+
+        // Rank of the value, from 1 to count
+        uint64_t rank = uint64_t(percent / 100 * count + 0.5);
+        rank = rank < 1 ? 1 : (rank > count ? count : rank);
+
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBuckets; i++) {
+            seen += _counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t highest = highest_of(i);
+                return highest < Max() ? highest : Max();
+            }
+        }
+        return Max();
+    }
+
+private:
+    // No copy/move/assign allowed
+    LatencyHistogram(const LatencyHistogram &);            // = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &); // = delete;
+
+    static void increment(std::atomic<uint64_t> &counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    static std::size_t index_of(uint64_t value) {
+        if (value < kSubBuckets) {
+            return value;
+        }
+        int shift = 63 - __builtin_clzll(value) - kSubBits;
+        return (shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets);
+    }
+
+    // The highest value counted in the bucket
+    static uint64_t highest_of(std::size_t index) {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        int shift = int(index / kSubBuckets) - 1;
+        uint64_t lowest = (kSubBuckets + index % kSubBuckets) << shift;
+        return lowest + (uint64_t(1) << shift) - 1;
+    }
+
+    std::atomic<uint64_t> _counts[kBuckets];
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _sum;
+    std::atomic<uint64_t> _max;
+};
+
+} // namespace Afina
+
+#endif // AFINA_LATENCY_HISTOGRAM_H
@@ -0,0 +1,223 @@
+#ifndef AFINA_METRICS_H
+#define AFINA_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include <afina/LatencyHistogram.h>
+#include <afina/Storage.h>
+#include <afina/concurrency/CoreLocal.h>
+#include <afina/concurrency/ThreadLocal.h>
+
+namespace Afina {
+
+/**
+ * # Server wide metrics registry
+ * Network servers report connections and bytes going through the sockets, parser counts commands by type,
+ * storage reports to its StorageCounters. Counters are per core, see Concurrency::CoreLocal, so reporting
+ * costs an uncontended atomic add; connections are listed under the lock, as they come and go much more
+ * rarely than requests.
+ *
+ * Parts which have something else to show register a report for the group, that is the argument of
+ * stats command, for example "slabs". Reports are called under the registry lock.
+ *
+ * Latencies of commands are recorded into histograms of the calling thread, see Concurrency::ThreadLocal,
+ * by stages, and could be read for each thread, that is for each worker, or merged over all of them.
+ */
+class Metrics {
+public:
+    // Commands parser knows about
+    enum Command { kGet, kGets, kSet, kAdd, kAppend, kPrepend, kCas, kIncr, kDecr, kStats, kCommands };
+
+    enum Counter { kTotalConnections, kCurrentConnections, kBytesRead, kBytesWritten, kCounters };
+
+    // Stages of the command latency: parsing of the command line, execution from the argument received to
+    // the result ready, storage reads included, and the whole way from the argument to the response queued
+    enum Stage { kParse, kExecute, kTotal, kStages };
+
+    // Name/value pairs, rendered as STAT lines
+    typedef std::vector<std::pair<std::string, std::string>> Lines;
+    typedef std::function<void(Lines &out)> Report;
+
+    // Client connection as it is listed by stats conns
+    struct Connection {
+        std::string address;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    Metrics(std::shared_ptr<StorageCounters> storage, std::size_t max_bytes)
+        : _storage(std::move(storage)), _max_bytes(max_bytes), _started(std::chrono::steady_clock::now()) {}
+
+    static const char *CommandName(Command command) {
+        static const char *names[kCommands] = {"get", "gets", "set", "add", "append",
+                                               "prepend", "cas", "incr", "decr", "stats"};
+        return names[command];
+    }
+
+    // False if name isn't a command
+    static bool CommandOf(const std::string &name, Command &command) {
+        for (int i = 0; i < kCommands; i++) {
+            if (name == CommandName(Command(i))) {
+                command = Command(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Count(Command command) { add(kCounters + command, 1); }
+
+    static const char *StageName(Stage stage) {
+        static const char *names[kStages] = {"parse", "execute", "total"};
+        return names[stage];
+    }
+
+    // Nanoseconds passed since the given moment
+    static uint64_t Since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Time the stage of the command took
+    void Took(Command command, Stage stage, uint64_t nanoseconds) {
+        _latencies.Local().commands[command][stage].Record(nanoseconds);
+    }
+
+    // Merges latencies of the command stage recorded by all threads into out
+    void Latency(Command command, Stage stage, LatencyHistogram &out) const {
+        _latencies.ForEach([command, stage, &out](const latencies &l) { out.Add(l.commands[command][stage]); });
+    }
+
+    // Number of threads which have recorded latencies, workers are numbered from zero in order they came
+    std::size_t Workers() const { return _latencies.Size(); }
+
+    // Merges latencies of the command stage recorded by the given worker into out
+    void WorkerLatency(std::size_t worker, Command command, Stage stage, LatencyHistogram &out) const {
+        std::size_t i = 0;
+        _latencies.ForEach([worker, command, stage, &out, &i](const latencies &l) {
+            if (i++ == worker) {
+                out.Add(l.commands[command][stage]);
+            }
+        });
+    }
+
+    void Read(std::size_t bytes) { add(kBytesRead, bytes); }
+    void Written(std::size_t bytes) { add(kBytesWritten, bytes); }
+
+    // New client connection on the given socket
+    void Opened(int socket, const struct sockaddr *address, socklen_t address_size) {
+        char host[NI_MAXHOST], port[NI_MAXSERV];
+        std::string name = "unknown";
+        if (getnameinfo(address, address_size, host, sizeof(host), port, sizeof(port),
+                        NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+            name = std::string("tcp:") + host + ":" + port;
+        }
+
+        add(kTotalConnections, 1);
+        add(kCurrentConnections, 1);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _connections[socket] = Connection{name, std::chrono::steady_clock::now()};
+    }
+
+    // Socket is about to be closed
+    void Closed(int socket) {
+        add(kCurrentConnections, -1);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _connections.erase(socket);
+    }
+
+    void AddReport(const std::string &group, const std::string &name, Report report) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _reports[group][name] = std::move(report);
+    }
+
+    void RemoveReport(const std::string &group, const std::string &name) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _reports[group].erase(name);
+    }
+
+    // Appends lines of all reports of the group, false if there is no such group
+    bool Reports(const std::string &group, Lines &out) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto found = _reports.find(group);
+        if (found == _reports.end() || found->second.empty()) {
+            return _standard.count(group) > 0;
+        }
+        for (auto &report : found->second) {
+            report.second(out);
+        }
+        return true;
+    }
+
+    int64_t Total(Counter counter) const { return total(counter); }
+    int64_t Total(Command command) const { return total(kCounters + command); }
+
+    std::map<int, Connection> Connections() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _connections;
+    }
+
+    const StorageCounters &Storage() const { return *_storage; }
+    std::size_t MaxBytes() const { return _max_bytes; }
+
+    // Seconds since the registry was created, that is since the server start
+    uint64_t Uptime() const {
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - _started).count();
+    }
+
+private:
+    static const int kValues = kCounters + kCommands;
+
+    // Each core has its own copy of all the values
+    struct core {
+        core() {
+            for (auto &value : values) {
+                value.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        std::atomic<int64_t> values[kValues];
+    };
+
+    // Histograms of a thread, one per command and stage
+    struct latencies {
+        LatencyHistogram commands[kCommands][kStages];
+    };
+
+    void add(int value, int64_t delta) { _cores.Local().values[value].fetch_add(delta, std::memory_order_relaxed); }
+
+    int64_t total(int value) const {
+        int64_t sum = 0;
+        _cores.ForEach([&sum, value](const core &c) { sum += c.values[value].load(std::memory_order_relaxed); });
+        return sum;
+    }
+
+    std::shared_ptr<StorageCounters> _storage;
+    const std::size_t _max_bytes;
+    const std::chrono::steady_clock::time_point _started;
+
+    Concurrency::CoreLocal<core> _cores;
+    Concurrency::ThreadLocal<latencies> _latencies;
+
+    mutable std::mutex _mutex;
+    std::map<int, Connection> _connections;
+    std::map<std::string, std::map<std::string, Report>> _reports;
+    // Groups memcached always has, they are valid even if nobody reports to them
+    const std::set<std::string> _standard{"slabs"};
+};
+
+} // namespace Afina
+
+#endif // AFINA_METRICS_H
@@ -1,21 +1,146 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
+
+#include <afina/concurrency/CoreLocal.h>
 
 namespace Afina {
 
+/**
+ * # Read only reference to the value bytes
+ * View shares ownership of the memory block bytes live in: the block stays alive while some view
+ * references it, even if the item is evicted, deleted or overwritten in the storage meanwhile. Copying
+ * a view never copies the bytes.
+ */
+class ValueView {
+public:
+    ValueView() : _data(nullptr), _size(0) {}
+
+    // View of bytes owned by the given object, no owner means bytes are static
+    ValueView(std::shared_ptr<const void> owner, const char *data, std::size_t size)
+        : _owner(std::move(owner)), _data(data), _size(size) {}
+
+    // View of its own copy of the string
+    explicit ValueView(std::string value) {
+        auto owner = std::make_shared<std::string>(std::move(value));
+        _data = owner->data();
+        _size = owner->size();
+        _owner = std::move(owner);
+    }
+
+    const char *data() const { return _data; }
+    std::size_t size() const { return _size; }
+
+    // Object that keeps bytes alive, other bytes of the same block could be viewed with it
+    const std::shared_ptr<const void> &owner() const { return _owner; }
+    std::string str() const { return std::string(_data, _size); }
+
+    // Default constructed view references nothing, not even an empty value
+    bool valid() const { return _data != nullptr; }
+
+private:
+    std::shared_ptr<const void> _owner;
+    const char *_data;
+    std::size_t _size;
+};
+
+/**
+ * # Item of the storage contents, see Storage::Dump
+ * Key and value are views, so taking a copy of the whole storage costs no more than pinning its items.
+ */
+struct StoredItem {
+    ValueView key;
+    ValueView value;
+    // Seconds left to live, zero means forever
+    uint32_t ttl;
+};
+
+/**
+ * # Counters of the storage operations
+ * Every core has its own copy of all the counters, see Concurrency::CoreLocal: update costs an uncontended
+ * atomic add even at millions of operations per second. Total sums the copies, so counters read one after
+ * another are not taken at the same moment.
+ */
+class StorageCounters {
+public:
+    // kItems and kBytes are items held and memory they take as the storage accounts it, the rest count events
+    enum Counter { kGets, kHits, kMisses, kSets, kEvictions, kBytesIn, kBytesOut, kItems, kBytes, kCounters };
+
+    void Add(Counter counter, int64_t delta = 1) {
+        _cores.Local().values[counter].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    // Get of the value of the given size, or a miss
+    void Got(bool hit, std::size_t bytes) {
+        core &local = _cores.Local();
+        local.values[kGets].fetch_add(1, std::memory_order_relaxed);
+        if (hit) {
+            local.values[kHits].fetch_add(1, std::memory_order_relaxed);
+            local.values[kBytesOut].fetch_add(bytes, std::memory_order_relaxed);
+        } else {
+            local.values[kMisses].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Write of the value of the given size
+    void Stored(std::size_t bytes) {
+        core &local = _cores.Local();
+        local.values[kSets].fetch_add(1, std::memory_order_relaxed);
+        local.values[kBytesIn].fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    int64_t Total(Counter counter) const {
+        int64_t total = 0;
+        _cores.ForEach(
+            [&total, counter](const core &c) { total += c.values[counter].load(std::memory_order_relaxed); });
+        return total;
+    }
+
+private:
+    // Takes two cache lines, the second one isn't shared with other cores either
+    struct core {
+        core() {
+            for (auto &value : values) {
+                value.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        std::atomic<int64_t> values[kCounters];
+    };
+
+    Concurrency::CoreLocal<core> _cores;
+};
+
 /**
  *
  */
 class Storage {
 public:
+    // Version of all associations in storages which don't track versions, see GetWithVersion
+    static const uint64_t kUntracked = 1;
+
     Storage() {}
     virtual ~Storage() {}
 
     virtual void Start() {}
     virtual void Stop() {}
 
+    /**
+     * From now on storage reports items it adds and removes, and evictions, to the given counters, see
+     * StorageCounters. Must be called before the storage is used. Storage made of other storages passes
+     * counters to its parts
+     */
+    virtual void SetCounters(std::shared_ptr<StorageCounters> counters) { _counters = std::move(counters); }
+
     /**
      * Stores association between given key/value pair.
      * If key is already present in storage then replace existing value by
@@ -84,6 +209,273 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Same as Put, but association expires in ttl seconds: once the time comes
+     * storage behaves like the key was deleted. Zero ttl means association
+     * never expires. Put without ttl makes association unexpirable again.
+     *
+     * Default implementation supports only zero ttl and fails otherwise,
+     * storages which are able to expire items override it, the rest could be
+     * wrapped into Backend::ExpiringStorage
+     *
+     * @param key to be associated with value
+     * @param value to be assigned for the key
+     * @param ttl number of seconds association lives
+     */
+    virtual bool PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+        return ttl == 0 && Put(key, value);
+    }
+
+    /**
+     * Same as PutIfAbsent, but association expires in ttl seconds, see PutWithTTL
+     */
+    virtual bool PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+        return ttl == 0 && PutIfAbsent(key, value);
+    }
+
+    /**
+     * Same as Set, but association expires in ttl seconds, see PutWithTTL
+     */
+    virtual bool SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+        return ttl == 0 && Set(key, value);
+    }
+
+    /**
+     * Same as Get, but instead of copying value into the output parameter
+     * method returns view of the value bytes, see ValueView
+     *
+     * Default implementation makes a copy of the value for the view, storages
+     * which are able to share item memory override it
+     *
+     * @param key to retrive value for
+     * @param value output parameter to put view of the value to
+     */
+    virtual bool GetView(const std::string &key, ValueView &value) {
+        std::string copy;
+        if (!Get(key, copy)) {
+            return false;
+        }
+        value = ValueView(std::move(copy));
+        return true;
+    }
+
+    /**
+     * Adds data to the end of the value of existing key, ttl of the key stays
+     * the same. No other write to the key gets in between reading the old
+     * value and storing the new one.
+     *
+     * Default implementation is Get followed by Set, that is atomic only for
+     * storages used by a single thread
+     *
+     * @param key to update value of
+     * @param data to add
+     * @return true if key was found and value has been updated
+     */
+    virtual bool Append(const std::string &key, const std::string &data) {
+        std::string value;
+        return Get(key, value) && Set(key, value + data);
+    }
+
+    /**
+     * Same as Append, but adds data to the beginning of the value
+     */
+    virtual bool Prepend(const std::string &key, const std::string &data) {
+        std::string value;
+        return Get(key, value) && Set(key, data + value);
+    }
+
+    /**
+     * Retrives values for several keys at once. values gets one view per key
+     * in the same order, view of a missing key is not valid, see ValueView.
+     * Storage could serve a batch faster than separate GetView calls: take
+     * each lock once and overlap memory accesses for different keys.
+     *
+     * Default implementation calls GetView for each key
+     *
+     * @param keys to retrive values for
+     * @param values output parameter to put views of the values to
+     * @return number of keys found
+     */
+    virtual std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) {
+        std::size_t found = 0;
+        values.assign(keys.size(), ValueView());
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            found += GetView(keys[i], values[i]);
+        }
+        return found;
+    }
+
+    /**
+     * Gets ready to serve the keys without waiting for slow reads, for event
+     * loop servers which must never block on the disk. If some of the keys
+     * have to be read, storage starts that in background and returns true,
+     * ready is called from some other thread once they all are in memory.
+     * Items could be evicted again before the server gets to them, so Get and
+     * friends still read the keys on their own, waiting for the disk.
+     *
+     * Default implementation keeps everything in memory and returns false
+     *
+     * @param keys to be retrived soon
+     * @param ready callback to call once keys are in memory
+     * @return true if ready is going to be called, false if keys could be retrived right away
+     */
+    virtual bool Prepare(const std::vector<std::string> &keys, std::function<void()> ready) { return false; }
+
+    /**
+     * Same as Get, but also returns version of the association. Each change of
+     * the association gives it new version, never seen for this key before.
+     * Version is never zero.
+     *
+     * Default implementation doesn't track versions: it is Get, which reports
+     * every association with the same version kUntracked. Storages which are
+     * able to track versions override the method
+     *
+     * @param key to retrive value for
+     * @param value output parameter to copy value to
+     * @param version output parameter for the version of the association
+     */
+    virtual bool GetWithVersion(const std::string &key, std::string &value, uint64_t &version) {
+        version = kUntracked;
+        return Get(key, value);
+    }
+
+    /**
+     * Updates existing association only if its version is still the given one,
+     * check and update are atomic. Once method returns true, association has
+     * the new value and ttl, see PutWithTTL, and version output parameter holds
+     * its new version.
+     *
+     * If method returns false, version output parameter tells the reason: zero
+     * if there is no such key, the current version if it differs from the given
+     * one, and the same version if the value couldn't be stored at all
+     *
+     * Default implementation doesn't track versions, so it can't tell whether
+     * association has changed: it never stores the value, and for existing
+     * keys leaves non-zero version as is
+     *
+     * @param key to be associated with value
+     * @param value to be assigned for the key
+     * @param ttl number of seconds association lives
+     * @param version expected version of the association, updated by the method
+     */
+    virtual bool CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl, uint64_t &version) {
+        std::string current;
+        if (!Get(key, current)) {
+            version = 0;
+        } else if (version == 0) {
+            version = kUntracked;
+        }
+        return false;
+    }
+
+    /**
+     * Takes a point-in-time copy of the storage contents, for snapshots.
+     * Storage copies itself part by part and passes each part to write:
+     * items of one part go from the least to the most recently used,
+     * different parts hold different keys and are independent of each
+     * other, so they could be restored in parallel. Part is released once
+     * write returns and only then the next one is taken, so the copy never
+     * holds more than one part.
+     *
+     * Default implementation doesn't support that and returns false
+     * without calling write
+     *
+     * @param write called with each part of the contents
+     * @return true if storage contents have been copied
+     */
+    virtual bool Dump(const std::function<void(std::vector<StoredItem> &part)> &write) { return false; }
+
+    /**
+     * Adds delta to the value of existing key, which must be decimal
+     * representation of 64 bit unsigned integer. Result wraps around on
+     * overflow. Ttl of the key stays the same, reading and writing the number
+     * is one step, as in Append.
+     *
+     * Default implementation is Get followed by Set, that is atomic only for
+     * storages used by a single thread
+     *
+     * @param key to update number of
+     * @param delta to add
+     * @param number output parameter to put the new number to
+     * @return true if key was found and number has been updated
+     * @throw std::invalid_argument if value isn't a number
+     */
+    virtual bool Increment(const std::string &key, uint64_t delta, uint64_t &number) {
+        return AddNumber(key, delta, false, number);
+    }
+
+    /**
+     * Same as Increment, but subtracts delta. Result never goes below zero
+     */
+    virtual bool Decrement(const std::string &key, uint64_t delta, uint64_t &number) {
+        return AddNumber(key, delta, true, number);
+    }
+
+protected:
+    // Reports change of the contents, if somebody counts them
+    void Count(StorageCounters::Counter counter, int64_t delta = 1) {
+        if (_counters) {
+            _counters->Add(counter, delta);
+        }
+    }
+
+    // Longest decimal representation of uint64_t
+    static const std::size_t kMaxNumberDigits = 20;
+
+    // Parses value stored for Increment, false if that isn't a number
+    static bool ParseNumber(const char *data, std::size_t size, uint64_t &number) {
+        if (size == 0 || size > kMaxNumberDigits) {
+            return false;
+        }
+        number = 0;
+        for (std::size_t i = 0; i < size; i++) {
+            if (data[i] < '0' || data[i] > '9') {
+                return false;
+            }
+            uint64_t next = number * 10 + (data[i] - '0');
+            if (number > UINT64_MAX / 10 || next < number * 10) {
+                return false;
+            }
+            number = next;
+        }
+        return true;
+    }
+
+    // Memcached arithmetic: increment wraps around, decrement stops at zero
+    static uint64_t AddDelta(uint64_t number, uint64_t delta, bool decrement) {
+        if (decrement) {
+            return number > delta ? number - delta : 0;
+        }
+        return number + delta;
+    }
+
+    // Writes decimal digits of the number to the buffer of kMaxNumberDigits, returns number of digits
+    static std::size_t FormatNumber(uint64_t number, char *buffer) {
+        char digits[kMaxNumberDigits];
+        std::size_t size = 0;
+        do {
+            digits[kMaxNumberDigits - ++size] = '0' + number % 10;
+            number /= 10;
+        } while (number != 0);
+        std::copy(digits + kMaxNumberDigits - size, digits + kMaxNumberDigits, buffer);
+        return size;
+    }
+
+private:
+    bool AddNumber(const std::string &key, uint64_t delta, bool decrement, uint64_t &number) {
+        std::string value;
+        if (!Get(key, value)) {
+            return false;
+        }
+        if (!ParseNumber(value.data(), value.size(), number)) {
+            throw std::invalid_argument("Value of " + key + " is not a number");
+        }
+        number = AddDelta(number, delta, decrement);
+        return Set(key, std::to_string(number));
+    }
+
+    std::shared_ptr<StorageCounters> _counters;
 };
 
 } // namespace Afina
@@ -7,6 +7,10 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * Handle to the memory block allocated by Simple. Pointer keeps address of the block descriptor, so
+ * it stays valid when allocator moves the block. Copies of the pointer refer to the same block
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +21,14 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    void *get() const { return _descriptor == nullptr ? nullptr : *_descriptor; }
+
+private:
+    friend class Simple;
+
+    explicit Pointer(void **descriptor) : _descriptor(descriptor) {}
+
+    void **_descriptor;
 };
 
 } // namespace Allocator
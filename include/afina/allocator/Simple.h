@@ -1,8 +1,9 @@
 #ifndef AFINA_ALLOCATOR_SIMPLE_H
 #define AFINA_ALLOCATOR_SIMPLE_H
 
-#include <string>
 #include <cstddef>
+#include <string>
+#include <vector>
 
 namespace Afina {
 namespace Allocator {
@@ -18,6 +19,17 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * # Layout
+ * Blocks are carved from the beginning of the area, each one starts with a small header followed by
+ * payload. Table of descriptors grows from the end of the area towards blocks. Pointer refers to the
+ * descriptor rather than to the block itself, so allocator is free to move blocks around.
+ *
+ * Requested sizes are rounded up to one of size classes, classes grow geometrically by factor 1.25
+ * like memcached slab classes do. Freed blocks are merged with free neighbours and kept in per class
+ * free lists, so allocation of already seen size is O(1) and doesn't touch the rest of the area.
+ *
+ * That is NOT thread safe implementation.
  */
 // TODO: Implements interface to allow usage as C++ allocators
 class Simple {
@@ -25,37 +37,147 @@ public:
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * Allocates block of at least N bytes and returns Pointer to it. Block is taken from the free list
+     * of the matching size class, or carved from the unused tail of the area, or split from a bigger
+     * free block - in that order
+     *
+     * Throws AllocError with NoMemory type if there is no free space for the block, in that case
+     * defrag() could help
+     *
      * @param N size_t
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of the block referenced by p to be at least N bytes. Block is resized in place if
+     * possible, otherwise it is moved and the first min(old size, N) bytes are copied. In any case p and
+     * all its copies stay valid and point to the new location.
+     *
+     * Empty pointer gets newly allocated block. Throws AllocError with NoMemory type if block can't be
+     * grown, p is left untouched in that case
+     *
      * @param p Pointer
      * @param N size_t
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases block referenced by p and resets p to the empty pointer. Freeing empty pointer does
+     * nothing, freeing pointer that doesn't belong to this allocator throws AllocError with
+     * InvalidFree type
+     *
      * @param p Pointer
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Moves all allocated blocks to the beginning of the area, so that all free space becomes one
+     * contiguous chunk. Pointers stay valid, but addresses returned by Pointer::get() before
+     * the call must not be used after it
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Incremental version of defrag(): moves at most max_moves blocks towards the beginning of the area
+     * and returns true once there are no holes between allocated blocks anymore. Calls could be
+     * interleaved with any other operations, so the caller could compact area in small steps without
+     * long pauses
+     *
+     * @param max_moves size_t
+     */
+    bool defrag_step(size_t max_moves);
+
+    /**
+     * Returns true if block of N bytes fits into the area once it is empty: with the block header, payload
+     * rounded up to the size class and descriptor. Otherwise alloc(N) fails whatever is freed
+     *
+     * @param N size_t
+     */
+    bool fits(size_t N) const;
+
+    /**
+     * Returns number of area bytes block of N bytes takes: block header, payload rounded up to the size
+     * class and descriptor
+     *
+     * @param N size_t
+     */
+    static size_t footprint(size_t N);
+
+    /**
+     * Number of free bytes kept in holes between allocated blocks, defrag() turns them into unused space
+     */
+    size_t holes() const { return _holes; }
+
+    /**
+     * Number of bytes never used or returned back to the end of allocated blocks
+     */
+    size_t unused() const { return reinterpret_cast<char *>(_descriptors) - _top; }
+
+    /**
+     * Returns human readable description of the area: summary line, free lists of size classes and
+     * list of all blocks in address order
      */
     std::string dump() const;
 
 private:
-    void *_base;
+    struct block;
+
+    // size class of the request
+    size_t class_of(size_t N) const;
+    // free list which block of the given size belongs to
+    size_t bin_of(size_t size) const;
+
+    void bin_push(block *b);
+    void bin_remove(block *b);
+
+    block *first_block() const;
+    block *next_block(const block *b) const;
+    block *prev_block(const block *b) const;
+    // Start of the last block, last block could grow so cursors must not point past it
+    char *last_start() const { return _last != nullptr ? reinterpret_cast<char *>(_last) : _base; }
+
+    // Finds block with at least N bytes of payload and assigns descriptor to it, returns nullptr if
+    // there is no such block
+    block *take_block(size_t N, void **d);
+    // Cuts tail of the used block to be a new free block if it is big enough
+    void split_block(block *b, size_t N);
+    // Returns block to the free space merging it with neighbours
+    void release_block(block *b);
+
+    void **take_descriptor();
+    void release_descriptor(void **d);
+
+    // Block referenced by the descriptor, throws InvalidFree if descriptor isn't a live one
+    block *block_of(void **d) const;
+
+    // Wrapped area aligned to the block header alignment
+    char *_base;
     const size_t _base_len;
+    char *_end;
+
+    // End of the last block, everything between _top and _descriptors is unused
+    char *_top;
+
+    // Last block in the area, nullptr if there are no blocks
+    block *_last;
+
+    // Lowest descriptor, table of descriptors grows down from the end of area
+    void **_descriptors;
+
+    // List of released descriptors linked through the descriptors themselves
+    void **_free_descriptors;
+
+    // Payload bytes of all free blocks
+    size_t _holes;
+
+    // There are no free blocks before that address, incremental defrag continues from here
+    char *_compacted;
+
+    // Payload sizes of the size classes
+    std::vector<size_t> _classes;
+
+    // Free blocks of each size class
+    std::vector<block *> _bins;
 };
 
 } // namespace Allocator
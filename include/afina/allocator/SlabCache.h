@@ -0,0 +1,132 @@
+#ifndef AFINA_ALLOCATOR_SLAB_CACHE_H
+#define AFINA_ALLOCATOR_SLAB_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Lock-free cache of slabs
+ * Wraps given memory area, cuts it into slabs of the same size and hands them out to the consumers.
+ * Free slabs are kept in a global depot, lock-free stack with ABA counter, so any number of threads
+ * could take and return slabs concurrently without locking.
+ *
+ * As Simple, cache doesn't take ownership of the wrapped memory.
+ */
+class SlabCache {
+public:
+    SlabCache(void *base, size_t size, size_t slab_size = 64 * 1024);
+
+    /**
+     * Takes one free slab out of the depot. Throws AllocError with NoMemory type if depot is empty
+     */
+    void *alloc();
+
+    /**
+     * Returns slab previously taken by alloc() back to the depot. Throws AllocError with InvalidFree
+     * type if address isn't a slab start of this cache
+     */
+    void free(void *slab);
+
+    /**
+     * Returns true if address belongs to the wrapped area
+     */
+    bool owns(const void *p) const {
+        const char *c = reinterpret_cast<const char *>(p);
+        return c >= _base && c < _base + _slab_size * _slabs_count;
+    }
+
+    inline size_t slab_size() const { return _slab_size; }
+    inline size_t slabs_count() const { return _slabs_count; }
+
+    // Start of the wrapped area
+    inline char *base() const { return _base; }
+
+    // Number of slabs in the depot, approximate if there are concurrent modifications
+    size_t free_slabs() const { return _free_count.load(std::memory_order_relaxed); }
+
+private:
+    SlabCache(const SlabCache &) = delete;
+    SlabCache &operator=(const SlabCache &) = delete;
+
+    char *_base;
+    size_t _slab_size;
+    uint32_t _slabs_count;
+
+    // Top of the free slabs stack: ABA counter in upper half, slab number + 1 in lower, 0 means empty
+    std::atomic<uint64_t> _depot;
+
+    // Stack links, next slab number + 1 for each free slab
+    std::unique_ptr<std::atomic<uint32_t>[]> _next;
+
+    std::atomic<size_t> _free_count;
+};
+
+/**
+ * # Pool of fixed size objects
+ * Carves objects out of slabs taken from SlabCache, like tarantool's mempool on top of slab_cache.
+ *
+ * Each CPU core has its own lock-free free list padded to the cache line: alloc() and free() work with
+ * the list of the core calling thread runs on, so threads on different cores never touch the same
+ * cache line. Once list of the current core is empty, objects are taken from the lists of the other
+ * cores and only then new slab is requested from the cache.
+ *
+ * Slabs are returned to the cache on pool destruction only.
+ */
+class Mempool {
+public:
+    Mempool(SlabCache &cache, size_t object_size);
+    ~Mempool();
+
+    /**
+     * Returns memory for one object. Throws AllocError with NoMemory type if neither pool nor slab
+     * cache have free memory
+     */
+    void *alloc();
+
+    /**
+     * Returns object to the pool, could be called from any thread
+     */
+    void free(void *p);
+
+    inline size_t object_size() const { return _object_size; }
+
+private:
+    Mempool(const Mempool &) = delete;
+    Mempool &operator=(const Mempool &) = delete;
+
+    // Lock-free stack of free objects, takes whole cache line to avoid false sharing
+    struct alignas(64) free_list {
+        std::atomic<uint64_t> head;
+    };
+
+    void push(free_list &list, char *first, char *last);
+    char *pop(free_list &list);
+
+    // Object position in the slab cache area, in 8 bytes units
+    inline uint32_t index_of(const char *p) const { return uint32_t((p - _cache.base()) >> 3); }
+    inline char *object_at(uint32_t index) const { return _cache.base() + (size_t(index) << 3); }
+    inline std::atomic<uint32_t> &link_of(char *p) const { return *reinterpret_cast<std::atomic<uint32_t> *>(p); }
+
+    free_list &current_list();
+
+    SlabCache &_cache;
+    size_t _object_size;
+
+    // Lists live in one block aligned by hand, array new doesn't respect alignas before C++17
+    size_t _lists_count;
+    std::unique_ptr<char[]> _lists_memory;
+    free_list *_lists;
+
+    // Slabs taken from the cache, linked through the slab headers
+    std::atomic<char *> _slabs;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_CACHE_H
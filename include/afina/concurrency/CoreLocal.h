@@ -1,10 +1,72 @@
 #ifndef AFINA_CONCURRENCY_CORE_LOCAL_H
 #define AFINA_CONCURRENCY_CORE_LOCAL_H
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+
+#include <sched.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class CoreLocal {};
+/**
+ * # Copy of the value per CPU core
+ * Local returns the copy of the core the calling thread runs on, sched_getcpu reads it from rseq area or
+ * vDSO without a syscall. Each copy takes its own cache line, so threads on different cores never share
+ * the line, whatever the number of threads is.
+ *
+ * Thread could be moved to another core right after it got the copy, and other thread could get the same
+ * copy meanwhile: updates of T must still be atomic, but they are almost never contended. Readers combine
+ * all the copies with ForEach
+ */
+template <typename T> class CoreLocal {
+public:
+    CoreLocal() : _size(std::max(1u, std::thread::hardware_concurrency())) {
+        // Array new doesn't respect alignas of the slot before C++17
+        _memory.reset(new char[_size * sizeof(slot) + alignof(slot)]);
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(_memory.get()) + alignof(slot) - 1) & ~(alignof(slot) - 1);
+        _slots = reinterpret_cast<slot *>(aligned);
+        for (std::size_t i = 0; i < _size; i++) {
+            new (&_slots[i]) slot();
+        }
+    }
+
+    ~CoreLocal() {
+        for (std::size_t i = 0; i < _size; i++) {
+            _slots[i].~slot();
+        }
+    }
+
+    T &Local() {
+        int cpu = sched_getcpu();
+        return _slots[cpu < 0 ? 0 : std::size_t(cpu) % _size].value;
+    }
+
+    template <typename F> void ForEach(F f) const {
+        for (std::size_t i = 0; i < _size; i++) {
+            f(const_cast<const T &>(_slots[i].value));
+        }
+    }
+
+    std::size_t Size() const { return _size; }
+
+private:
+    // No copy/move/assign allowed
+    CoreLocal(const CoreLocal &);            // = delete;
+    CoreLocal &operator=(const CoreLocal &); // = delete;
+
+    struct alignas(64) slot {
+        T value;
+    };
+
+    const std::size_t _size;
+    std::unique_ptr<char[]> _memory;
+    slot *_slots;
+};
 
 } // namespace Concurrency
 } // namespace Afina
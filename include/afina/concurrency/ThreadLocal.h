@@ -1,10 +1,131 @@
 #ifndef AFINA_CONCURRENCY_THREAD_LOCAL_H
 #define AFINA_CONCURRENCY_THREAD_LOCAL_H
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class ThreadLocal {};
+/**
+ * # Copy of the value per thread
+ * Unlike thread_local variable, every object has its own set of copies, and all of them could be visited
+ * with ForEach. Only the owner thread changes its copy, so plain relaxed load and store are enough for
+ * updates, readers see values of some recent moment.
+ *
+ * Copy of the finished thread isn't destroyed: the next new thread takes it over and goes on from its
+ * value. So counters summed over all copies never go back, and the number of copies is the highest number
+ * of threads used the object at the same time.
+ *
+ * First call of Local in a thread takes the lock, later calls just scan short list of objects the thread
+ * has used.
+ */
+template <typename T> class ThreadLocal {
+public:
+    ThreadLocal() : _registry(std::make_shared<registry>()) {}
+
+    T &Local() {
+        std::vector<entry> &entries = thread_entries().entries;
+        for (entry &e : entries) {
+            if (e.owner.get() == _registry.get()) {
+                return e.taken->value;
+            }
+        }
+        return attach(entries);
+    }
+
+    template <typename F> void ForEach(F f) const {
+        std::lock_guard<std::mutex> lock(_registry->mutex);
+        for (const slot *s : _registry->slots) {
+            f(s->value);
+        }
+    }
+
+    // Number of copies created so far
+    std::size_t Size() const {
+        std::lock_guard<std::mutex> lock(_registry->mutex);
+        return _registry->slots.size();
+    }
+
+private:
+    // No copy/move/assign allowed
+    ThreadLocal(const ThreadLocal &);            // = delete;
+    ThreadLocal &operator=(const ThreadLocal &); // = delete;
+
+    struct alignas(64) slot {
+        T value;
+    };
+
+    // Copies of the object, outlives it while some thread still holds one of them
+    struct registry {
+        std::mutex mutex;
+        // Each copy has its own block, container allocators don't respect alignas of the slot before C++17
+        std::vector<std::unique_ptr<char[]>> memory;
+        std::vector<slot *> slots;
+        std::vector<slot *> free;
+
+        ~registry() {
+            for (slot *s : slots) {
+                s->~slot();
+            }
+        }
+    };
+
+    // Copy taken by the thread
+    struct entry {
+        std::shared_ptr<registry> owner;
+        slot *taken;
+    };
+
+    // Copies taken by the thread, given back once it finishes
+    struct thread_state {
+        std::vector<entry> entries;
+
+        ~thread_state() {
+            for (entry &e : entries) {
+                std::lock_guard<std::mutex> lock(e.owner->mutex);
+                e.owner->free.push_back(e.taken);
+            }
+        }
+    };
+
+    static thread_state &thread_entries() {
+        static thread_local thread_state state;
+        return state;
+    }
+
+    T &attach(std::vector<entry> &entries) {
+        // Objects destroyed meanwhile are referenced only from here, forget them
+        for (std::size_t i = 0; i < entries.size();) {
+            if (entries[i].owner.use_count() == 1) {
+                entries[i] = entries.back();
+                entries.pop_back();
+            } else {
+                i++;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(_registry->mutex);
+        slot *taken;
+        if (_registry->free.empty()) {
+            _registry->memory.emplace_back(new char[sizeof(slot) + alignof(slot)]);
+            uintptr_t block = reinterpret_cast<uintptr_t>(_registry->memory.back().get());
+            taken = new (reinterpret_cast<void *>((block + alignof(slot) - 1) & ~(alignof(slot) - 1))) slot();
+            _registry->slots.push_back(taken);
+        } else {
+            taken = _registry->free.back();
+            _registry->free.pop_back();
+        }
+        entries.push_back(entry{_registry, taken});
+        return taken->value;
+    }
+
+    std::shared_ptr<registry> _registry;
+};
 
 } // namespace Concurrency
 } // namespace Afina
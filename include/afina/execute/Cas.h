@@ -0,0 +1,41 @@
+#ifndef AFINA_EXECUTE_CAS_H
+#define AFINA_EXECUTE_CAS_H
+
+#include <cstdint>
+#include <string>
+
+#include "InsertCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Check and set
+ * Store new value for the key, but only if nobody has updated it since the
+ * client read it with "gets": item version must still be <cas unique>
+ *
+ * Command must write result to the output, which could be:
+ * - "STORED", to indicate success.
+ * - "EXISTS" to indicate that the item has been modified since it was fetched
+ * - "NOT_FOUND" to indicate that the item did not exist or has been deleted
+ * - "NOT_STORED" to indicate the data was not stored, but not because of an
+ * error. For example the new value is too large for the storage.
+ */
+class Cas : public InsertCommand {
+public:
+    Cas(const std::string &key, uint32_t flags, int32_t expire, uint64_t version)
+        : InsertCommand(key, flags, expire), _version(version) {}
+    ~Cas() {}
+
+    inline const uint64_t version() const { return _version; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    const uint64_t _version;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_CAS_H
@@ -1,11 +1,14 @@
 #ifndef AFINA_EXECUTE_COMMAND_H
 #define AFINA_EXECUTE_COMMAND_H
 
+#include <functional>
 #include <string>
+#include <vector>
 
 namespace Afina {
 
 class Storage;
+class ValueView;
 
 namespace Execute {
 
@@ -19,6 +22,20 @@ public:
     virtual ~Command() {}
 
     virtual void Execute(Storage &storage, const std::string &args, std::string &out) = 0;
+
+    /**
+     * Same as Execute, but result is appended to out as a sequence of buffers to be sent one after
+     * another, so values could go to the network right from the storage memory without copies.
+     * Default implementation makes a single buffer of Execute result
+     */
+    virtual void ExecuteViews(Storage &storage, const std::string &args, std::vector<ValueView> &out);
+
+    /**
+     * Gets storage ready to execute the command without waiting for slow reads, see Storage::Prepare.
+     * True means network should call Execute only once ready is called. Default implementation needs
+     * nothing and returns false
+     */
+    virtual bool Prepare(Storage &storage, std::function<void()> ready) { return false; }
 };
 
 } // namespace Execute
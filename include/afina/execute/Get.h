@@ -26,6 +26,10 @@ namespace Execute {
  * Where <key> is the key for the value, <bytes> is the number of bytes in the
  * value and <data> is the value text
  *
+ * "gets" command adds version of the item to each line:
+ * VALUE <key> <flags> <bytes> <cas unique>\r\n
+ * it could be passed to "cas" command later
+ *
  * If some of the keys appearing in a retrieval request are not sent back
  * by the server in the item list this means that the server does not
  * hold items with such keys (because they were never stored, or stored
@@ -34,15 +38,24 @@ namespace Execute {
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    Get(const std::vector<std::string> &keys, bool with_versions = false)
+        : _keys(keys), _with_versions(with_versions) {}
     ~Get() {}
 
     inline const std::vector<std::string> &keys() const { return _keys; }
+    inline bool with_versions() const { return _with_versions; }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
+    // Values are referenced right in the storage memory
+    void ExecuteViews(Storage &storage, const std::string &args, std::vector<ValueView> &out) override;
+
+    // All the keys are prepared at once
+    bool Prepare(Storage &storage, std::function<void()> ready) override;
+
 private:
     std::vector<std::string> _keys;
+    bool _with_versions;
 };
 
 } // namespace Execute
@@ -0,0 +1,45 @@
+#ifndef AFINA_EXECUTE_INCR_H
+#define AFINA_EXECUTE_INCR_H
+
+#include <cstdint>
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Change numeric value of the key
+ * Value of the existing key must be the decimal representation of a 64 bit
+ * unsigned integer. "incr" adds <value> to it and wraps around on overflow,
+ * "decr" subtracts <value> and stops at zero
+ *
+ * Command must write result to the output, which could be:
+ * - the new value of the item, to indicate success
+ * - "NOT_FOUND" to indicate the item with this key was not found
+ * - "CLIENT_ERROR cannot increment or decrement non-numeric value" if the
+ * value of the item isn't a number
+ */
+class Incr : public Command {
+public:
+    Incr(const std::string &key, uint64_t delta, bool decrement = false)
+        : _key(key), _delta(delta), _decrement(decrement) {}
+    ~Incr() {}
+
+    inline const std::string &key() const { return _key; }
+    inline uint64_t delta() const { return _delta; }
+    inline bool decrement() const { return _decrement; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _key;
+    uint64_t _delta;
+    bool _decrement;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_INCR_H
@@ -22,6 +22,13 @@ public:
     inline const uint32_t flags() const { return _flags; }
     inline const int32_t expire() const { return _expire; }
 
+    /**
+     * Converts memcached expiration time into the number of seconds item lives: zero means forever,
+     * values up to 30 days are offsets from now, bigger ones are unix timestamps. Returns false if item
+     * is expired already, negative expiration time means that.
+     */
+    bool ttl(uint32_t &seconds) const;
+
 protected:
     const std::string _key;
     const uint32_t _flags;
@@ -2,17 +2,46 @@
 #define AFINA_EXECUTE_STATS_H
 
 #include <string>
+#include <vector>
 
 #include "Command.h"
 
 namespace Afina {
+
+class Metrics;
+
 namespace Execute {
 
+/**
+ * # Server statistics
+ * Reports the metrics registry as memcached does, one line per value and END after all of them:
+ * STAT <name> <value>\r\n
+ * ...
+ * END
+ *
+ * Without arguments reports general server and storage numbers. Arguments pick other groups:
+ * - items: items and evictions of the storage
+ * - slabs: slab caches of the server
+ * - conns: open client connections, lines are prefixed with the socket number
+ * - commands: number of commands of each type
+ * - latency: count, mean, percentiles and max of the time commands took, in nanoseconds
+ * - any group some part of the server registered a report for, see Metrics::AddReport
+ *
+ * Unknown group is an error. Without registry there is nothing to report but END
+ */
 class Stats : public Command {
 public:
-    Stats() {}
+    Stats(Metrics *metrics = nullptr, const std::vector<std::string> &args = std::vector<std::string>())
+        : _metrics(metrics), _args(args) {}
     ~Stats() {}
+
+    const std::vector<std::string> &args() const { return _args; }
+
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    Metrics *_metrics;
+    std::vector<std::string> _args;
 };
 
 } // namespace Execute
@@ -5,6 +5,7 @@
 #include <vector>
 
 namespace Afina {
+class Metrics;
 class Storage;
 namespace Logging {
 class Service;
@@ -17,8 +18,9 @@ namespace Network {
  */
 class Server {
 public:
-    Server(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-        : pStorage(ps), pLogging(pl) {}
+    Server(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           std::shared_ptr<Afina::Metrics> pm)
+        : pStorage(ps), pLogging(pl), pMetrics(pm) {}
     virtual ~Server() {}
 
     /**
@@ -55,6 +57,11 @@ protected:
      * Logging service to be used in order to report application progress
      */
     std::shared_ptr<Afina::Logging::Service> pLogging;
+
+    /**
+     * Registry to report connections, traffic and commands to, see Metrics.h
+     */
+    std::shared_ptr<Afina::Metrics> pMetrics;
 };
 
 } // namespace Network
@@ -1,40 +1,479 @@
 #include <afina/allocator/Simple.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
-
-/**
- * TODO: semantics
- * @param N size_t
- */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
-
-/**
- * TODO: semantics
- * @param p Pointer
- * @param N size_t
- */
-void Simple::realloc(Pointer &p, size_t N) {}
-
-/**
- * TODO: semantics
- * @param p Pointer
- */
-void Simple::free(Pointer &p) {}
-
-/**
- * TODO: semantics
- */
-void Simple::defrag() {}
-
-/**
- * TODO: semantics
- */
-std::string Simple::dump() const { return ""; }
+namespace {
+
+// Alignment of the block headers and payloads
+const size_t kAlign = sizeof(void *);
+
+// Smallest payload, free block keeps its free list links in there
+const size_t kMinPayload = 2 * sizeof(void *);
+
+inline size_t align_up(size_t n) { return (n + kAlign - 1) & ~(kAlign - 1); }
+
+} // namespace
+
+struct Simple::block {
+    // Number of payload bytes
+    size_t size;
+    // Number of payload bytes in the previous block, 0 for the first one
+    size_t prev_size;
+    // Descriptor which points to this block, nullptr for free blocks
+    void **descriptor;
+
+    char *payload() { return reinterpret_cast<char *>(this + 1); }
+    char *end() { return payload() + size; }
+
+    // Links in the free list, valid for free blocks only
+    block *&bin_prev() { return reinterpret_cast<block **>(payload())[0]; }
+    block *&bin_next() { return reinterpret_cast<block **>(payload())[1]; }
+
+    static block *of(void *payload) { return reinterpret_cast<block *>(payload) - 1; }
+};
+
+Simple::Simple(void *base, size_t size) : _base_len(size) {
+    uintptr_t begin = reinterpret_cast<uintptr_t>(base);
+    uintptr_t end = (begin + size) & ~uintptr_t(kAlign - 1);
+    begin = (begin + kAlign - 1) & ~uintptr_t(kAlign - 1);
+    if (end < begin) {
+        end = begin;
+    }
+
+    _base = reinterpret_cast<char *>(begin);
+    _end = reinterpret_cast<char *>(end);
+    _top = _base;
+    _last = nullptr;
+    _descriptors = reinterpret_cast<void **>(_end);
+    _free_descriptors = nullptr;
+    _holes = 0;
+    _compacted = _base;
+
+    // Classes are spaced by 1.25 factor, smallest one is big enough to keep free list links
+    for (size_t c = kMinPayload; c <= size; c = std::max(c + kAlign, align_up(c + c / 4))) {
+        _classes.push_back(c);
+    }
+    _bins.assign(_classes.size(), nullptr);
+}
+
+// See Simple.h
+size_t Simple::class_of(size_t N) const {
+    auto it = std::lower_bound(_classes.begin(), _classes.end(), N);
+    if (it == _classes.end()) {
+        throw AllocError(AllocErrorType::NoMemory, "Requested block is larger than allocator area");
+    }
+    return it - _classes.begin();
+}
+
+// See Simple.h
+bool Simple::fits(size_t N) const {
+    return !_classes.empty() && N <= _classes.back() && footprint(N) <= size_t(_end - _base);
+}
+
+// See Simple.h
+size_t Simple::footprint(size_t N) {
+    // Same classes as the constructor makes
+    size_t c = kMinPayload;
+    while (c < N) {
+        c = std::max(c + kAlign, align_up(c + c / 4));
+    }
+    return sizeof(block) + c + sizeof(void *);
+}
+
+// See Simple.h
+size_t Simple::bin_of(size_t size) const {
+    auto it = std::upper_bound(_classes.begin(), _classes.end(), size);
+    return (it - _classes.begin()) - 1;
+}
+
+// See Simple.h
+void Simple::bin_push(block *b) {
+    _holes += b->size;
+    if (reinterpret_cast<char *>(b) < _compacted) {
+        _compacted = reinterpret_cast<char *>(b);
+    }
+
+    block *&head = _bins[bin_of(b->size)];
+    b->bin_prev() = nullptr;
+    b->bin_next() = head;
+    if (head != nullptr) {
+        head->bin_prev() = b;
+    }
+    head = b;
+}
+
+// See Simple.h
+void Simple::bin_remove(block *b) {
+    _holes -= b->size;
+    if (reinterpret_cast<char *>(b) == _compacted) {
+        // Block could be merged into the previous one, keep cursor on the block boundary
+        block *prev = prev_block(b);
+        _compacted = reinterpret_cast<char *>(prev != nullptr ? prev : b);
+    }
+    if (b->bin_prev() == nullptr) {
+        _bins[bin_of(b->size)] = b->bin_next();
+    } else {
+        b->bin_prev()->bin_next() = b->bin_next();
+    }
+    if (b->bin_next() != nullptr) {
+        b->bin_next()->bin_prev() = b->bin_prev();
+    }
+}
+
+// See Simple.h
+Simple::block *Simple::first_block() const { return _last == nullptr ? nullptr : reinterpret_cast<block *>(_base); }
+
+// See Simple.h
+Simple::block *Simple::next_block(const block *b) const {
+    if (b == _last) {
+        return nullptr;
+    }
+    return reinterpret_cast<block *>(const_cast<block *>(b)->end());
+}
+
+// See Simple.h
+Simple::block *Simple::prev_block(const block *b) const {
+    if (reinterpret_cast<const char *>(b) == _base) {
+        return nullptr;
+    }
+    return reinterpret_cast<block *>(reinterpret_cast<char *>(const_cast<block *>(b)) - b->prev_size) - 1;
+}
+
+// See Simple.h
+Simple::block *Simple::take_block(size_t N, void **d) {
+    size_t cls = class_of(N);
+    size_t size = _classes[cls];
+
+    // Free block of the same class, all of them are big enough
+    block *b = _bins[cls];
+    if (b != nullptr) {
+        bin_remove(b);
+        b->descriptor = d;
+        split_block(b, size);
+        return b;
+    }
+
+    // Unused tail of the area
+    if (_top + sizeof(block) + size <= reinterpret_cast<char *>(_descriptors)) {
+        b = reinterpret_cast<block *>(_top);
+        b->size = size;
+        b->prev_size = (_last == nullptr) ? 0 : _last->size;
+        b->descriptor = d;
+        _last = b;
+        _top = b->end();
+        return b;
+    }
+
+    // Split one of the bigger free blocks
+    for (size_t i = cls + 1; i < _bins.size(); i++) {
+        b = _bins[i];
+        if (b != nullptr) {
+            bin_remove(b);
+            b->descriptor = d;
+            split_block(b, size);
+            return b;
+        }
+    }
+
+    return nullptr;
+}
+
+// See Simple.h
+void Simple::split_block(block *b, size_t N) {
+    if (b->size < N + sizeof(block) + kMinPayload) {
+        return;
+    }
+
+    block *rest = reinterpret_cast<block *>(b->payload() + N);
+    rest->size = b->size - N - sizeof(block);
+    rest->prev_size = N;
+    rest->descriptor = nullptr;
+
+    b->size = N;
+    if (b == _last) {
+        _last = rest;
+    } else {
+        next_block(rest)->prev_size = rest->size;
+    }
+
+    release_block(rest);
+}
+
+// See Simple.h
+void Simple::release_block(block *b) {
+    b->descriptor = nullptr;
+
+    block *next = next_block(b);
+    if (next != nullptr && next->descriptor == nullptr) {
+        bin_remove(next);
+        b->size += sizeof(block) + next->size;
+        if (next == _last) {
+            _last = b;
+        } else {
+            next_block(b)->prev_size = b->size;
+        }
+    }
+
+    block *prev = prev_block(b);
+    if (prev != nullptr && prev->descriptor == nullptr) {
+        bin_remove(prev);
+        prev->size += sizeof(block) + b->size;
+        if (b == _last) {
+            _last = prev;
+        } else {
+            next_block(prev)->prev_size = prev->size;
+        }
+        b = prev;
+    }
+
+    if (b == _last) {
+        // Free block at the end goes back to the unused tail
+        _top = reinterpret_cast<char *>(b);
+        _last = prev_block(b);
+        _compacted = std::min(_compacted, last_start());
+        return;
+    }
+
+    bin_push(b);
+}
+
+// See Simple.h
+void **Simple::take_descriptor() {
+    if (_free_descriptors != nullptr) {
+        void **d = _free_descriptors;
+        _free_descriptors = reinterpret_cast<void **>(*d);
+        return d;
+    }
+
+    if (reinterpret_cast<char *>(_descriptors - 1) < _top) {
+        return nullptr;
+    }
+    return --_descriptors;
+}
+
+// See Simple.h
+void Simple::release_descriptor(void **d) {
+    *d = _free_descriptors;
+    _free_descriptors = d;
+}
+
+// See Simple.h
+Simple::block *Simple::block_of(void **d) const {
+    if (d < _descriptors || reinterpret_cast<char *>(d) >= _end) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't belong to the allocator");
+    }
+
+    // Released descriptors point into the descriptors table or nowhere
+    char *payload = reinterpret_cast<char *>(*d);
+    if (payload < _base + sizeof(block) || payload >= _top) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer has been released already");
+    }
+
+    block *b = block::of(payload);
+    if (b->descriptor != d) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer has been released already");
+    }
+    return b;
+}
+
+// See Simple.h
+Pointer Simple::alloc(size_t N) {
+    void **d = take_descriptor();
+    if (d == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No space for block descriptor");
+    }
+
+    block *b = take_block(N, d);
+    if (b == nullptr) {
+        release_descriptor(d);
+        throw AllocError(AllocErrorType::NoMemory, "No free block of requested size");
+    }
+
+    *d = b->payload();
+    return Pointer(d);
+}
+
+// See Simple.h
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p._descriptor == nullptr) {
+        p = alloc(N);
+        return;
+    }
+
+    void **d = p._descriptor;
+    block *b = block_of(d);
+    size_t size = _classes[class_of(N)];
+
+    // Shrink, tail of the block is released
+    if (size <= b->size) {
+        split_block(b, size);
+        return;
+    }
+
+    // Grow into the unused tail of the area
+    if (b == _last) {
+        if (b->payload() + size <= reinterpret_cast<char *>(_descriptors)) {
+            b->size = size;
+            _top = b->end();
+            return;
+        }
+    } else {
+        // Grow into the following free block
+        block *next = next_block(b);
+        if (next->descriptor == nullptr && b->size + sizeof(block) + next->size >= size) {
+            bin_remove(next);
+            b->size += sizeof(block) + next->size;
+            if (next == _last) {
+                _last = b;
+            } else {
+                next_block(b)->prev_size = b->size;
+            }
+            split_block(b, size);
+            return;
+        }
+    }
+
+    // Move to the new place
+    block *moved = take_block(size, d);
+    if (moved == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No free block of requested size");
+    }
+
+    std::memcpy(moved->payload(), b->payload(), b->size);
+    *d = moved->payload();
+    release_block(b);
+}
+
+// See Simple.h
+void Simple::free(Pointer &p) {
+    if (p._descriptor == nullptr) {
+        return;
+    }
+
+    block *b = block_of(p._descriptor);
+    release_block(b);
+    release_descriptor(p._descriptor);
+    p._descriptor = nullptr;
+}
+
+// See Simple.h
+void Simple::defrag() {
+    char *cursor = _base;
+    block *last = nullptr;
+
+    for (block *b = first_block(); b != nullptr;) {
+        // next must be found before the block gets moved
+        block *next = next_block(b);
+        if (b->descriptor != nullptr) {
+            block *to = reinterpret_cast<block *>(cursor);
+            if (to != b) {
+                std::memmove(to, b, sizeof(block) + b->size);
+            }
+            to->prev_size = (last == nullptr) ? 0 : last->size;
+            *to->descriptor = to->payload();
+
+            last = to;
+            cursor = to->end();
+        }
+        b = next;
+    }
+
+    _top = cursor;
+    _last = last;
+    _holes = 0;
+    _compacted = last_start();
+    std::fill(_bins.begin(), _bins.end(), nullptr);
+}
+
+// See Simple.h
+bool Simple::defrag_step(size_t max_moves) {
+    for (size_t moves = 0; moves < max_moves; moves++) {
+        if (_holes == 0) {
+            _compacted = last_start();
+            return true;
+        }
+
+        // First hole, everything before it is compacted already
+        block *hole = reinterpret_cast<block *>(_compacted);
+        while (hole->descriptor != nullptr) {
+            hole = next_block(hole);
+        }
+        _compacted = reinterpret_cast<char *>(hole);
+
+        // Holes are always merged, so the next block is allocated one: swap them
+        block *b = next_block(hole);
+        bin_remove(hole);
+
+        size_t hole_size = hole->size;
+        size_t prev_size = hole->prev_size;
+        bool was_last = (b == _last);
+
+        block *moved = hole;
+        std::memmove(moved, b, sizeof(block) + b->size);
+        moved->prev_size = prev_size;
+        *moved->descriptor = moved->payload();
+
+        block *rest = reinterpret_cast<block *>(moved->end());
+        rest->size = hole_size;
+        rest->prev_size = moved->size;
+        rest->descriptor = nullptr;
+        if (was_last) {
+            _last = rest;
+        } else {
+            next_block(rest)->prev_size = rest->size;
+        }
+
+        // Hole gets merged with the next one or goes back to unused tail
+        _compacted = reinterpret_cast<char *>(rest);
+        release_block(rest);
+    }
+    return _holes == 0;
+}
+
+// See Simple.h
+std::string Simple::dump() const {
+    size_t used_blocks = 0, used_bytes = 0, free_blocks = 0, free_bytes = 0;
+    for (block *b = first_block(); b != nullptr; b = next_block(b)) {
+        if (b->descriptor != nullptr) {
+            used_blocks++;
+            used_bytes += b->size;
+        } else {
+            free_blocks++;
+            free_bytes += b->size;
+        }
+    }
+
+    std::stringstream out;
+    out << "area " << static_cast<void *>(_base) << " size " << _base_len << ": " << used_blocks << " used blocks ("
+        << used_bytes << " bytes), " << free_blocks << " free blocks (" << free_bytes << " bytes), "
+        << (reinterpret_cast<char *>(_descriptors) - _top) << " bytes unused, "
+        << (reinterpret_cast<void **>(_end) - _descriptors) << " descriptors\n";
+
+    for (size_t i = 0; i < _bins.size(); i++) {
+        size_t count = 0;
+        for (block *b = _bins[i]; b != nullptr; b = b->bin_next()) {
+            count++;
+        }
+        if (count > 0) {
+            out << "class " << _classes[i] << ": " << count << " free\n";
+        }
+    }
+
+    for (block *b = first_block(); b != nullptr; b = next_block(b)) {
+        out << "+" << (reinterpret_cast<char *>(b) - _base) << " " << b->size << " "
+            << (b->descriptor != nullptr ? "used" : "free") << "\n";
+    }
+    return out.str();
+}
 
 } // namespace Allocator
 } // namespace Afina
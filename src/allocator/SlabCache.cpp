@@ -0,0 +1,178 @@
+#include <afina/allocator/SlabCache.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <sched.h>
+#include <stdexcept>
+#include <thread>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+namespace {
+
+// Each slab given to the pool starts with link to the next slab of the same pool
+const size_t kSlabHeader = 16;
+
+inline uint64_t make_head(uint64_t tag, uint32_t index) { return (tag << 32) | index; }
+inline uint32_t head_index(uint64_t head) { return uint32_t(head); }
+inline uint64_t head_tag(uint64_t head) { return head >> 32; }
+
+} // namespace
+
+SlabCache::SlabCache(void *base, size_t size, size_t slab_size)
+    : _base(reinterpret_cast<char *>(base)), _slab_size(slab_size), _depot(0), _free_count(0) {
+    if (slab_size < 2 * kSlabHeader || size / slab_size > UINT32_MAX - 1) {
+        throw std::runtime_error("Invalid slab size");
+    }
+
+    _slabs_count = size / slab_size;
+    _next.reset(new std::atomic<uint32_t>[_slabs_count]);
+
+    // Slabs are given out in address order: slab i links to i + 1
+    for (uint32_t i = 0; i < _slabs_count; i++) {
+        _next[i].store(i + 2 <= _slabs_count ? i + 2 : 0, std::memory_order_relaxed);
+    }
+    _depot.store(make_head(0, _slabs_count > 0 ? 1 : 0), std::memory_order_release);
+    _free_count.store(_slabs_count, std::memory_order_relaxed);
+}
+
+// See SlabCache.h
+void *SlabCache::alloc() {
+    uint64_t head = _depot.load(std::memory_order_acquire);
+    while (head_index(head) != 0) {
+        uint32_t slab = head_index(head) - 1;
+        uint64_t next = make_head(head_tag(head) + 1, _next[slab].load(std::memory_order_relaxed));
+        if (_depot.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            _free_count.fetch_sub(1, std::memory_order_relaxed);
+            return _base + size_t(slab) * _slab_size;
+        }
+    }
+    throw AllocError(AllocErrorType::NoMemory, "Slab cache is exhausted");
+}
+
+// See SlabCache.h
+void SlabCache::free(void *p) {
+    char *c = reinterpret_cast<char *>(p);
+    if (!owns(c) || (c - _base) % _slab_size != 0) {
+        throw AllocError(AllocErrorType::InvalidFree, "Address isn't a slab of this cache");
+    }
+
+    uint32_t slab = (c - _base) / _slab_size;
+    uint64_t head = _depot.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        _next[slab].store(head_index(head), std::memory_order_relaxed);
+        next = make_head(head_tag(head) + 1, slab + 1);
+    } while (!_depot.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+    _free_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+Mempool::Mempool(SlabCache &cache, size_t object_size) : _cache(cache), _slabs(nullptr) {
+    // Free object keeps link to the next one in its first bytes
+    _object_size = (std::max(object_size, sizeof(uint32_t)) + 7) & ~size_t(7);
+    if (_object_size + kSlabHeader > _cache.slab_size()) {
+        throw std::runtime_error("Object doesn't fit into slab");
+    }
+    if (_cache.slab_size() * _cache.slabs_count() / 8 > UINT32_MAX) {
+        throw std::runtime_error("Slab cache area is too big for the pool");
+    }
+
+    _lists_count = std::max(1u, std::thread::hardware_concurrency());
+    _lists_memory.reset(new char[_lists_count * sizeof(free_list) + alignof(free_list)]);
+    uintptr_t aligned =
+        (reinterpret_cast<uintptr_t>(_lists_memory.get()) + alignof(free_list) - 1) & ~(alignof(free_list) - 1);
+    _lists = reinterpret_cast<free_list *>(aligned);
+    for (size_t i = 0; i < _lists_count; i++) {
+        new (&_lists[i]) free_list();
+        _lists[i].head.store(0, std::memory_order_relaxed);
+    }
+}
+
+Mempool::~Mempool() {
+    char *slab = _slabs.load(std::memory_order_acquire);
+    while (slab != nullptr) {
+        char *next = *reinterpret_cast<char **>(slab);
+        _cache.free(slab);
+        slab = next;
+    }
+}
+
+// See SlabCache.h
+Mempool::free_list &Mempool::current_list() {
+    int cpu = sched_getcpu();
+    return _lists[cpu < 0 ? 0 : size_t(cpu) % _lists_count];
+}
+
+// See SlabCache.h
+void Mempool::push(free_list &list, char *first, char *last) {
+    uint64_t head = list.head.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        link_of(last).store(head_index(head), std::memory_order_relaxed);
+        next = make_head(head_tag(head) + 1, index_of(first));
+    } while (!list.head.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// See SlabCache.h
+char *Mempool::pop(free_list &list) {
+    uint64_t head = list.head.load(std::memory_order_acquire);
+    while (head_index(head) != 0) {
+        char *obj = object_at(head_index(head));
+        // Object could be taken and overwritten by the other thread right now, but then tag has been
+        // changed as well and CAS below fails
+        uint64_t next = make_head(head_tag(head) + 1, link_of(obj).load(std::memory_order_relaxed));
+        if (list.head.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return obj;
+        }
+    }
+    return nullptr;
+}
+
+// See SlabCache.h
+void *Mempool::alloc() {
+    free_list &own = current_list();
+    char *obj = pop(own);
+    if (obj != nullptr) {
+        return obj;
+    }
+
+    // Objects freed on the other cores
+    for (size_t i = 0; i < _lists_count; i++) {
+        if (&_lists[i] != &own && (obj = pop(_lists[i])) != nullptr) {
+            return obj;
+        }
+    }
+
+    // New slab: first object goes to the caller, others to the list of the current core
+    char *slab = reinterpret_cast<char *>(_cache.alloc());
+    char *head = _slabs.load(std::memory_order_relaxed);
+    do {
+        *reinterpret_cast<char **>(slab) = head;
+    } while (!_slabs.compare_exchange_weak(head, slab, std::memory_order_release, std::memory_order_relaxed));
+
+    size_t count = (_cache.slab_size() - kSlabHeader) / _object_size;
+    char *first = slab + kSlabHeader;
+    if (count > 1) {
+        char *last = first + (count - 1) * _object_size;
+        for (char *p = first + _object_size; p < last; p += _object_size) {
+            new (p) std::atomic<uint32_t>(index_of(p + _object_size));
+        }
+        new (last) std::atomic<uint32_t>(0);
+        push(own, first + _object_size, last);
+    }
+    return first;
+}
+
+// See SlabCache.h
+void Mempool::free(void *p) {
+    char *obj = reinterpret_cast<char *>(p);
+    new (obj) std::atomic<uint32_t>(0);
+    push(current_list(), obj, obj);
+}
+
+} // namespace Allocator
+} // namespace Afina
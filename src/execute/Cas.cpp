@@ -0,0 +1,30 @@
+#include <afina/Storage.h>
+#include <afina/execute/Cas.h>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "cas" is a check and set operation which means "store this data but
+// only if no one else has updated since I last fetched it."
+void Cas::Execute(Storage &storage, const std::string &args, std::string &out) {
+    uint32_t seconds;
+    bool expired = !ttl(seconds);
+
+    uint64_t version = _version;
+    if (storage.CompareAndSet(_key, args, seconds, version)) {
+        if (expired) {
+            // Item expires right away, the new value must not be seen
+            storage.Delete(_key);
+        }
+        out = "STORED";
+    } else if (version == 0) {
+        out = "NOT_FOUND";
+    } else if (version != _version) {
+        out = "EXISTS";
+    } else {
+        out = "NOT_STORED";
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -1 +1,15 @@
 #include <afina/execute/Command.h>
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Execute {
+
+// See Command.h
+void Command::ExecuteViews(Storage &storage, const std::string &args, std::vector<ValueView> &out) {
+    std::string result;
+    Execute(storage, args, result);
+    out.emplace_back(std::move(result));
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <iterator>
 #include <sstream>
+#include <vector>
 
 namespace Afina {
 namespace Execute {
@@ -22,23 +23,64 @@ to indicate the end of response.
 */
 
 void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::vector<ValueView> views;
+    ExecuteViews(storage, args, views);
+
+    std::size_t size = 0;
+    for (auto &view : views) {
+        size += view.size();
+    }
+    out.clear();
+    out.reserve(size);
+    for (auto &view : views) {
+        out.append(view.data(), view.size());
+    }
+}
+
+void Get::ExecuteViews(Storage &storage, const std::string &args, std::vector<ValueView> &out) {
     std::stringstream keyStream;
     copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
     std::cout << "Get(" << keyStream.str() << ")" << std::endl;
 
+    // Text between values is collected here and goes out as one buffer
     std::stringstream outStream;
 
-    std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+    std::vector<ValueView> values;
+    std::vector<uint64_t> versions;
+    if (_with_versions) {
+        // Versions are rare, values are copied
+        values.resize(_keys.size());
+        versions.resize(_keys.size());
+        std::string copy;
+        for (std::size_t i = 0; i < _keys.size(); i++) {
+            if (storage.GetWithVersion(_keys[i], copy, versions[i])) {
+                values[i] = ValueView(std::move(copy));
+            }
+        }
+    } else {
+        // Whole batch at once, storage may group keys and lock each part once
+        storage.MultiGet(_keys, values);
+    }
+
+    for (std::size_t i = 0; i < _keys.size(); i++) {
+        if (!values[i].valid())
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+        outStream << "VALUE " << _keys[i] << " 0 " << values[i].size();
+        if (_with_versions) {
+            outStream << " " << versions[i];
+        }
+        outStream << "\r\n";
+        out.emplace_back(outStream.str());
+        out.push_back(std::move(values[i]));
+        outStream.str("");
+        outStream << "\r\n";
     }
     outStream << "END"; // networking layer should add the last \r\n
 
-    out = outStream.str();
+    out.emplace_back(outStream.str());
 }
 
+bool Get::Prepare(Storage &storage, std::function<void()> ready) { return storage.Prepare(_keys, std::move(ready)); }
+
 } // namespace Execute
 } // namespace Afina
@@ -0,0 +1,22 @@
+#include <afina/Storage.h>
+#include <afina/execute/Incr.h>
+
+#include <stdexcept>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "incr" and "decr" change the number stored for an existing key in one step,
+// without get and set round trips
+void Incr::Execute(Storage &storage, const std::string &args, std::string &out) {
+    uint64_t number;
+    try {
+        bool found = _decrement ? storage.Decrement(_key, _delta, number) : storage.Increment(_key, _delta, number);
+        out = found ? std::to_string(number) : "NOT_FOUND";
+    } catch (std::invalid_argument &) {
+        out = "CLIENT_ERROR cannot increment or decrement non-numeric value";
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,32 @@
+#include <afina/execute/InsertCommand.h>
+
+#include <ctime>
+
+namespace Afina {
+namespace Execute {
+
+// Bigger expiration times are absolute
+static const int32_t kMaxRelativeExpire = 60 * 60 * 24 * 30;
+
+// See InsertCommand.h
+bool InsertCommand::ttl(uint32_t &seconds) const {
+    seconds = 0;
+    if (_expire == 0) {
+        return true;
+    } else if (_expire < 0) {
+        return false;
+    } else if (_expire <= kMaxRelativeExpire) {
+        seconds = _expire;
+        return true;
+    }
+
+    int64_t left = int64_t(_expire) - std::time(nullptr);
+    if (left <= 0) {
+        return false;
+    }
+    seconds = left;
+    return true;
+}
+
+} // namespace Execute
+} // namespace Afina
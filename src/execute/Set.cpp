@@ -9,8 +9,14 @@ namespace Execute {
 // memcached protocol: "set" means "store this data".
 void Set::Execute(Storage &storage, const std::string &args, std::string &out) {
     std::cout << "Set(" << _key << "): " << args << std::endl;
-    storage.Put(_key, args);
-    out = "STORED";
+    uint32_t seconds;
+    if (!ttl(seconds)) {
+        // Item expires right away, the old value must not be seen either
+        storage.Delete(_key);
+        out = "STORED";
+        return;
+    }
+    out = storage.PutWithTTL(_key, args, seconds) ? "STORED" : "NOT_STORED";
 }
 
 } // namespace Execute
@@ -1,14 +1,161 @@
+#include <afina/Metrics.h>
 #include <afina/Storage.h>
 #include <afina/execute/Stats.h>
 
-#include <iostream>
+#include <cstdio>
+#include <ctime>
 #include <iterator>
 #include <sstream>
 
+#include <sys/resource.h>
+#include <unistd.h>
+
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+namespace {
+
+// Seconds with microseconds, as memcached prints rusage
+std::string seconds(const struct timeval &tv) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%ld.%06ld", long(tv.tv_sec), long(tv.tv_usec));
+    return buffer;
+}
+
+// Resident set size of the process in bytes
+int64_t resident_bytes() {
+    long pages = 0, resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm != nullptr) {
+        if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(statm);
+    }
+    return int64_t(resident) * sysconf(_SC_PAGESIZE);
+}
+
+void general(const Metrics &metrics, Metrics::Lines &out) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    const StorageCounters &storage = metrics.Storage();
+
+    out.emplace_back("pid", std::to_string(getpid()));
+    out.emplace_back("uptime", std::to_string(metrics.Uptime()));
+    out.emplace_back("time", std::to_string(time(nullptr)));
+    out.emplace_back("pointer_size", std::to_string(8 * sizeof(void *)));
+    out.emplace_back("rusage_user", seconds(usage.ru_utime));
+    out.emplace_back("rusage_system", seconds(usage.ru_stime));
+    out.emplace_back("rss", std::to_string(resident_bytes()));
+    out.emplace_back("curr_connections", std::to_string(metrics.Total(Metrics::kCurrentConnections)));
+    out.emplace_back("total_connections", std::to_string(metrics.Total(Metrics::kTotalConnections)));
+    out.emplace_back("cmd_get", std::to_string(storage.Total(StorageCounters::kGets)));
+    out.emplace_back("cmd_set", std::to_string(storage.Total(StorageCounters::kSets)));
+    out.emplace_back("get_hits", std::to_string(storage.Total(StorageCounters::kHits)));
+    out.emplace_back("get_misses", std::to_string(storage.Total(StorageCounters::kMisses)));
+    out.emplace_back("get_bytes", std::to_string(storage.Total(StorageCounters::kBytesOut)));
+    out.emplace_back("set_bytes", std::to_string(storage.Total(StorageCounters::kBytesIn)));
+    out.emplace_back("bytes_read", std::to_string(metrics.Total(Metrics::kBytesRead)));
+    out.emplace_back("bytes_written", std::to_string(metrics.Total(Metrics::kBytesWritten)));
+    out.emplace_back("limit_maxbytes", std::to_string(metrics.MaxBytes()));
+    out.emplace_back("curr_items", std::to_string(storage.Total(StorageCounters::kItems)));
+    out.emplace_back("bytes", std::to_string(storage.Total(StorageCounters::kBytes)));
+    out.emplace_back("evictions", std::to_string(storage.Total(StorageCounters::kEvictions)));
+}
+
+// Storage has no slab classes, all the items are reported as the class 1
+void items(const Metrics &metrics, Metrics::Lines &out) {
+    const StorageCounters &storage = metrics.Storage();
+    out.emplace_back("items:1:number", std::to_string(storage.Total(StorageCounters::kItems)));
+    out.emplace_back("items:1:evicted", std::to_string(storage.Total(StorageCounters::kEvictions)));
+}
+
+void conns(const Metrics &metrics, Metrics::Lines &out) {
+    auto now = std::chrono::steady_clock::now();
+    for (auto &connection : metrics.Connections()) {
+        std::string prefix = std::to_string(connection.first) + ":";
+        auto age = std::chrono::duration_cast<std::chrono::seconds>(now - connection.second.since).count();
+        out.emplace_back(prefix + "addr", connection.second.address);
+        out.emplace_back(prefix + "secs_since_connect", std::to_string(age));
+    }
+}
+
+void commands(const Metrics &metrics, Metrics::Lines &out) {
+    for (int i = 0; i < Metrics::kCommands; i++) {
+        out.emplace_back(Metrics::CommandName(Metrics::Command(i)), std::to_string(metrics.Total(Metrics::Command(i))));
+    }
+}
+
+// Count, mean, percentiles and max of the histogram, in nanoseconds
+void histogram_lines(const std::string &prefix, const LatencyHistogram &histogram, Metrics::Lines &out) {
+    static const std::pair<const char *, double> percentiles[] = {
+        {"p50", 50}, {"p90", 90}, {"p99", 99}, {"p999", 99.9}};
+
+    out.emplace_back(prefix + "count", std::to_string(histogram.Count()));
+    out.emplace_back(prefix + "mean_ns", std::to_string(histogram.Mean()));
+    for (auto &percentile : percentiles) {
+        uint64_t value = histogram.Percentile(percentile.second);
+        out.emplace_back(prefix + percentile.first + "_ns", std::to_string(value));
+    }
+    out.emplace_back(prefix + "max_ns", std::to_string(histogram.Max()));
+}
+
+// Stages of commands which have been executed, <cmd>:<stage>: over all workers, then <worker>:<cmd>:<stage>:
+// for each worker. Stages of commands executed by nobody, or by some other worker, are skipped
+void latency(const Metrics &metrics, Metrics::Lines &out) {
+    std::size_t workers = metrics.Workers();
+    for (std::size_t worker = 0; worker <= workers; worker++) {
+        std::string prefix = worker == 0 ? "" : std::to_string(worker - 1) + ":";
+        for (int i = 0; i < Metrics::kCommands; i++) {
+            for (int s = 0; s < Metrics::kStages; s++) {
+                Metrics::Command command = Metrics::Command(i);
+                Metrics::Stage stage = Metrics::Stage(s);
+                LatencyHistogram histogram;
+                if (worker == 0) {
+                    metrics.Latency(command, stage, histogram);
+                } else {
+                    metrics.WorkerLatency(worker - 1, command, stage, histogram);
+                }
+                if (histogram.Count() > 0) {
+                    histogram_lines(prefix + Metrics::CommandName(command) + ":" + Metrics::StageName(stage) + ":",
+                                    histogram, out);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    out.clear();
+    if (_metrics == nullptr) {
+        out.assign("END");
+        return;
+    }
+
+    Metrics::Lines lines;
+    std::string group = _args.empty() ? "" : _args[0];
+    if (group.empty()) {
+        general(*_metrics, lines);
+    } else if (group == "items") {
+        items(*_metrics, lines);
+    } else if (group == "conns") {
+        conns(*_metrics, lines);
+    } else if (group == "commands") {
+        commands(*_metrics, lines);
+    } else if (group == "latency") {
+        latency(*_metrics, lines);
+    } else if (!_metrics->Reports(group, lines)) {
+        out.assign("CLIENT_ERROR unknown stats group");
+        return;
+    }
+
+    for (auto &line : lines) {
+        out.append("STAT ").append(line.first).append(" ").append(line.second).append("\r\n");
+    }
+    out.append("END");
+}
 
 } // namespace Execute
 } // namespace Afina
@@ -9,6 +9,7 @@
 
 #include <cxxopts.hpp>
 
+#include <afina/Metrics.h>
 #include <afina/Storage.h>
 #include <afina/Version.h>
 #include <afina/logging/Service.h>
@@ -21,12 +22,52 @@
 #include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
 
+#include "storage/ArenaLRU.h"
+#include "storage/ClockLRU.h"
+#include "storage/CountedStorage.h"
+#include "storage/ExpiringStorage.h"
+#include "storage/HashLRU.h"
+#include "storage/MappedLRU.h"
+#include "storage/PolicyStorage.h"
+#include "storage/RcuLRU.h"
+#include "storage/SampledLRU.h"
 #include "storage/SimpleLRU.h"
+#include "storage/Snapshot.h"
 #include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/TinyLFU.h"
 #include "storage/StripedLRU.h"
+#include "storage/TieredLRU.h"
 
 using namespace Afina;
 
+/**
+ * Parses number of bytes with optional k, m or g suffix
+ */
+static std::size_t parse_size(const std::string &text) {
+    std::size_t pos = 0;
+    unsigned long long value = std::stoull(text, &pos);
+    if (pos + 1 == text.size()) {
+        switch (text[pos]) {
+        case 'g':
+        case 'G':
+            value *= 1024;
+            // fall through
+        case 'm':
+        case 'M':
+            value *= 1024;
+            // fall through
+        case 'k':
+        case 'K':
+            value *= 1024;
+            return value;
+        }
+    }
+    if (pos != text.size()) {
+        throw std::runtime_error("Invalid size: " + text);
+    }
+    return value;
+}
+
 /**
  * Whole application class
  */
@@ -52,15 +93,108 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
+        // Share of protected segment for segmented LRU, plain LRU by default
+        double protected_fraction = 0;
+        if (options.count("protected") > 0) {
+            protected_fraction = options["protected"].as<double>();
+            if (protected_fraction < 0 || protected_fraction >= 1) {
+                throw std::runtime_error("Protected fraction must be in [0, 1)");
+            }
+        }
+
+        // Memory limit of the storage, each storage has its own default
+        std::size_t memory = 0;
+        if (options.count("memory") > 0) {
+            memory = parse_size(options["memory"].as<std::string>());
+        }
+        // Limit the storage is configured with, as reported by stats
+        std::size_t max_bytes = 0;
+        auto memory_or = [memory, &max_bytes](std::size_t fallback) {
+            max_bytes = memory > 0 ? memory : fallback;
+            return max_bytes;
+        };
+
+        // Number of shards for mt_slru and the memory tier of mt_tiered, one per hardware thread by default
+        std::size_t shards = 0;
+        if (options.count("shards") > 0) {
+            shards = options["shards"].as<std::size_t>();
+        }
+
+        // Storages which expire items on their own, the rest get ExpiringStorage on top
+        bool expires = storage_type == "st_lru" || storage_type == "mt_lru" || storage_type == "mt_slru" ||
+                       storage_type == "mt_tiered";
+
         if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
+            storage = std::make_shared<Afina::Backend::SimpleLRU>(memory_or(1024), protected_fraction);
+        } else if (storage_type == "st_hlru") {
+            storage = std::make_shared<Afina::Backend::HashLRU>(memory_or(1024));
+        } else if (storage_type == "st_alru") {
+            storage = std::make_shared<Afina::Backend::ArenaLRU>(memory_or(1024));
+        } else if (storage_type == "st_clock") {
+            storage = std::make_shared<Afina::Backend::ClockLRU>(memory_or(1024));
+        } else if (storage_type == "st_tinylfu") {
+            storage = std::make_shared<Afina::Backend::TinyLFU>(memory_or(1024));
+        } else if (storage_type == "st_mmap") {
+            std::string path = "afina.mmap";
+            if (options.count("mmap-file") > 0) {
+                path = options["mmap-file"].as<std::string>();
+            }
+            mapped = std::make_shared<Afina::Backend::MappedLRU>(path, memory_or(1024 * 1024));
+            storage = mapped;
         } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
-        } else if(storage_type == "mt_slru") {
-            storage = std::make_shared<Afina::Backend::StripedLRU>();
+            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(memory_or(1024), protected_fraction);
+        } else if (storage_type == "mt_slru") {
+            storage =
+                std::make_shared<Afina::Backend::StripedLRU>(shards, memory_or(8 * 1024 * 1024), protected_fraction);
+        } else if (storage_type == "mt_tiered") {
+            std::string dir = "afina.tier";
+            if (options.count("tier-dir") > 0) {
+                dir = options["tier-dir"].as<std::string>();
+            }
+            std::size_t file_size = 1024 * 1024 * 1024;
+            if (options.count("tier-size") > 0) {
+                file_size = parse_size(options["tier-size"].as<std::string>());
+            }
+            // Event loop must not wait for the disk, it parks commands till their items are read
+            std::string network = options.count("network") > 0 ? options["network"].as<std::string>() : "st_block";
+            bool async_reads = network == "st_nonblock" || network == "mt_nonblock";
+            storage = std::make_shared<Afina::Backend::TieredLRU>(dir, shards, memory_or(8 * 1024 * 1024), file_size,
+                                                                  async_reads);
+        } else if (storage_type == "mt_rcu") {
+            storage = std::make_shared<Afina::Backend::RcuLRU>(memory_or(1024));
+        } else if (storage_type == "mt_sampled") {
+            storage = std::make_shared<Afina::Backend::SampledLRU>(memory_or(1024));
         } else {
-            throw std::runtime_error("Unknown storage type");
+            // The rest are combinations of policies, see PolicyStorage.h
+            storage = Afina::Backend::MakePolicyStorage(storage_type, memory_or(1024));
+            if (!storage) {
+                throw std::runtime_error("Unknown storage type");
+            }
         }
+        if (!expires) {
+            storage = std::make_shared<Afina::Backend::ExpiringStorage>(storage);
+        }
+
+        // Snapshot file restored on start and saved on stop, and also periodically if storage is thread safe
+        if (options.count("snapshot") > 0) {
+            // Storage is empty yet, so the dump costs nothing
+            if (!storage->Dump([](std::vector<Afina::StoredItem> &part) {})) {
+                throw std::runtime_error("Storage " + storage_type + " doesn't support snapshots");
+            }
+            snapshot = std::make_shared<Afina::Backend::Snapshot>(storage, options["snapshot"].as<std::string>());
+            storage_threads = storage_type.compare(0, 3, "mt_") == 0 ? 0 : 1;
+        }
+        if (options.count("snapshot-period") > 0) {
+            snapshot_period = options["snapshot-period"].as<uint32_t>();
+            if (!snapshot || storage_threads == 1) {
+                throw std::runtime_error("Periodic snapshot needs --snapshot and thread safe storage");
+            }
+        }
+
+        // Requests are counted from here on, items restored from snapshot are not requests
+        auto counters = std::make_shared<Afina::StorageCounters>();
+        storage = std::make_shared<Afina::Backend::CountedStorage>(storage, counters);
+        metrics = std::make_shared<Afina::Metrics>(counters, max_bytes);
 
         // Step 2: Configure network
         std::string network_type = "st_block";
@@ -69,15 +203,15 @@ public:
         }
 
         if (network_type == "st_block") {
-            server = std::make_shared<Afina::Network::STblocking::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::STblocking::ServerImpl>(storage, logService, metrics);
         } else if (network_type == "mt_block") {
-            server = std::make_shared<Afina::Network::MTblocking::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::MTblocking::ServerImpl>(storage, logService, metrics);
         } else if (network_type == "st_nonblock") {
-            server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService, metrics);
         } else if (network_type == "mt_nonblock") {
-            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService, metrics);
         } else if (network_type == "st_coroutine") {
-            server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(storage, logService, metrics);
         } else {
             throw std::runtime_error("Unknown network type");
         }
@@ -91,6 +225,28 @@ public:
 
         log->warn("Start storage");
         storage->Start();
+        if (mapped && mapped->Reattached()) {
+            log->warn("Reattached {} items left in the mapped file", mapped->Size());
+        }
+
+        if (snapshot) {
+            // Cache is warm before the first request comes
+            auto start = std::chrono::steady_clock::now();
+            std::size_t loaded = snapshot->Load(storage_threads);
+            auto spent = std::chrono::steady_clock::now() - start;
+            log->warn("Restored {} items from snapshot in {} ms", loaded,
+                      std::chrono::duration_cast<std::chrono::milliseconds>(spent).count());
+
+            if (snapshot_period > 0) {
+                snapshot->Start(snapshot_period, [log](std::size_t items, const std::string &error) {
+                    if (error.empty()) {
+                        log->info("Saved {} items to snapshot", items);
+                    } else {
+                        log->error("Failed to save snapshot: {}", error);
+                    }
+                });
+            }
+        }
 
         // TODO: configure network service
         const uint16_t port = 8080;
@@ -105,6 +261,15 @@ public:
         server->Stop();
         server->Join();
 
+        if (snapshot) {
+            snapshot->Stop();
+            try {
+                log->warn("Saved {} items to snapshot", snapshot->Save());
+            } catch (std::exception &ex) {
+                log->error("Failed to save snapshot: {}", ex.what());
+            }
+        }
+
         storage->Stop();
         logService->Stop();
     }
@@ -115,6 +280,16 @@ private:
 
     std::shared_ptr<Afina::Storage> storage;
     std::shared_ptr<Network::Server> server;
+    std::shared_ptr<Afina::Metrics> metrics;
+
+    // Set for st_mmap storage, its items may outlive the process
+    std::shared_ptr<Afina::Backend::MappedLRU> mapped;
+
+    std::shared_ptr<Afina::Backend::Snapshot> snapshot;
+    // Zero period means snapshot is saved on stop only
+    uint32_t snapshot_period = 0;
+    // Threads allowed to put items into the storage at once, zero means any number
+    std::size_t storage_threads = 1;
 };
 
 // Signal set that to notify application about time to stop
@@ -134,6 +309,23 @@ int main(int argc, char **argv) {
         // TODO: use custom cxxopts::value to print options possible values in help message
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
+        options.add_options()("protected",
+                              "Share of protected segment in st_lru, mt_lru and mt_slru, enables segmented LRU",
+                              cxxopts::value<double>());
+        options.add_options()("memory", "Storage size in bytes, k, m or g suffix could be used",
+                              cxxopts::value<std::string>());
+        options.add_options()("shards",
+                              "Number of shards in mt_slru and mt_tiered storages, one per hardware thread by default",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("mmap-file", "File of st_mmap storage, afina.mmap by default",
+                              cxxopts::value<std::string>());
+        options.add_options()("tier-dir", "Directory of mt_tiered file tier, afina.tier by default",
+                              cxxopts::value<std::string>());
+        options.add_options()("tier-size", "Size of mt_tiered file tier, 1g by default", cxxopts::value<std::string>());
+        options.add_options()("snapshot", "File to restore storage from on start and to save it to on stop",
+                              cxxopts::value<std::string>());
+        options.add_options()("snapshot-period", "Seconds between background snapshots, mt_* storages only",
+                              cxxopts::value<uint32_t>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
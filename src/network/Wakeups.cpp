@@ -0,0 +1,34 @@
+#include "Wakeups.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+
+// See Wakeups.h
+EventFd::EventFd() : _fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (_fd == -1) {
+        throw std::runtime_error("Failed to create wakeup event fd: " + std::string(strerror(errno)));
+    }
+}
+
+// See Wakeups.h
+EventFd::~EventFd() { close(_fd); }
+
+// See Wakeups.h
+void EventFd::Signal() { eventfd_write(_fd, 1); }
+
+// See Wakeups.h
+void EventFd::Drain() {
+    eventfd_t count;
+    eventfd_read(_fd, &count);
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,71 @@
+#ifndef AFINA_NETWORK_WAKEUPS_H
+#define AFINA_NETWORK_WAKEUPS_H
+
+#include <mutex>
+#include <vector>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Event fd which wakes up an epoll loop from other threads
+ * Nonblocking, so signal never blocks the sender and drain never blocks the loop
+ */
+class EventFd {
+public:
+    EventFd();
+    ~EventFd();
+
+    EventFd(const EventFd &) = delete;
+    EventFd &operator=(const EventFd &) = delete;
+
+    // Fd to be watched by epoll
+    inline int Fd() const { return _fd; }
+
+    // Makes the fd readable, called from any thread
+    void Signal();
+
+    // Resets the fd once the loop got the event
+    void Drain();
+
+private:
+    int _fd;
+};
+
+/**
+ * # Connections which commands are ready to go on, see Execute::Command::Prepare
+ * Storage threads add connections and signal the event fd, the event loop takes them once it fires.
+ * Shared by nonblocking servers, each of them with its own type of connection
+ */
+template <typename Connection> class Wakeups {
+public:
+    // Event fd to be watched by epoll
+    inline int Fd() const { return _event.Fd(); }
+
+    // Called from any thread, connection is never touched here, so it could be gone already
+    void Add(Connection *pc) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _ready.push_back(pc);
+        _event.Signal();
+    }
+
+    // Connections added since the last call
+    std::vector<Connection *> Take() {
+        _event.Drain();
+
+        std::vector<Connection *> ready;
+        std::unique_lock<std::mutex> lock(_mutex);
+        ready.swap(_ready);
+        return ready;
+    }
+
+private:
+    EventFd _event;
+    std::mutex _mutex;
+    std::vector<Connection *> _ready;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_WAKEUPS_H
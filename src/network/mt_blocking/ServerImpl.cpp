@@ -17,6 +17,7 @@
 
 #include <spdlog/logger.h>
 
+#include <afina/Metrics.h>
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
@@ -28,7 +29,9 @@ namespace Network {
 namespace MTblocking {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       std::shared_ptr<Afina::Metrics> pm)
+    : Server(ps, pl, pm) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -139,6 +142,7 @@ void ServerImpl::OnRun() {
         {
             std::unique_lock<std::mutex> lock(_mtx);
             if (running && _sockets.size() < max_workers){
+                pMetrics->Opened(client_socket, &client_addr, client_addr_len);
                 std::thread worker(&ServerImpl::work_func, this, client_socket);
                 worker.detach();
                 _sockets.insert(client_socket);
@@ -160,7 +164,7 @@ void ServerImpl::work_func(int client_socket){
     // - arg_remains: how many bytes to read from stream to get command argument
     // - argument_for_command: buffer stores argument
     std::size_t arg_remains=0;
-    Protocol::Parser parser;
+    Protocol::Parser parser(pMetrics.get());
     std::string argument_for_command;
     std::unique_ptr<Execute::Command> command_to_execute;
 
@@ -173,6 +177,7 @@ void ServerImpl::work_func(int client_socket){
         char client_buffer[4096] = "";
         while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
             _logger->debug("Got {} bytes from socket", readed_bytes);
+            pMetrics->Read(readed_bytes);
 
             // Single block of data readed from the socket could trigger inside actions a multiple times,
             // for example:
@@ -230,6 +235,7 @@ void ServerImpl::work_func(int client_socket){
                     if (send(client_socket, result.data(), result.size(), 0) <= 0) {
                         throw std::runtime_error("Failed to send response");
                     }
+                    pMetrics->Written(result.size());
 
                     // Prepare for the next command
                     command_to_execute.reset();
@@ -250,6 +256,7 @@ void ServerImpl::work_func(int client_socket){
 
     // We are done with this connection
     std::unique_lock<std::mutex> lock(_mtx);
+    pMetrics->Closed(client_socket);
     close(client_socket);
     _sockets.erase(client_socket);
     if (!running && _sockets.empty()){
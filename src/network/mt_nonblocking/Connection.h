@@ -5,10 +5,15 @@
 
 #include <sys/epoll.h>
 
+#include <afina/Metrics.h>
+#include <afina/Storage.h>
 #include <afina/execute/Command.h>
+#include <network/Wakeups.h>
 #include <protocol/Parser.h>
 #include <spdlog/logger.h>
 
+#include <chrono>
+#include <functional>
 #include <vector>
 #include <atomic>
 
@@ -16,10 +21,15 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+class Connection;
+
+typedef Network::Wakeups<Connection> Wakeups;
+
 class Connection {
 public:
-    Connection(int s, std::shared_ptr<Afina::Storage>& ps, std::shared_ptr<spdlog::logger>& pl)
-     : _socket(s),  _pStorage(ps), _logger(pl) {
+    Connection(int s, std::shared_ptr<Afina::Storage>& ps, std::shared_ptr<spdlog::logger>& pl,
+               Afina::Metrics *pm = nullptr)
+     : _socket(s),  _pStorage(ps), _logger(pl), _metrics(pm), _parser(pm), _timed(false) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         _is_alive.store(true, std::memory_order_release);
         _is_reading_ended.store(false, std::memory_order_release);
@@ -28,6 +38,7 @@ public:
         std::memset(_read_buffer, 0, 4096);
         _arg_remains = 0;
         _event.data.ptr = this;
+        _parked = false;
     }
 
     inline bool isAlive() const { return _is_alive.load(std::memory_order_acquire); }
@@ -40,6 +51,15 @@ protected:
     void DoRead();
     void DoWrite();
 
+    // Executes the parked command once storage is ready, and goes on with the rest of the read bytes
+    void Resume();
+
+    /**
+     * Worker which parked the command and worker which got the wakeup both call it once done with the
+     * connection, only the last one gets true and resumes it
+     */
+    inline bool Release() { return _park_holders.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
 private:
     friend class Worker;
     friend class ServerImpl;
@@ -50,11 +70,15 @@ private:
     std::atomic<bool> _is_alive;
     std::atomic<bool> _is_reading_ended;
 
-    std::vector<std::string> _output;
+    // Buffers to be sent, values are referenced right in the storage memory
+    std::vector<ValueView> _output;
 
     std::shared_ptr<spdlog::logger> _logger;
     std::shared_ptr<Afina::Storage> _pStorage;
 
+    // Server wide statistics, might be null
+    Afina::Metrics *_metrics;
+
     //for DoWrite()
     std::size_t _head_offset;
     
@@ -65,6 +89,22 @@ private:
     Protocol::Parser _parser;
     std::string _argument_for_command;
     std::unique_ptr<Execute::Command> _command_to_execute;
+
+    // Command waits for the storage, connection isn't rearmed till it is resumed
+    bool _parked;
+    std::atomic<int> _park_holders;
+    std::function<void()> _wakeup;
+
+    // Command being executed and the moment its argument has been read completely, for latency histograms
+    bool _timed;
+    Metrics::Command _timed_command;
+    std::chrono::steady_clock::time_point _started_at;
+
+    // Executes read commands till the bytes are over or some command gets parked
+    void Process();
+
+    // Executes the command read completely and queues its response
+    void Run();
 };
 
 } // namespace MTnonblock
@@ -4,6 +4,7 @@
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <new>
 #include <stdexcept>
 
 #include <arpa/inet.h>
@@ -18,7 +19,9 @@
 
 #include <spdlog/logger.h>
 
+#include <afina/Metrics.h>
 #include <afina/Storage.h>
+#include <afina/allocator/Error.h>
 #include <afina/logging/Service.h>
 
 #include "Connection.h"
@@ -29,8 +32,13 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+// Number of connections served from the pool, the rest go to the heap
+#define POOLED_CONNECTIONS 1024
+
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       std::shared_ptr<Afina::Metrics> pm)
+    : Server(ps, pl, pm) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {
@@ -80,6 +88,20 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
     }
 
+    // Connections pool, slabs are big enough to keep several connections each. Read buffer is a part of the
+    // connection, so it comes from the pool too; responses and storage items vary in size and stay on the heap
+    const size_t slab_size = 16 * sizeof(Connection);
+    const size_t area_size = slab_size * (POOLED_CONNECTIONS / 16);
+    _connections_area.reset(new char[area_size]);
+    _slab_cache.reset(new Afina::Allocator::SlabCache(_connections_area.get(), area_size, slab_size));
+    _connections_pool.reset(new Afina::Allocator::Mempool(*_slab_cache, sizeof(Connection)));
+    pMetrics->AddReport("slabs", "connections", [this](Metrics::Lines &out) {
+        out.emplace_back("connections:object_size", std::to_string(_connections_pool->object_size()));
+        out.emplace_back("connections:slab_size", std::to_string(_slab_cache->slab_size()));
+        out.emplace_back("connections:total_slabs", std::to_string(_slab_cache->slabs_count()));
+        out.emplace_back("connections:free_slabs", std::to_string(_slab_cache->free_slabs()));
+    });
+
     // Start IO workers
     _data_epoll_fd = epoll_create1(0);
     if (_data_epoll_fd == -1) {
@@ -98,10 +120,18 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Failed to add eventfd descriptor to epoll");
     }
 
+    _wakeups = std::make_shared<Wakeups>();
+    struct epoll_event wakeup_event;
+    wakeup_event.events = EPOLLIN;
+    wakeup_event.data.ptr = _wakeups.get();
+    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, _wakeups->Fd(), &wakeup_event)) {
+        throw std::runtime_error("Failed to add eventfd descriptor to epoll");
+    }
+
     _workers.reserve(n_workers);
     for (int i = 0; i < n_workers; i++) {
         _workers.emplace_back(pStorage, pLogging, this);
-        _workers.back().Start(_data_epoll_fd);
+        _workers.back().Start(_data_epoll_fd, _wakeups);
     }
 
     // Start acceptors
@@ -114,6 +144,8 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
 // See Server.h
 void ServerImpl::Stop() {
     _logger->warn("Stop network service");
+    pMetrics->RemoveReport("slabs", "connections");
+
     // Said workers to stop
     for (auto &w : _workers) {
         w.Stop();
@@ -149,8 +181,9 @@ void ServerImpl::Join() {
     {
         std::unique_lock<std::mutex> lock(_set_mtx);
         for (auto& connection : _connections){
+            pMetrics->Closed(connection->_socket);
             close(connection->_socket);
-            delete connection;
+            FreeConnection(connection);
         }
         _connections.clear();
 
@@ -211,6 +244,8 @@ void ServerImpl::OnRun() {
                     }
                 }
 
+                pMetrics->Opened(infd, &in_addr, in_len);
+
                 // Print host and service info.
                 char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
                 int retval = getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf,
@@ -220,10 +255,7 @@ void ServerImpl::OnRun() {
                 }
 
                 // Register the new FD to be monitored by epoll.
-                Connection *pc = new Connection(infd, pStorage, _logger);
-                if (pc == nullptr) {
-                    throw std::runtime_error("Failed to allocate connection");
-                }
+                Connection *pc = NewConnection(infd);
 
                 // Register connection in worker's epoll
                 pc->Start();
@@ -233,8 +265,9 @@ void ServerImpl::OnRun() {
                     if ((epoll_ctl_retval = epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event))) {
                         _logger->debug("epoll_ctl failed during connection register in workers'epoll: error {}", epoll_ctl_retval);
                         pc->OnError();
+                        pMetrics->Closed(pc->_socket);
                         close(pc->_socket);
-                        delete pc;
+                        FreeConnection(pc);
                     } else{
                         std::unique_lock<std::mutex> lock(_set_mtx);
                         _connections.emplace(pc);
@@ -248,9 +281,36 @@ void ServerImpl::OnRun() {
 
 void ServerImpl::DelConnection(Connection* pc){
     std::unique_lock<std::mutex> lock(_set_mtx);
+    pMetrics->Closed(pc->_socket);
     close(pc->_socket);
     _connections.erase(pc);
-    delete pc;
+    FreeConnection(pc);
+}
+
+// See ServerImpl.h
+Connection *ServerImpl::NewConnection(int socket) {
+    void *mem;
+    try {
+        mem = _connections_pool->alloc();
+    } catch (Afina::Allocator::AllocError &) {
+        mem = ::operator new(sizeof(Connection));
+    }
+    Connection *pc = new (mem) Connection(socket, pStorage, _logger, pMetrics.get());
+
+    // Commands waiting for the storage are resumed by workers
+    std::shared_ptr<Wakeups> wakeups = _wakeups;
+    pc->_wakeup = [wakeups, pc]() { wakeups->Add(pc); };
+    return pc;
+}
+
+// See ServerImpl.h
+void ServerImpl::FreeConnection(Connection *pc) {
+    pc->~Connection();
+    if (_slab_cache->owns(pc)) {
+        _connections_pool->free(pc);
+    } else {
+        ::operator delete(pc);
+    }
 }
 
 } // namespace MTnonblock
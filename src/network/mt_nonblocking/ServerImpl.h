@@ -7,6 +7,7 @@
 #include <mutex>
 
 #include "Connection.h"
+#include <afina/allocator/SlabCache.h>
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -26,7 +27,8 @@ class Worker;
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               std::shared_ptr<Afina::Metrics> pm);
     ~ServerImpl();
 
     // See Server.h
@@ -44,6 +46,12 @@ protected:
     void OnRun();
     void OnNewConnection();
 
+    // Allocates connection from the pool, falls back to the heap once pool is exhausted
+    Connection *NewConnection(int socket);
+
+    // Destroys connection and returns its memory to where it was taken from
+    void FreeConnection(Connection *pc);
+
 private:
     // logger to use
     std::shared_ptr<spdlog::logger> _logger;
@@ -69,6 +77,16 @@ private:
     // threads serving read/write requests
     std::vector<Worker> _workers;
 
+    // Connections which commands waited for the storage and could go on, shared with storage callbacks
+    std::shared_ptr<Wakeups> _wakeups;
+
+    // Memory for connections: they are created by acceptors and destroyed by workers, so allocation
+    // goes through per-core free lists instead of the global heap. Read buffer is a part of the
+    // connection, output queue and command argument still grow on the heap
+    std::unique_ptr<char[]> _connections_area;
+    std::unique_ptr<Afina::Allocator::SlabCache> _slab_cache;
+    std::unique_ptr<Afina::Allocator::Mempool> _connections_pool;
+
     //set of connections and mutex for it
     std::unordered_set<Connection*> _connections;
     std::mutex _set_mtx;
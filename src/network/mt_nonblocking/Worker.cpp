@@ -41,16 +41,18 @@ Worker &Worker::operator=(Worker &&other) {
     _logger = std::move(other._logger);
     _thread = std::move(other._thread);
     _epoll_fd = other._epoll_fd;
+    _wakeups = std::move(other._wakeups);
 
     other._epoll_fd = -1;
     return *this;
 }
 
 // See Worker.h
-void Worker::Start(int epoll_fd) {
+void Worker::Start(int epoll_fd, std::shared_ptr<Wakeups> wakeups) {
     if (isRunning.exchange(true) == false) {
         assert(_epoll_fd == -1);
         _epoll_fd = epoll_fd;
+        _wakeups = std::move(wakeups);
         _logger = _pLogging->select("network.worker");
         _thread = std::thread(&Worker::OnRun, this);
     }
@@ -92,6 +94,17 @@ void Worker::OnRun() {
                 continue;
             }
 
+            // Storage is ready for some parked commands
+            if (current_event.data.ptr == _wakeups.get()) {
+                for (Connection *pconn : _wakeups->Take()) {
+                    if (pconn->Release()) {
+                        pconn->Resume();
+                        Finish(pconn);
+                    }
+                }
+                continue;
+            }
+
             // Some connection gets new data
             Connection *pconn = static_cast<Connection *>(current_event.data.ptr);
             if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
@@ -112,30 +125,44 @@ void Worker::OnRun() {
                 }
             }
 
-            // Rearm connection
-            if (pconn->isAlive()) {
-                pconn->_event.events |= EPOLLONESHOT;
-                int epoll_ctl_retval;
-                if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
-                    _logger->debug("epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
-                    pconn->OnError();
-                    _server->DelConnection(pconn);
-                    
-                }
-            }
-            // Or delete closed one
-            else {
-                if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
-                    std::cerr << "Failed to delete connection!" << std::endl;
-                }
-                _server->DelConnection(pconn);
-            }
+            Finish(pconn);
         }
         // TODO: Select timeout...
     }
     _logger->warn("Worker stopped");
 }
 
+// See Worker.h
+void Worker::Finish(Connection *pconn) {
+    // Command waits for the storage: either the wakeup gets the connection to some worker or it has
+    // come already, then it is resumed right here
+    while (pconn->_parked) {
+        if (!pconn->Release()) {
+            return;
+        }
+        pconn->Resume();
+    }
+
+    // Rearm connection
+    if (pconn->isAlive()) {
+        pconn->_event.events |= EPOLLONESHOT;
+        int epoll_ctl_retval;
+        if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
+            _logger->debug("epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
+            pconn->OnError();
+            _server->DelConnection(pconn);
+            
+        }
+    }
+    // Or delete closed one
+    else {
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
+            std::cerr << "Failed to delete connection!" << std::endl;
+        }
+        _server->DelConnection(pconn);
+    }
+}
+
 } // namespace MTnonblock
 } // namespace Network
 } // namespace Afina
@@ -38,9 +38,9 @@ public:
     /**
      * Spaws new background thread that is doing epoll on the given server
      * socket. Once connection accepted it must be registered and being processed
-     * on this thread
+     * on this thread. Connections added to wakeups are resumed by workers too
      */
-    void Start(int epoll_fd);
+    void Start(int epoll_fd, std::shared_ptr<Wakeups> wakeups);
 
     /**
      * Signal background thread to stop. After that signal thread must stop to
@@ -62,6 +62,9 @@ protected:
      */
     void OnRun();
 
+    // Rearms connection once its event is processed, or deletes closed one
+    void Finish(Connection *pconn);
+
 private:
     Worker(Worker &) = delete;
     Worker &operator=(Worker &) = delete;
@@ -84,6 +87,9 @@ private:
     // EPOLL descriptor using for events processing
     int _epoll_fd;
 
+    // Connections which commands waited for the storage, its event fd is in the epoll
+    std::shared_ptr<Wakeups> _wakeups;
+
     //pointer on server
     ServerImpl* _server;
 };
@@ -17,6 +17,7 @@
 
 #include <spdlog/logger.h>
 
+#include <afina/Metrics.h>
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
@@ -28,7 +29,9 @@ namespace Network {
 namespace STblocking {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       std::shared_ptr<Afina::Metrics> pm)
+    : Server(ps, pl, pm) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -126,7 +129,7 @@ void ServerImpl::OnRun() {
     // - arg_remains: how many bytes to read from stream to get command argument
     // - argument_for_command: buffer stores argument
     std::size_t arg_remains;
-    Protocol::Parser parser;
+    Protocol::Parser parser(pMetrics.get());
     std::string argument_for_command;
     std::unique_ptr<Execute::Command> command_to_execute;
     while (running.load()) {
@@ -139,6 +142,7 @@ void ServerImpl::OnRun() {
         if ((client_socket = accept(_server_socket, (struct sockaddr *)&client_addr, &client_addr_len)) == -1) {
             continue;
         }
+        pMetrics->Opened(client_socket, &client_addr, client_addr_len);
 
         // Got new connection
         if (_logger->should_log(spdlog::level::debug)) {
@@ -170,6 +174,7 @@ void ServerImpl::OnRun() {
             char client_buffer[4096];
             while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
                 _logger->debug("Got {} bytes from socket", readed_bytes);
+                pMetrics->Read(readed_bytes);
 
                 // Single block of data readed from the socket could trigger inside actions a multiple times,
                 // for example:
@@ -227,6 +232,7 @@ void ServerImpl::OnRun() {
                         if (send(client_socket, result.data(), result.size(), 0) <= 0) {
                             throw std::runtime_error("Failed to send response");
                         }
+                        pMetrics->Written(result.size());
 
                         // Prepare for the next command
                         command_to_execute.reset();
@@ -246,6 +252,7 @@ void ServerImpl::OnRun() {
         }
 
         // We are done with this connection
+        pMetrics->Closed(client_socket);
         close(client_socket);
 
         // Prepare for the next command: just in case if connection was closed in the middle of executing something
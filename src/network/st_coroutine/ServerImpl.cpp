@@ -18,6 +18,7 @@
 
 #include <spdlog/logger.h>
 
+#include <afina/Metrics.h>
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
 
@@ -29,7 +30,9 @@ namespace Network {
 namespace STcoroutine {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       std::shared_ptr<Afina::Metrics> pm)
+    : Server(ps, pl, pm) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -162,6 +165,7 @@ void ServerImpl::OnRun() {
                     _logger->error("Failed to delete connection from epoll");
                 }
 
+                pMetrics->Closed(pc->_socket);
                 close(pc->_socket);
                 pc->OnClose();
 
@@ -170,6 +174,7 @@ void ServerImpl::OnRun() {
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
                     _logger->error("Failed to change connection event mask");
 
+                    pMetrics->Closed(pc->_socket);
                     close(pc->_socket);
                     pc->OnClose();
 
@@ -198,6 +203,8 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
             }
         }
 
+        pMetrics->Opened(infd, &in_addr, in_len);
+
         // Print host and service info.
         char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
         int retval =
@@ -217,6 +224,7 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
         if (pc->isAlive()) {
             if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
                 pc->OnError();
+                pMetrics->Closed(infd);
                 delete pc;
             }
         }
@@ -1,8 +1,12 @@
 #include "Connection.h"
 
+#include <algorithm>
+#include <climits>
 #include <iostream>
 #include <cassert>
+#include <stdexcept>
 #include <sys/uio.h>
+#include <unistd.h>
 
 namespace Afina {
 namespace Network {
@@ -45,74 +49,16 @@ void Connection::DoRead() {
         while ((read_now_count = read(_socket, _read_buffer + _read_bytes, sizeof(_read_buffer) - _read_bytes)) > 0) {
 
             _logger->debug("Got {} bytes from socket", read_now_count);
+            if (_metrics != nullptr) {
+                _metrics->Read(read_now_count);
+            }
             _read_bytes += read_now_count;
 
-            while (_read_bytes > 0) {
-                _logger->debug("Process {} bytes", _read_bytes);
-                // There is no command yet
-                if (!_command_to_execute) {
-                    std::size_t parsed = 0;
-                    if (_parser.Parse(_read_buffer, _read_bytes, parsed)) {
-                        // There is no command to be launched, continue to parse input stream
-                        // Here we are, current chunk finished some command, process it
-                        _logger->debug("Found new command: {} in {} bytes", _parser.Name(), parsed);
-                        _command_to_execute = _parser.Build(_arg_remains);
-                        if (_arg_remains > 0) {
-                            _arg_remains += 2;
-                        }
-                    }
-
-                    // Parsed might fails to consume any bytes from input stream. In real life that could happens,
-                    // for example, because we are working with UTF-16 chars and only 1 byte left in stream
-                    if (parsed == 0) {
-                        break;
-                    } else {
-                        std::memmove(_read_buffer, _read_buffer + parsed, _read_bytes - parsed);
-                        _read_bytes -= parsed;
-                    }
-                }
-
-                // There is command, but we still wait for argument to arrive...
-                if (_command_to_execute && _arg_remains > 0) {
-                    _logger->debug("Fill argument: {} bytes of {}", _read_bytes, _arg_remains);
-                    // There is some parsed command, and now we are reading argument
-                    std::size_t to_read = std::min(_arg_remains, std::size_t(_read_bytes));
-                    _argument_for_command.append(_read_buffer, to_read);
-
-                    std::memmove(_read_buffer, _read_buffer + to_read, _read_bytes - to_read);
-                    _arg_remains -= to_read;
-                    _read_bytes -= to_read;
-                }
-
-                // Thre is command & argument - RUN!
-                if (_command_to_execute && _arg_remains == 0) {
-                    _logger->debug("Start command execution");
-
-                    std::string result;
-                    
-                    if (_argument_for_command.size()) {
-                        _argument_for_command.resize(_argument_for_command.size() - 2);
-                    }
-                    _command_to_execute->Execute(*_pStorage, _argument_for_command, result);
-
-                    // Send response
-                    result += "\r\n";
-                    _output.push_back(result);
-                    
-                    if(! _output.empty()){ // if queue isn't empty we add EPOLLOUT interest
-                        _event.events |= EPOLLOUT;
-                    }
-
-                    if( _output.size() >= MAX_OUT_SIZE){ // if queue has more than 100 elements, drop EPOLLIN interest
-                        _event.events &= ~EPOLLIN;
-                    }
-
-                    // Prepare for the next command
-                    _command_to_execute.reset();
-                    _argument_for_command.resize(0);
-                    _parser.Reset();
-                }
-            } // while (_read_bytes)
+            Process();
+            if (_parked) {
+                // The rest is read once the command is done, see Resume
+                return;
+            }
         } // while (read_now_count)
         
         if (_read_bytes == 0) {
@@ -138,40 +84,158 @@ void Connection::DoRead() {
     }
 }
 
+// See Connection.h
+void Connection::Process() {
+    while (_read_bytes > 0 && !_parked) {
+        _logger->debug("Process {} bytes", _read_bytes);
+        // There is no command yet
+        if (!_command_to_execute) {
+            std::size_t parsed = 0;
+            // Only the call which completes the command line is timed, client sending it in parts doesn't count
+            auto parse_start = _metrics != nullptr ? std::chrono::steady_clock::now()
+                                                   : std::chrono::steady_clock::time_point();
+            if (_parser.Parse(_read_buffer, _read_bytes, parsed)) {
+                // There is no command to be launched, continue to parse input stream
+                // Here we are, current chunk finished some command, process it
+                _logger->debug("Found new command: {} in {} bytes", _parser.Name(), parsed);
+                _command_to_execute = _parser.Build(_arg_remains);
+                _timed = _metrics != nullptr && Metrics::CommandOf(_parser.Name(), _timed_command);
+                if (_timed) {
+                    _metrics->Took(_timed_command, Metrics::kParse, Metrics::Since(parse_start));
+                }
+                if (_arg_remains > 0) {
+                    _arg_remains += 2;
+                }
+            }
+
+            // Parsed might fails to consume any bytes from input stream. In real life that could happens,
+            // for example, because we are working with UTF-16 chars and only 1 byte left in stream
+            if (parsed == 0) {
+                break;
+            } else {
+                std::memmove(_read_buffer, _read_buffer + parsed, _read_bytes - parsed);
+                _read_bytes -= parsed;
+            }
+        }
+
+        // There is command, but we still wait for argument to arrive...
+        if (_command_to_execute && _arg_remains > 0) {
+            _logger->debug("Fill argument: {} bytes of {}", _read_bytes, _arg_remains);
+            // There is some parsed command, and now we are reading argument
+            std::size_t to_read = std::min(_arg_remains, std::size_t(_read_bytes));
+            _argument_for_command.append(_read_buffer, to_read);
+
+            std::memmove(_read_buffer, _read_buffer + to_read, _read_bytes - to_read);
+            _arg_remains -= to_read;
+            _read_bytes -= to_read;
+        }
+
+        // Thre is command & argument - RUN!
+        if (_command_to_execute && _arg_remains == 0) {
+            // Slow client sending the argument doesn't count, waiting for the storage read does
+            if (_timed) {
+                _started_at = std::chrono::steady_clock::now();
+            }
+            // Slow storage reads are done in background, without blocking other connections
+            if (_command_to_execute->Prepare(*_pStorage, _wakeup)) {
+                _logger->debug("Park command execution");
+                _parked = true;
+                break;
+            }
+            Run();
+        }
+    } // while (_read_bytes)
+}
+
+// See Connection.h
+void Connection::Run() {
+    _logger->debug("Start command execution");
+
+    if (_argument_for_command.size()) {
+        _argument_for_command.resize(_argument_for_command.size() - 2);
+    }
+    _command_to_execute->ExecuteViews(*_pStorage, _argument_for_command, _output);
+    if (_timed) {
+        _metrics->Took(_timed_command, Metrics::kExecute, Metrics::Since(_started_at));
+    }
+
+    // Send response
+    _output.emplace_back(nullptr, "\r\n", 2);
+    if (_timed) {
+        _metrics->Took(_timed_command, Metrics::kTotal, Metrics::Since(_started_at));
+        _timed = false;
+    }
+    
+    if(! _output.empty()){ // if queue isn't empty we add EPOLLOUT interest
+        _event.events |= EPOLLOUT;
+    }
+
+    if( _output.size() >= MAX_OUT_SIZE){ // if queue has more than 100 elements, drop EPOLLIN interest
+        _event.events &= ~EPOLLIN;
+    }
+
+    // Prepare for the next command
+    _command_to_execute.reset();
+    _argument_for_command.resize(0);
+    _parser.Reset();
+}
+
+// See Connection.h
+void Connection::Resume() {
+    _logger->debug("Resume command execution on {} socket", _socket);
+    _parked = false;
+    try {
+        Run();
+        Process();
+    } catch (std::runtime_error &ex) {
+        _logger->error("Failed to process connection on descriptor {}: {}", _socket, ex.what());
+        _is_reading_ended = true;
+        if (_output.empty()){
+            _is_alive = false;
+        }
+    }
+
+    // Socket is read on as if command had never waited
+    if (!_parked && _is_alive && !_is_reading_ended) {
+        DoRead();
+    }
+}
+
 // See Connection.h
 void Connection::DoWrite() {
     _logger->debug("Do write on {} socket, queue_size: {}", _socket, _output.size());
     assert(! _output.empty());
 
-    struct iovec iov[_output.size()];
+    std::size_t count = std::min<std::size_t>(_output.size(), IOV_MAX);
+    struct iovec iov[count];
     std::size_t i=0;
     
-    for ( i = 0; i < _output.size(); i++) { // init iovec
-        iov[i].iov_base = &(_output[i][0]);
+    for ( i = 0; i < count; i++) { // init iovec
+        iov[i].iov_base = const_cast<char *>(_output[i].data());
         iov[i].iov_len = _output[i].size();
     }
     iov[0].iov_base = static_cast<char*>(iov[0].iov_base) + _head_offset; //displace the 0th element on offset
     iov[0].iov_len -= _head_offset; //and decrease its length also
 
-    int written_bytes = writev(_socket, iov, i);
+    ssize_t written_bytes = writev(_socket, iov, count);
 
     if (written_bytes <= 0) { //an error occured
         if (errno != EINTR && errno != EAGAIN) {
             _is_alive = false;
             // throw std::runtime_error("Impossible to send response");
         }
+        written_bytes = 0;
+    } else if (_metrics != nullptr) {
+        _metrics->Written(written_bytes);
     }
 
-    i = 0;
-    for ( i = 0; i <_output.size(); i++) {
-        if (written_bytes - _output[i].size() >= 0) {
-            written_bytes -=  _output[i].size();
-        } else {
-            break;
-        }
+    // Sent buffers are released, that unpins values in the storage
+    std::size_t written = _head_offset + written_bytes;
+    for ( i = 0; i < count && written >= _output[i].size(); i++) {
+        written -= _output[i].size();
     }
     _output.erase(_output.begin(), _output.begin() + i);
-    _head_offset = written_bytes;
+    _head_offset = written;
 
     if (_output.size() < MAX_OUT_SIZE){
         _event.events |= EPOLLIN;
@@ -6,19 +6,29 @@
 #include <sys/epoll.h>
 
 #include <spdlog/logger.h>
+#include <afina/Metrics.h>
+#include <afina/Storage.h>
 #include <afina/execute/Command.h>
+#include "network/Wakeups.h"
 #include "protocol/Parser.h"
 
+#include <chrono>
+#include <functional>
 #include <vector>
 
 namespace Afina {
 namespace Network {
 namespace STnonblock {
 
+class Connection;
+
+typedef Network::Wakeups<Connection> Wakeups;
+
 class Connection {
 public:
-    Connection(int s, std::shared_ptr<Afina::Storage>& ps, std::shared_ptr<spdlog::logger>& pl)
-     : _socket(s),  _pStorage(ps), _logger(pl) {
+    Connection(int s, std::shared_ptr<Afina::Storage>& ps, std::shared_ptr<spdlog::logger>& pl,
+               Afina::Metrics *pm = nullptr)
+     : _socket(s),  _pStorage(ps), _logger(pl), _metrics(pm), _parser(pm), _timed(false) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         std::memset(_read_buffer, 0, 4096);
         _event.data.ptr = this;
@@ -28,6 +38,7 @@ public:
         _read_bytes = 0;
         _arg_remains = 0;
         _head_offset = 0;
+        _parked = false;
     }
 
     inline bool isAlive() const { return _is_alive; }
@@ -40,6 +51,9 @@ protected:
     void DoRead();
     void DoWrite();
 
+    // Executes the parked command once storage is ready, and goes on with the rest of the read bytes
+    void Resume();
+
 private:
     friend class ServerImpl;
 
@@ -47,11 +61,15 @@ private:
     int _socket;
     struct epoll_event _event;
 
-    std::vector<std::string> _output;
+    // Buffers to be sent, values are referenced right in the storage memory
+    std::vector<ValueView> _output;
 
     std::shared_ptr<spdlog::logger> _logger;
     std::shared_ptr<Afina::Storage> _pStorage;
 
+    // Server wide statistics, might be null
+    Afina::Metrics *_metrics;
+
     //for DoRead() and DoWrite()
     bool _is_reading_ended;    
     
@@ -65,6 +83,21 @@ private:
     Protocol::Parser _parser;
     std::string _argument_for_command;
     std::unique_ptr<Execute::Command> _command_to_execute;
+
+    // Command waits for the storage, connection is neither read nor written till it is resumed
+    bool _parked;
+    std::function<void()> _wakeup;
+
+    // Command being executed and the moment its argument has been read completely, for latency histograms
+    bool _timed;
+    Metrics::Command _timed_command;
+    std::chrono::steady_clock::time_point _started_at;
+
+    // Executes read commands till the bytes are over or some command gets parked
+    void Process();
+
+    // Executes the command read completely and queues its response
+    void Run();
 };
 
 } // namespace STnonblock
@@ -18,6 +18,7 @@
 
 #include <spdlog/logger.h>
 
+#include <afina/Metrics.h>
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
 
@@ -29,7 +30,9 @@ namespace Network {
 namespace STnonblock {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       std::shared_ptr<Afina::Metrics> pm)
+    : Server(ps, pl, pm) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {
@@ -82,6 +85,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     if (_event_fd == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
+    _wakeups = std::make_shared<Wakeups>();
 
     _work_thread = std::thread(&ServerImpl::OnRun, this);
 }
@@ -128,6 +132,13 @@ void ServerImpl::OnRun() {
         throw std::runtime_error("Failed to add file descriptor to epoll");
     }
 
+    struct epoll_event event3;
+    event3.events = EPOLLIN;
+    event3.data.fd = _wakeups->Fd();
+    if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, _wakeups->Fd(), &event3)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll");
+    }
+
     bool run = true;
     std::array<struct epoll_event, 64> mod_list;
     while (run) {
@@ -143,6 +154,11 @@ void ServerImpl::OnRun() {
             } else if (current_event.data.fd == _server_socket) {
                 OnNewConnection(epoll_descr);
                 continue;
+            } else if (current_event.data.fd == _wakeups->Fd()) {
+                for (Connection *pc : _wakeups->Take()) {
+                    OnWakeup(epoll_descr, pc);
+                }
+                continue;
             }
 
             // That is some connection!
@@ -163,12 +179,19 @@ void ServerImpl::OnRun() {
                 }
             }
 
+            // Command waits for the storage, connection is back to epoll once it is done, see OnWakeup
+            if (pc->_parked) {
+                if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
+                    _logger->error("Failed to delete connection from epoll");
+                }
+            }
             // Does it alive?
-            if (!pc->isAlive()) {
+            else if (!pc->isAlive()) {
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
                     _logger->error("Failed to delete connection from epoll");
                 }
 
+                pMetrics->Closed(pc->_socket);
                 close(pc->_socket);
                 pc->OnClose();
                 _connections.erase(pc); //Q: do we need mutex if we change set in OnRun and Stop?
@@ -177,6 +200,7 @@ void ServerImpl::OnRun() {
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
                     _logger->error("Failed to change connection event mask");
 
+                    pMetrics->Closed(pc->_socket);
                     close(pc->_socket);
                     pc->OnClose();
                     _connections.erase(pc);
@@ -188,6 +212,7 @@ void ServerImpl::OnRun() {
     _logger->warn("Acceptor stopped");
 
     for (auto& connection : _connections){
+        pMetrics->Closed(connection->_socket);
         close(connection->_socket);
         delete connection;
     }
@@ -196,6 +221,22 @@ void ServerImpl::OnRun() {
 
 }
 
+// See ServerImpl.h
+void ServerImpl::OnWakeup(int epoll_descr, Connection *pc) {
+    pc->Resume();
+    if (pc->_parked) {
+        return;
+    }
+
+    if (!pc->isAlive() || epoll_ctl(epoll_descr, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
+        pMetrics->Closed(pc->_socket);
+        close(pc->_socket);
+        pc->OnClose();
+        _connections.erase(pc);
+        delete pc;
+    }
+}
+
 void ServerImpl::OnNewConnection(int epoll_descr) {
     for (;;) {
         struct sockaddr in_addr;
@@ -213,6 +254,8 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
             }
         }
 
+        pMetrics->Opened(infd, &in_addr, in_len);
+
         // Print host and service info.
         char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
         int retval =
@@ -222,16 +265,21 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
         }
 
         // Register the new FD to be monitored by epoll.
-        Connection *pc = new(std::nothrow) Connection(infd, pStorage, _logger);
+        Connection *pc = new(std::nothrow) Connection(infd, pStorage, _logger, pMetrics.get());
         if (pc == nullptr) {
             throw std::runtime_error("Failed to allocate connection");
         }
 
+        // Commands waiting for the storage are resumed on this thread
+        std::shared_ptr<Wakeups> wakeups = _wakeups;
+        pc->_wakeup = [wakeups, pc]() { wakeups->Add(pc); };
+
         // Register connection in worker's epoll
         pc->Start();
         if (pc->isAlive()) {
             if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
                 pc->OnError();
+                pMetrics->Closed(infd);
                 delete pc;
             }
         }
@@ -25,7 +25,8 @@ class Worker;
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               std::shared_ptr<Afina::Metrics> pm);
     ~ServerImpl();
 
     // See Server.h
@@ -41,6 +42,9 @@ protected:
     void OnRun();
     void OnNewConnection(int);
 
+    // Resumes connection which command got ready, it is out of epoll till then
+    void OnWakeup(int, Connection *);
+
 private:
     // logger to use
     std::shared_ptr<spdlog::logger> _logger;
@@ -59,6 +63,9 @@ private:
     // IO thread
     std::thread _work_thread;
 
+    // Connections which commands waited for the storage and could go on, shared with storage callbacks
+    std::shared_ptr<Wakeups> _wakeups;
+
 
     //unordered - because of hashing - set of connections
     std::unordered_set<Connection*> _connections;
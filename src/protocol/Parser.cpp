@@ -4,11 +4,15 @@
 #include <sstream>
 #include <stdexcept>
 
+#include <afina/Metrics.h>
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Command.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/Prepend.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
 
@@ -28,12 +32,14 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::sName: {
             if (c == ' ' || c == '\r') {
                 // std::cout << "parser debug: name='" << name << "'" << std::endl;
-                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
+                if (name == "set" || name == "add" || name == "append" || name == "prepend" || name == "cas") {
                     state = State::spKey;
                 } else if (name == "get" || name == "gets") {
                     state = State::sgKey;
+                } else if (name == "incr" || name == "decr") {
+                    state = State::siKey;
                 } else if (name == "stats") {
-                    state = State::sLF;
+                    state = c == ' ' ? State::ssArgs : State::sLF;
                     continue;
                 } else {
                     throw std::runtime_error("Unknown command name: " + name);
@@ -77,6 +83,63 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             break;
         }
 
+        case State::ssArgs: {
+            if (c == '\r') {
+                if (!curKey.empty()) {
+                    keys.push_back(curKey);
+                    curKey.clear();
+                }
+                state = State::sLF;
+            } else if (c == ' ') {
+                if (!curKey.empty()) {
+                    keys.push_back(curKey);
+                    curKey.clear();
+                }
+            } else {
+                curKey.push_back(c);
+            }
+            break;
+        }
+
+        case State::siKey: {
+            if (c == ' ') {
+                state = State::siDeltaStart;
+                keys.push_back(curKey);
+                curKey.clear();
+            } else if (c == '\r' || c == '\n') {
+                throw std::runtime_error("Client provides no delta");
+            } else {
+                curKey.push_back(c);
+            }
+            break;
+        }
+
+        case State::siDeltaStart: {
+            if (c >= '0' && c <= '9') {
+                delta = (c - '0');
+                state = State::siDelta;
+            } else {
+                throw std::runtime_error("Delta field isn't a number");
+            }
+            break;
+        }
+
+        case State::siDelta: {
+            if (c == '\r') {
+                state = State::sLF;
+            } else if (c >= '0' && c <= '9') {
+                uint64_t d = (delta * 10) + (c - '0');
+                if (delta > UINT64_MAX / 10 || d < delta * 10) {
+                    // Overflow
+                    throw std::runtime_error("Delta field overflow");
+                }
+                delta = d;
+            } else {
+                throw std::runtime_error("Delta field isn't a number");
+            }
+            break;
+        }
+
         case State::spFlags: {
             if (c == ' ') {
                 negative = false;
@@ -96,6 +159,7 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::spExprTimeStart: {
             if (c == '-') {
                 negative = true;
+                exprtime = 0;
                 state = State::spExprTime;
             } else if (c >= '0' && c <= '9') {
                 exprtime = (c - '0');
@@ -109,17 +173,14 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
                 state = State::spBytes;
                 // std::cout << "parser debug: ExprTime='" << exprtime << "'" << std::endl;
             } else if (c >= '0' && c <= '9') {
-                int32_t et = exprtime;
+                int64_t et = int64_t(exprtime) * 10;
                 if (negative) {
                     et -= (c - '0');
-                    if (et > exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
                 } else {
                     et += (c - '0');
-                    if (et < exprtime) {
-                        throw std::runtime_error("Expire time field overflow");
-                    }
+                }
+                if (et > INT32_MAX || et < INT32_MIN) {
+                    throw std::runtime_error("Expire time field overflow");
                 }
                 exprtime = et;
             }
@@ -130,6 +191,8 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             if (c == '\r') {
                 state = State::sLF;
                 // std::cout << "parser debug: bytes='" << bytes << "'" << std::endl;
+            } else if (c == ' ' && name == "cas") {
+                state = State::spCas;
             } else if (c >= '0' && c <= '9') {
                 uint32_t b = (bytes * 10) + (c - '0');
                 if (b < bytes) {
@@ -141,6 +204,20 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             break;
         }
 
+        case State::spCas: {
+            if (c == '\r') {
+                state = State::sLF;
+            } else if (c >= '0' && c <= '9') {
+                uint64_t v = (cas * 10) + (c - '0');
+                if (cas > UINT64_MAX / 10 || v < cas * 10) {
+                    // Overflow
+                    throw std::runtime_error("Cas field overflow");
+                }
+                cas = v;
+            }
+            break;
+        }
+
         case State::sLF: {
             if (c == '\n') {
                 parse_complete = true;
@@ -168,16 +245,31 @@ std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
     }
 
     body_size = bytes;
+    Metrics::Command command;
+    if (metrics != nullptr && Metrics::CommandOf(name, command)) {
+        metrics->Count(command);
+    }
+
     if (name == "set") {
         return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime));
     } else if (name == "add") {
         return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
     } else if (name == "append") {
         return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
+    } else if (name == "prepend") {
+        return std::unique_ptr<Execute::Command>(new Execute::Prepend(keys[0], flags, exprtime));
+    } else if (name == "cas") {
+        return std::unique_ptr<Execute::Command>(new Execute::Cas(keys[0], flags, exprtime, cas));
     } else if (name == "get") {
         return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
+    } else if (name == "gets") {
+        return std::unique_ptr<Execute::Command>(new Execute::Get(keys, true));
+    } else if (name == "incr") {
+        return std::unique_ptr<Execute::Command>(new Execute::Incr(keys[0], delta));
+    } else if (name == "decr") {
+        return std::unique_ptr<Execute::Command>(new Execute::Incr(keys[0], delta, true));
     } else if (name == "stats") {
-        return std::unique_ptr<Execute::Command>(new Execute::Stats());
+        return std::unique_ptr<Execute::Command>(new Execute::Stats(metrics, keys));
     } else {
         throw std::runtime_error("Unsupported command");
     }
@@ -193,6 +285,8 @@ void Parser::Reset() {
     flags = 0;
     bytes = 0;
     exprtime = 0;
+    cas = 0;
+    delta = 0;
 }
 
 } // namespace Protocol
@@ -9,6 +9,7 @@
 #include <cstdint>
 
 namespace Afina {
+class Metrics;
 namespace Execute {
 class Command;
 } // namespace Execute
@@ -20,7 +21,11 @@ namespace Protocol {
  */
 class Parser {
 public:
-    Parser() { Reset(); }
+    /**
+     * Parser counts commands it builds in the given registry, if there is one. Stats command reports
+     * the registry
+     */
+    explicit Parser(Metrics *metrics = nullptr) : metrics(metrics) { Reset(); }
     /**
      * Push given string into parser input. Method returns true if it was a command parsed out
      * from comulative input. In a such case method Build will return new command
@@ -61,8 +66,28 @@ private:
      * - s: state for PUT and GET commands
      * - sp: for PUT commands only
      * - sg: for GET commands only
+     * - si: for INCR and DECR commands only
+     * - ss: for STATS command only
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    enum State : uint16_t {
+        sCR,
+        sLF,
+        sName,
+        spKey,
+        spFlags,
+        spExprTimeStart,
+        spExprTime,
+        spBytes,
+        spCas,
+        sgKey,
+        siKey,
+        siDeltaStart,
+        siDelta,
+        ssArgs
+    };
+
+    // Registry to count commands in, could be null
+    Metrics *metrics;
 
     // Current parser state
     State state;
@@ -88,6 +113,14 @@ private:
     // it's followed by an empty data block).
     uint32_t bytes;
 
+    // <cas unique> is a unique 64-bit value of an existing entry. Clients should use the value returned from the
+    // "gets" command when issuing "cas" updates.
+    uint64_t cas;
+
+    // <value> of "incr" and "decr" commands is the amount to change the item by, a decimal representation of a
+    // 64-bit unsigned integer
+    uint64_t delta;
+
     bool negative;
     std::string curKey;
     bool parse_complete;
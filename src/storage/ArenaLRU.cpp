@@ -0,0 +1,214 @@
+#include "ArenaLRU.h"
+
+#include <cstring>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Number of blocks moved by incremental compaction on each write
+const std::size_t kCompactMoves = 4;
+
+} // namespace
+
+ArenaLRU::ArenaLRU(size_t max_size)
+    : _max_size(max_size), _area(new char[max_size]), _arena(_area.get(), max_size), _lru_head(nullptr),
+      _lru_tail(nullptr) {}
+
+ArenaLRU::~ArenaLRU() {
+    // Arena memory goes away with _area, only nodes have to be deleted
+    _lru_index.Clear();
+    while (_lru_head != nullptr) {
+        lru_node *next = _lru_head->next;
+        delete _lru_head;
+        _lru_head = next;
+    }
+}
+
+// See ArenaLRU.h
+ArenaLRU::lru_node *ArenaLRU::find_node(const std::string &key, std::size_t hash) const {
+    return _lru_index.Find(hash, [&key](const lru_node &node) {
+        return node.key_size == key.size() && std::memcmp(node.key(), key.data(), key.size()) == 0;
+    });
+}
+
+// See ArenaLRU.h
+bool ArenaLRU::reserve(Afina::Allocator::Pointer &p, std::size_t size, const lru_node *keep) {
+    while (true) {
+        try {
+            _arena.realloc(p, size);
+            return true;
+        } catch (Afina::Allocator::AllocError &) {
+        }
+
+        // Holes are too small for the block, but there are too many of them to evict live data instead
+        if (_arena.holes() >= _max_size / 4) {
+            _arena.defrag();
+            continue;
+        }
+
+        if (_lru_head == nullptr || _lru_head == keep) {
+            // Nothing to evict anymore, the last chance is to join all the holes
+            if (_arena.holes() == 0) {
+                return false;
+            }
+            _arena.defrag();
+            continue;
+        }
+        delete_node(*_lru_head);
+        Count(StorageCounters::kEvictions);
+    }
+}
+
+// See ArenaLRU.h
+void ArenaLRU::compact() {
+    if (_arena.holes() > 0) {
+        _arena.defrag_step(kCompactMoves);
+    }
+}
+
+// add to the storage the element which exactly is not in storage
+bool ArenaLRU::add_element(const std::string &key, std::size_t hash, const std::string &value) {
+    if (!_arena.fits(key.size() + value.size())) {
+        return false; // no chances to put the element to the storage, so nothing is evicted for it
+    }
+
+    Afina::Allocator::Pointer data;
+    if (!reserve(data, key.size() + value.size(), nullptr)) {
+        return false;
+    }
+
+    lru_node *node = new lru_node{data, _lru_tail, nullptr, hash, uint32_t(key.size()), uint32_t(value.size())};
+    std::memcpy(node->key(), key.data(), key.size());
+    std::memcpy(node->value(), value.data(), value.size());
+    if (_lru_tail == nullptr) {
+        _lru_head = node;
+    } else {
+        _lru_tail->next = node;
+    }
+    _lru_tail = node;
+
+    _lru_index.Insert(hash, node);
+    Count(StorageCounters::kBytes, key.size() + value.size());
+    Count(StorageCounters::kItems);
+    compact();
+    return true;
+}
+
+// update value of the exactly existing element
+bool ArenaLRU::update_element(lru_node &node, const std::string &value) {
+    if (!_arena.fits(node.key_size + value.size())) {
+        return false;
+    }
+
+    // node goes to the tail first, so it won't be evicted while we free space for the new value. Key
+    // stays at the beginning of the block even if block gets moved
+    move_tail(node);
+    if (!reserve(node.data, node.key_size + value.size(), &node)) {
+        return false;
+    }
+
+    Count(StorageCounters::kBytes, int64_t(value.size()) - int64_t(node.value_size));
+    node.value_size = value.size();
+    std::memcpy(node.value(), value.data(), value.size());
+    compact();
+    return true;
+}
+
+// move the most recently used element to the tail
+void ArenaLRU::move_tail(lru_node &node) {
+    if (&node == _lru_tail) {
+        return;
+    }
+
+    // unlink, node is not a tail so it has next
+    if (node.prev == nullptr) {
+        _lru_head = node.next;
+    } else {
+        node.prev->next = node.next;
+    }
+    node.next->prev = node.prev;
+
+    // append
+    node.prev = _lru_tail;
+    node.next = nullptr;
+    _lru_tail->next = &node;
+    _lru_tail = &node;
+}
+
+// delete node that exactly exist
+void ArenaLRU::delete_node(lru_node &node) {
+    _arena.free(node.data);
+    Count(StorageCounters::kBytes, -int64_t(node.key_size + node.value_size));
+    _lru_index.Erase(node.hash, &node);
+
+    if (node.prev == nullptr) {
+        _lru_head = node.next;
+    } else {
+        node.prev->next = node.next;
+    }
+
+    if (node.next == nullptr) {
+        _lru_tail = node.prev;
+    } else {
+        node.next->prev = node.prev;
+    }
+
+    delete &node;
+    Count(StorageCounters::kItems, -1);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ArenaLRU::Put(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    lru_node *node = find_node(key, hash);
+    if (node == nullptr) {
+        return add_element(key, hash, value);
+    }
+    return update_element(*node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ArenaLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    if (find_node(key, hash) != nullptr) {
+        return false;
+    }
+    return add_element(key, hash, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ArenaLRU::Set(const std::string &key, const std::string &value) {
+    lru_node *node = find_node(key, _hash_func(key));
+    if (node == nullptr) {
+        return false;
+    }
+    return update_element(*node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ArenaLRU::Delete(const std::string &key) {
+    lru_node *node = find_node(key, _hash_func(key));
+    if (node == nullptr) {
+        return false;
+    }
+    delete_node(*node);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ArenaLRU::Get(const std::string &key, std::string &value) {
+    lru_node *node = find_node(key, _hash_func(key));
+    if (node == nullptr) {
+        return false;
+    }
+    value.assign(node->value(), node->value_size);
+    move_tail(*node);
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,120 @@
+#ifndef AFINA_STORAGE_ARENA_LRU_H
+#define AFINA_STORAGE_ARENA_LRU_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+
+#include "RobinHoodIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Arena based implementation
+ * Same LRU policy as in HashLRU, but keys and values live in the fixed size arena managed by
+ * Allocator::Simple. Nodes keep Allocator::Pointer handles instead of addresses, so the arena is free
+ * to move data around: each write compacts a few blocks, and full compaction happens only once a big
+ * part of the arena is lost in holes. Memory is never fragmented by long running churn of differently
+ * sized values, as it happens with malloc.
+ *
+ * max_size bounds arena size, that is keys, values and allocator overhead. Nodes with list links and
+ * index are kept outside of the arena.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class ArenaLRU : public Afina::Storage {
+public:
+    ArenaLRU(size_t max_size = 1024);
+
+    ~ArenaLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Allocator of the keys and values, for diagnostics
+    const Afina::Allocator::Simple &Arena() const { return _arena; }
+
+    // Bytes of max_size the item takes, allocator overhead included
+    static std::size_t ItemSize(std::size_t key_size, std::size_t value_size) {
+        return Afina::Allocator::Simple::footprint(key_size + value_size);
+    }
+
+private:
+    // LRU cache node
+    struct lru_node {
+        // key bytes followed by value bytes, could be moved by the arena at any write
+        Afina::Allocator::Pointer data;
+        lru_node *prev;
+        lru_node *next;
+        // hash of the key, cached to not recompute it on eviction and index growth
+        const std::size_t hash;
+        uint32_t key_size;
+        uint32_t value_size;
+
+        char *key() const { return static_cast<char *>(data.get()); }
+        char *value() const { return key() + key_size; }
+    };
+
+    struct node_hash {
+        std::size_t operator()(const lru_node &node) const { return node.hash; }
+    };
+
+    // Maximum number of bytes in the arena
+    std::size_t _max_size;
+
+    std::unique_ptr<char[]> _area;
+    Afina::Allocator::Simple _arena;
+
+    // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
+    // element that wasn't used for longest time.
+    //
+    // List owns all nodes
+    lru_node *_lru_head;
+    lru_node *_lru_tail;
+
+    // Index of nodes from list above, allows fast random access to elements by key
+    RobinHoodIndex<lru_node, node_hash> _lru_index;
+
+    std::hash<std::string> _hash_func;
+
+private:
+    // find node by key and its hash
+    lru_node *find_node(const std::string &key, std::size_t hash) const;
+    // move the most recently used element to tail
+    void move_tail(lru_node &node);
+    // add new element to the storage
+    bool add_element(const std::string &key, std::size_t hash, const std::string &value);
+    // update existing node
+    bool update_element(lru_node &node, const std::string &value);
+    // delete existing node
+    void delete_node(lru_node &node);
+
+    // (re)allocates arena block for size bytes evicting old nodes, but never the keep one. Returns false
+    // if block doesn't fit even into the empty arena, p is left untouched in that case
+    bool reserve(Afina::Allocator::Pointer &p, std::size_t size, const lru_node *keep);
+    // incremental compaction step done by each write
+    void compact();
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ARENA_LRU_H
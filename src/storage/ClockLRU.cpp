@@ -0,0 +1,149 @@
+#include "ClockLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+ClockLRU::~ClockLRU() {
+    _index.Clear();
+    for (clock_node *node : _ring) {
+        delete node;
+    }
+}
+
+// See ClockLRU.h
+ClockLRU::clock_node *ClockLRU::find_node(const std::string &key, std::size_t hash) const {
+    return _index.Find(hash, [&key](const clock_node &node) { return node.key == key; });
+}
+
+// See ClockLRU.h
+void ClockLRU::evict(const clock_node *keep) {
+    while (true) {
+        if (_hand >= _ring.size()) {
+            _hand = 0;
+        }
+
+        clock_node *node = _ring[_hand++];
+        if (node == nullptr || node == keep) {
+            continue;
+        }
+        if (node->referenced) {
+            // Second chance
+            node->referenced = false;
+            continue;
+        }
+
+        delete_node(*node);
+        Count(StorageCounters::kEvictions);
+        return;
+    }
+}
+
+// add to the storage the element which exactly is not in storage
+bool ClockLRU::add_element(const std::string &key, std::size_t hash, const std::string &value) {
+    std::size_t addsize = key.size() + value.size();
+    if (addsize > _max_size) {
+        return false; // no chances to put the element to the storage
+    }
+
+    while (addsize + _cur_size > _max_size) {
+        evict(nullptr);
+    }
+
+    // New node takes place of the evicted one, so hand reaches it only after the full sweep
+    clock_node *node = new clock_node{key, value, hash, 0, false};
+    if (_ring_free.empty()) {
+        node->position = _ring.size();
+        _ring.push_back(node);
+    } else {
+        node->position = _ring_free.back();
+        _ring_free.pop_back();
+        _ring[node->position] = node;
+    }
+
+    _index.Insert(hash, node);
+    _cur_size += addsize;
+    Count(StorageCounters::kBytes, addsize);
+    Count(StorageCounters::kItems);
+    return true;
+}
+
+// update value of the exactly existing element
+bool ClockLRU::update_element(clock_node &node, const std::string &value) {
+    if (node.key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    while (_cur_size - node.value.size() + value.size() > _max_size) {
+        evict(&node);
+    }
+
+    _cur_size = _cur_size - node.value.size() + value.size();
+    Count(StorageCounters::kBytes, int64_t(value.size()) - int64_t(node.value.size()));
+    node.value = value;
+    node.referenced = true;
+    return true;
+}
+
+// delete node that exactly exist
+void ClockLRU::delete_node(clock_node &node) {
+    _cur_size -= node.key.size() + node.value.size();
+    Count(StorageCounters::kBytes, -int64_t(node.key.size() + node.value.size()));
+    _index.Erase(node.hash, &node);
+
+    _ring[node.position] = nullptr;
+    _ring_free.push_back(node.position);
+    delete &node;
+    Count(StorageCounters::kItems, -1);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Put(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    clock_node *node = find_node(key, hash);
+    if (node == nullptr) {
+        return add_element(key, hash, value);
+    }
+    return update_element(*node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    if (find_node(key, hash) != nullptr) {
+        return false;
+    }
+    return add_element(key, hash, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Set(const std::string &key, const std::string &value) {
+    clock_node *node = find_node(key, _hash_func(key));
+    if (node == nullptr) {
+        return false;
+    }
+    return update_element(*node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Delete(const std::string &key) {
+    clock_node *node = find_node(key, _hash_func(key));
+    if (node == nullptr) {
+        return false;
+    }
+    delete_node(*node);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool ClockLRU::Get(const std::string &key, std::string &value) {
+    clock_node *node = find_node(key, _hash_func(key));
+    if (node == nullptr) {
+        return false;
+    }
+    value = node->value;
+    node->referenced = true;
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
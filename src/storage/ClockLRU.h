@@ -0,0 +1,95 @@
+#ifndef AFINA_STORAGE_CLOCK_LRU_H
+#define AFINA_STORAGE_CLOCK_LRU_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "RobinHoodIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # CLOCK implementation
+ * Approximates LRU with the second chance algorithm. Nodes sit in a circular buffer, hit only sets the
+ * reference bit of the node, nothing is relinked. To free space hand sweeps the buffer: referenced node
+ * gets its bit cleared and survives, the first node without the bit is evicted.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class ClockLRU : public Afina::Storage {
+public:
+    ClockLRU(size_t max_size = 1024) : _max_size(max_size), _cur_size(0), _hand(0) {}
+
+    ~ClockLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Number of ring slots, both taken and free ones
+    std::size_t RingSize() const { return _ring.size(); }
+
+private:
+    // CLOCK cache node
+    struct clock_node {
+        const std::string key;
+        std::string value;
+        // hash of the key, cached to not recompute it on eviction and index growth
+        const std::size_t hash;
+        // position in the ring
+        std::size_t position;
+        // node was used since the last sweep
+        bool referenced;
+    };
+
+    struct node_hash {
+        std::size_t operator()(const clock_node &node) const { return node.hash; }
+    };
+
+    // Maximum number of bytes could be stored in this cache.
+    // i.e all (keys+values) must be less the _max_size
+    std::size_t _max_size;
+    std::size_t _cur_size;
+
+    // Circular buffer of nodes, nullptr marks free position. Ring owns all nodes
+    std::vector<clock_node *> _ring;
+    std::vector<std::size_t> _ring_free;
+    std::size_t _hand;
+
+    // Index of nodes from ring above, allows fast random access to elements by clock_node#key
+    RobinHoodIndex<clock_node, node_hash> _index;
+
+    std::hash<std::string> _hash_func;
+
+private:
+    // find node by key and its hash
+    clock_node *find_node(const std::string &key, std::size_t hash) const;
+    // add new element to the storage
+    bool add_element(const std::string &key, std::size_t hash, const std::string &value);
+    // update existing node
+    bool update_element(clock_node &node, const std::string &value);
+    // delete existing node
+    void delete_node(clock_node &node);
+    // sweeps the ring and evicts one node, but never the keep one
+    void evict(const clock_node *keep);
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CLOCK_LRU_H
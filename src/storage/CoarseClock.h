@@ -0,0 +1,35 @@
+#ifndef AFINA_STORAGE_COARSE_CLOCK_H
+#define AFINA_STORAGE_COARSE_CLOCK_H
+
+#include <cstdint>
+#include <time.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Clock for expiration checks
+ * Whole seconds of CLOCK_MONOTONIC_COARSE: kernel keeps the value cached in the vDSO page and updates it
+ * on timer interrupt, so reading it costs a couple of loads without a syscall or rdtsc. Precision of a
+ * few milliseconds is more than enough for expiration times given in seconds.
+ */
+class CoarseClock {
+public:
+    static uint32_t Now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return uint32_t(ts.tv_sec);
+    }
+
+    // Milliseconds of the same clock, wraps around every 49 days
+    static uint32_t NowMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return uint32_t(uint64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000);
+    }
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_COARSE_CLOCK_H
@@ -0,0 +1,132 @@
+#include "CountedStorage.h"
+
+namespace Afina {
+namespace Backend {
+
+CountedStorage::CountedStorage(std::shared_ptr<Afina::Storage> storage, std::shared_ptr<StorageCounters> counters)
+    : _storage(std::move(storage)) {
+    SetCounters(std::move(counters));
+}
+
+// See CountedStorage.h
+void CountedStorage::Start() { _storage->Start(); }
+
+// See CountedStorage.h
+void CountedStorage::Stop() { _storage->Stop(); }
+
+// See CountedStorage.h
+void CountedStorage::SetCounters(std::shared_ptr<StorageCounters> counters) {
+    _stats = counters;
+    _storage->SetCounters(std::move(counters));
+}
+
+// See CountedStorage.h
+bool CountedStorage::Put(const std::string &key, const std::string &value) {
+    _stats->Stored(value.size());
+    return _storage->Put(key, value);
+}
+
+// See CountedStorage.h
+bool CountedStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    _stats->Stored(value.size());
+    return _storage->PutIfAbsent(key, value);
+}
+
+// See CountedStorage.h
+bool CountedStorage::Set(const std::string &key, const std::string &value) {
+    _stats->Stored(value.size());
+    return _storage->Set(key, value);
+}
+
+// See CountedStorage.h
+bool CountedStorage::Delete(const std::string &key) { return _storage->Delete(key); }
+
+// See CountedStorage.h
+bool CountedStorage::Get(const std::string &key, std::string &value) {
+    bool found = _storage->Get(key, value);
+    _stats->Got(found, value.size());
+    return found;
+}
+
+// See CountedStorage.h
+bool CountedStorage::PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    _stats->Stored(value.size());
+    return _storage->PutWithTTL(key, value, ttl);
+}
+
+// See CountedStorage.h
+bool CountedStorage::PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    _stats->Stored(value.size());
+    return _storage->PutIfAbsentWithTTL(key, value, ttl);
+}
+
+// See CountedStorage.h
+bool CountedStorage::SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    _stats->Stored(value.size());
+    return _storage->SetWithTTL(key, value, ttl);
+}
+
+// See CountedStorage.h
+bool CountedStorage::GetView(const std::string &key, ValueView &value) {
+    bool found = _storage->GetView(key, value);
+    _stats->Got(found, value.size());
+    return found;
+}
+
+// See CountedStorage.h
+bool CountedStorage::Append(const std::string &key, const std::string &data) {
+    _stats->Stored(data.size());
+    return _storage->Append(key, data);
+}
+
+// See CountedStorage.h
+bool CountedStorage::Prepend(const std::string &key, const std::string &data) {
+    _stats->Stored(data.size());
+    return _storage->Prepend(key, data);
+}
+
+// See CountedStorage.h
+std::size_t CountedStorage::MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) {
+    std::size_t found = _storage->MultiGet(keys, values);
+    for (std::size_t i = 0; i < values.size(); i++) {
+        _stats->Got(values[i].valid(), values[i].size());
+    }
+    return found;
+}
+
+// See CountedStorage.h
+bool CountedStorage::Prepare(const std::vector<std::string> &keys, std::function<void()> ready) {
+    return _storage->Prepare(keys, std::move(ready));
+}
+
+// See CountedStorage.h
+bool CountedStorage::GetWithVersion(const std::string &key, std::string &value, uint64_t &version) {
+    bool found = _storage->GetWithVersion(key, value, version);
+    _stats->Got(found, value.size());
+    return found;
+}
+
+// See CountedStorage.h
+bool CountedStorage::CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl,
+                                   uint64_t &version) {
+    _stats->Stored(value.size());
+    return _storage->CompareAndSet(key, value, ttl, version);
+}
+
+// See CountedStorage.h
+bool CountedStorage::Dump(const std::function<void(std::vector<StoredItem> &part)> &write) {
+    return _storage->Dump(write);
+}
+
+// See CountedStorage.h
+bool CountedStorage::Increment(const std::string &key, uint64_t delta, uint64_t &number) {
+    return _storage->Increment(key, delta, number);
+}
+
+// See CountedStorage.h
+bool CountedStorage::Decrement(const std::string &key, uint64_t delta, uint64_t &number) {
+    return _storage->Decrement(key, delta, number);
+}
+
+} // namespace Backend
+} // namespace Afina
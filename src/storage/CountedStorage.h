@@ -0,0 +1,100 @@
+#ifndef AFINA_STORAGE_COUNTED_STORAGE_H
+#define AFINA_STORAGE_COUNTED_STORAGE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage that counts requests to the other one
+ * Counts gets, hits, misses, writes and value bytes going in and out at the interface, so it works with
+ * any storage; items and evictions are reported by the storage itself, see Storage::SetCounters. All the
+ * counters are per core, see StorageCounters, so counting doesn't add contention between threads.
+ *
+ * Gets of MultiGet are counted one by one, as memcached does for multi key get. Delete and arithmetic
+ * commands are not counted.
+ */
+class CountedStorage : public Afina::Storage {
+public:
+    explicit CountedStorage(std::shared_ptr<Afina::Storage> storage,
+                            std::shared_ptr<StorageCounters> counters = std::make_shared<StorageCounters>());
+
+    const StorageCounters &Counters() const { return *_stats; }
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    void SetCounters(std::shared_ptr<StorageCounters> counters) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool GetView(const std::string &key, ValueView &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) override;
+
+    // Implements Afina::Storage interface
+    bool Prepare(const std::vector<std::string> &keys, std::function<void()> ready) override;
+
+    // Implements Afina::Storage interface
+    bool GetWithVersion(const std::string &key, std::string &value, uint64_t &version) override;
+
+    // Implements Afina::Storage interface
+    bool CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl, uint64_t &version) override;
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::vector<StoredItem> &part)> &write) override;
+
+    // Implements Afina::Storage interface
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+    // Implements Afina::Storage interface
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+private:
+    std::shared_ptr<Afina::Storage> _storage;
+    std::shared_ptr<StorageCounters> _stats;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_COUNTED_STORAGE_H
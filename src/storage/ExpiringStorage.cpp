@@ -0,0 +1,245 @@
+#include "ExpiringStorage.h"
+
+#include <algorithm>
+
+#include "CoarseClock.h"
+#include "Hash.h"
+
+namespace Afina {
+namespace Backend {
+
+const std::size_t ExpiringStorage::kStripes;
+const std::size_t ExpiringStorage::kMinSweep;
+
+ExpiringStorage::ExpiringStorage(std::shared_ptr<Afina::Storage> storage)
+    : _storage(std::move(storage)), _expiring(0), _stripes(new stripe[kStripes]) {}
+
+// See ExpiringStorage.h
+void ExpiringStorage::Start() { _storage->Start(); }
+
+// See ExpiringStorage.h
+void ExpiringStorage::Stop() { _storage->Stop(); }
+
+// See ExpiringStorage.h
+void ExpiringStorage::SetCounters(std::shared_ptr<StorageCounters> counters) {
+    _storage->SetCounters(std::move(counters));
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::Put(const std::string &key, const std::string &value) { return PutWithTTL(key, value, 0); }
+
+// See ExpiringStorage.h
+bool ExpiringStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    return PutIfAbsentWithTTL(key, value, 0);
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::Set(const std::string &key, const std::string &value) { return SetWithTTL(key, value, 0); }
+
+// See ExpiringStorage.h
+bool ExpiringStorage::Delete(const std::string &key) {
+    stripe &s = stripe_of(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    expire(s, key, CoarseClock::Now());
+    set_deadline(s, key, 0);
+    return _storage->Delete(key);
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::Get(const std::string &key, std::string &value) {
+    check(key);
+    return _storage->Get(key, value);
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    stripe &s = stripe_of(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    if (!_storage->Put(key, value)) {
+        return false;
+    }
+    set_deadline(s, key, ttl);
+    return true;
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    stripe &s = stripe_of(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    expire(s, key, CoarseClock::Now());
+    if (!_storage->PutIfAbsent(key, value)) {
+        return false;
+    }
+    set_deadline(s, key, ttl);
+    return true;
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    stripe &s = stripe_of(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    expire(s, key, CoarseClock::Now());
+    if (!_storage->Set(key, value)) {
+        return false;
+    }
+    set_deadline(s, key, ttl);
+    return true;
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::GetView(const std::string &key, ValueView &value) {
+    check(key);
+    return _storage->GetView(key, value);
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::Append(const std::string &key, const std::string &data) {
+    stripe &s = stripe_of(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    expire(s, key, CoarseClock::Now());
+    return _storage->Append(key, data);
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::Prepend(const std::string &key, const std::string &data) {
+    stripe &s = stripe_of(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    expire(s, key, CoarseClock::Now());
+    return _storage->Prepend(key, data);
+}
+
+// See ExpiringStorage.h
+std::size_t ExpiringStorage::MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) {
+    for (auto &key : keys) {
+        check(key);
+    }
+    return _storage->MultiGet(keys, values);
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::Prepare(const std::vector<std::string> &keys, std::function<void()> ready) {
+    return _storage->Prepare(keys, std::move(ready));
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::GetWithVersion(const std::string &key, std::string &value, uint64_t &version) {
+    check(key);
+    return _storage->GetWithVersion(key, value, version);
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl,
+                                    uint64_t &version) {
+    stripe &s = stripe_of(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    expire(s, key, CoarseClock::Now());
+    if (!_storage->CompareAndSet(key, value, ttl, version)) {
+        return false;
+    }
+    set_deadline(s, key, ttl);
+    return true;
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::Dump(const std::function<void(std::vector<StoredItem> &part)> &write) {
+    // Storage may call write under its own locks, so stripes are copied beforehand and not locked from write
+    std::unordered_map<std::string, uint32_t> deadlines;
+    for (std::size_t i = 0; i < kStripes; i++) {
+        std::lock_guard<std::mutex> lock(_stripes[i].lock);
+        deadlines.insert(_stripes[i].deadlines.begin(), _stripes[i].deadlines.end());
+    }
+
+    uint32_t now = CoarseClock::Now();
+    return _storage->Dump([&deadlines, now, &write](std::vector<StoredItem> &part) {
+        auto alive = std::remove_if(part.begin(), part.end(), [&deadlines, now](StoredItem &item) {
+            auto it = deadlines.find(std::string(item.key.data(), item.key.size()));
+            if (it == deadlines.end()) {
+                return false;
+            }
+            item.ttl = it->second - now;
+            return int32_t(item.ttl) <= 0;
+        });
+        part.erase(alive, part.end());
+        write(part);
+    });
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::Increment(const std::string &key, uint64_t delta, uint64_t &number) {
+    stripe &s = stripe_of(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    expire(s, key, CoarseClock::Now());
+    return _storage->Increment(key, delta, number);
+}
+
+// See ExpiringStorage.h
+bool ExpiringStorage::Decrement(const std::string &key, uint64_t delta, uint64_t &number) {
+    stripe &s = stripe_of(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    expire(s, key, CoarseClock::Now());
+    return _storage->Decrement(key, delta, number);
+}
+
+// See ExpiringStorage.h
+ExpiringStorage::stripe &ExpiringStorage::stripe_of(const std::string &key) {
+    return _stripes[WyHash(key, 0) % kStripes];
+}
+
+// See ExpiringStorage.h
+void ExpiringStorage::expire(stripe &s, const std::string &key, uint32_t now) {
+    auto it = s.deadlines.find(key);
+    if (it == s.deadlines.end() || int32_t(now - it->second) < 0) {
+        return;
+    }
+    s.deadlines.erase(it);
+    _expiring.fetch_sub(1, std::memory_order_relaxed);
+    _storage->Delete(key);
+}
+
+// See ExpiringStorage.h
+void ExpiringStorage::set_deadline(stripe &s, const std::string &key, uint32_t ttl) {
+    if (ttl == 0) {
+        if (s.deadlines.erase(key) > 0) {
+            _expiring.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    uint32_t now = CoarseClock::Now();
+    auto result = s.deadlines.emplace(key, now + ttl);
+    if (!result.second) {
+        result.first->second = now + ttl;
+        return;
+    }
+    _expiring.fetch_add(1, std::memory_order_relaxed);
+    if (s.deadlines.size() >= s.sweep_at) {
+        sweep(s, now);
+        s.sweep_at = std::max(kMinSweep, 2 * s.deadlines.size());
+    }
+}
+
+// See ExpiringStorage.h
+void ExpiringStorage::sweep(stripe &s, uint32_t now) {
+    for (auto it = s.deadlines.begin(); it != s.deadlines.end();) {
+        if (int32_t(now - it->second) < 0) {
+            ++it;
+            continue;
+        }
+        _storage->Delete(it->first);
+        it = s.deadlines.erase(it);
+        _expiring.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// See ExpiringStorage.h
+void ExpiringStorage::check(const std::string &key) {
+    if (Deadlines() == 0) {
+        return;
+    }
+    stripe &s = stripe_of(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    expire(s, key, CoarseClock::Now());
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,136 @@
+#ifndef AFINA_STORAGE_EXPIRING_STORAGE_H
+#define AFINA_STORAGE_EXPIRING_STORAGE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage that expires items of the other one
+ * For storages which can't expire items on their own: keeps deadline of every key stored with ttl and
+ * checks it lazily, before the key is read or updated. Expired key is deleted from the storage, so it is
+ * not found from then on, as if the storage had expired it itself.
+ *
+ * Deadlines are split into kStripes by key hash, each under its own lock. Writes and updates of the key
+ * hold the lock of its stripe together with the call of the storage, so expiration never deletes a value
+ * stored after the deadline was checked. Until some key gets ttl nothing is locked at all.
+ *
+ * Storage evicts keys without telling, so stripe sweeps its deadlines once their number doubles since
+ * the previous sweep: expired keys are deleted from the storage and forgotten, the rest stay. Deadlines
+ * live in memory only, items left in a mapped file by the previous process never expire.
+ */
+class ExpiringStorage : public Afina::Storage {
+public:
+    explicit ExpiringStorage(std::shared_ptr<Afina::Storage> storage);
+
+    // Number of keys with deadline, including expired ones not swept yet
+    std::size_t Deadlines() const { return _expiring.load(std::memory_order_relaxed); }
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    void SetCounters(std::shared_ptr<StorageCounters> counters) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool GetView(const std::string &key, ValueView &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) override;
+
+    // Implements Afina::Storage interface
+    bool Prepare(const std::vector<std::string> &keys, std::function<void()> ready) override;
+
+    // Implements Afina::Storage interface
+    bool GetWithVersion(const std::string &key, std::string &value, uint64_t &version) override;
+
+    // Implements Afina::Storage interface
+    bool CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl, uint64_t &version) override;
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::vector<StoredItem> &part)> &write) override;
+
+    // Implements Afina::Storage interface
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+    // Implements Afina::Storage interface
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+private:
+    static const std::size_t kStripes = 64;
+    // Stripe doesn't sweep below that number of deadlines
+    static const std::size_t kMinSweep = 64;
+
+    struct stripe {
+        std::mutex lock;
+        // Second of CoarseClock the key expires at
+        std::unordered_map<std::string, uint32_t> deadlines;
+        // Number of deadlines the next sweep happens at
+        std::size_t sweep_at = kMinSweep;
+    };
+
+    stripe &stripe_of(const std::string &key);
+
+    // Deletes the key from the storage if it has expired, stripe lock must be held
+    void expire(stripe &s, const std::string &key, uint32_t now);
+
+    // Remembers the deadline of just stored key, zero ttl forgets it; stripe lock must be held
+    void set_deadline(stripe &s, const std::string &key, uint32_t ttl);
+
+    // Deletes all expired keys of the stripe, its lock must be held
+    void sweep(stripe &s, uint32_t now);
+
+    // Deletes the key if it has expired, before the key is read
+    void check(const std::string &key);
+
+    std::shared_ptr<Afina::Storage> _storage;
+    // Total number of deadlines, nothing expires while it is zero
+    std::atomic<std::size_t> _expiring;
+    std::unique_ptr<stripe[]> _stripes;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EXPIRING_STORAGE_H
@@ -0,0 +1,91 @@
+#ifndef AFINA_STORAGE_FREQUENCY_SKETCH_H
+#define AFINA_STORAGE_FREQUENCY_SKETCH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Count-min sketch of access frequencies
+ * Keeps approximate number of accesses for each key hash in kDepth rows of small saturating counters,
+ * estimate is the minimum over the rows. Counters are four bits wide, two of them share a byte.
+ * Once the number of increments reaches twenty times the width all counters are halved, so the sketch
+ * forgets old history and follows popularity changes. Twenty, as a miss is usually counted twice: by get
+ * and by the put that follows it.
+ */
+class FrequencySketch {
+public:
+    explicit FrequencySketch(std::size_t width) : _additions(0) {
+        std::size_t capacity = 64;
+        while (capacity < width) {
+            capacity *= 2;
+        }
+        _mask = capacity - 1;
+        _sample_size = 20 * capacity;
+        _counters.assign(kDepth * capacity / 2, 0);
+    }
+
+    void Increment(std::size_t hash) {
+        bool added = false;
+        for (int row = 0; row < kDepth; row++) {
+            std::size_t index = index_of(hash, row);
+            if (counter(index) < kMaxCount) {
+                _counters[index / 2] += uint8_t(1) << shift_of(index);
+                added = true;
+            }
+        }
+
+        if (added && ++_additions >= _sample_size) {
+            Age();
+        }
+    }
+
+    uint8_t Estimate(std::size_t hash) const {
+        uint8_t result = kMaxCount;
+        for (int row = 0; row < kDepth; row++) {
+            result = std::min(result, counter(index_of(hash, row)));
+        }
+        return result;
+    }
+
+    // Memory taken by the counters
+    std::size_t Bytes() const { return _counters.size(); }
+
+    // Halves all counters
+    void Age() {
+        for (uint8_t &pair : _counters) {
+            pair = (pair >> 1) & 0x77;
+        }
+        _additions /= 2;
+    }
+
+private:
+    static const int kDepth = 4;
+    static const uint8_t kMaxCount = 15;
+
+    // Each row uses its own mix of the hash, so keys colliding in one row rarely collide in others
+    std::size_t index_of(std::size_t hash, int row) const {
+        uint64_t h = uint64_t(hash) + uint64_t(row + 1) * 0x9E3779B97F4A7C15ull;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+        h ^= h >> 31;
+        return row * (_mask + 1) + (h & _mask);
+    }
+
+    static int shift_of(std::size_t index) { return (index & 1) * 4; }
+    uint8_t counter(std::size_t index) const { return (_counters[index / 2] >> shift_of(index)) & kMaxCount; }
+
+    std::size_t _mask;
+    std::size_t _sample_size;
+    std::size_t _additions;
+    std::vector<uint8_t> _counters;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FREQUENCY_SKETCH_H
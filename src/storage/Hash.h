@@ -0,0 +1,90 @@
+#ifndef AFINA_STORAGE_HASH_H
+#define AFINA_STORAGE_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+namespace detail {
+
+const uint64_t kWySecret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull,
+                               0x589965cc75374cc3ull};
+
+// 64x64 -> 128 bit multiplication folded back to 64 bits
+inline uint64_t wymix(uint64_t a, uint64_t b) {
+    __uint128_t r = __uint128_t(a) * b;
+    return uint64_t(r) ^ uint64_t(r >> 64);
+}
+
+inline uint64_t wyread64(const uint8_t *p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t wyread32(const uint8_t *p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace detail
+
+/**
+ * wyhash of the byte string: a couple of multiplications per 16 bytes, good enough distribution to take
+ * low bits as a bucket number. Different seeds give independent hash functions
+ */
+inline uint64_t WyHash(const void *data, std::size_t len, uint64_t seed) {
+    using namespace detail;
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    seed ^= wymix(seed ^ kWySecret[0], kWySecret[1]);
+
+    uint64_t a, b;
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (wyread32(p) << 32) | wyread32(p + ((len >> 3) << 2));
+            b = (wyread32(p + len - 4) << 32) | wyread32(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = (uint64_t(p[0]) << 16) | (uint64_t(p[len >> 1]) << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        std::size_t i = len;
+        if (i > 48) {
+            uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed = wymix(wyread64(p) ^ kWySecret[1], wyread64(p + 8) ^ seed);
+                seed1 = wymix(wyread64(p + 16) ^ kWySecret[2], wyread64(p + 24) ^ seed1);
+                seed2 = wymix(wyread64(p + 32) ^ kWySecret[3], wyread64(p + 40) ^ seed2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (i > 16) {
+            seed = wymix(wyread64(p) ^ kWySecret[1], wyread64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wyread64(p + i - 16);
+        b = wyread64(p + i - 8);
+    }
+
+    a ^= kWySecret[1];
+    b ^= seed;
+    __uint128_t r = __uint128_t(a) * b;
+    return wymix(uint64_t(r) ^ kWySecret[0] ^ len, uint64_t(r >> 64) ^ kWySecret[1]);
+}
+
+inline uint64_t WyHash(const std::string &s, uint64_t seed) { return WyHash(s.data(), s.size(), seed); }
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_H
@@ -0,0 +1,184 @@
+#include "HashLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+HashLRU::~HashLRU() {
+    _lru_index.Clear();
+    while (_lru_head != nullptr) {
+        lru_node *next = _lru_head->next;
+        delete _lru_head;
+        _lru_head = next;
+    }
+}
+
+// See HashLRU.h
+HashLRU::lru_node *HashLRU::find_node(const std::string &key, std::size_t hash) const {
+    return _lru_index.Find(hash, [&key](const lru_node &node) { return node.key == key; });
+}
+
+// add to the storage the element which exactly is not in storage
+bool HashLRU::add_element(const std::string &key, std::size_t hash, const std::string &value) {
+    std::size_t addsize = key.size() + value.size();
+    if (addsize > _max_size) {
+        return false; // no chances to put the element to the storage
+    }
+
+    while (addsize + _cur_size > _max_size) {
+        delete_node(*_lru_head);
+        Count(StorageCounters::kEvictions);
+    }
+
+    lru_node *node = new lru_node{key, value, hash, _lru_tail, nullptr};
+    if (_lru_tail == nullptr) {
+        _lru_head = node;
+    } else {
+        _lru_tail->next = node;
+    }
+    _lru_tail = node;
+
+    _lru_index.Insert(hash, node);
+    _cur_size += addsize;
+    Count(StorageCounters::kBytes, addsize);
+    Count(StorageCounters::kItems);
+    return true;
+}
+
+// update value of the exactly existing element
+bool HashLRU::update_element(lru_node &node, const std::string &value) {
+    if (node.key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    // node goes to the tail first, so it won't be evicted while we free space for the new value
+    move_tail(node);
+
+    while (_cur_size - node.value.size() + value.size() > _max_size) {
+        delete_node(*_lru_head);
+        Count(StorageCounters::kEvictions);
+    }
+
+    _cur_size = _cur_size - node.value.size() + value.size();
+    Count(StorageCounters::kBytes, int64_t(value.size()) - int64_t(node.value.size()));
+    node.value = value;
+    return true;
+}
+
+// move the most recently used element to the tail
+void HashLRU::move_tail(lru_node &node) {
+    if (&node == _lru_tail) {
+        return;
+    }
+
+    // unlink, node is not a tail so it has next
+    if (node.prev == nullptr) {
+        _lru_head = node.next;
+    } else {
+        node.prev->next = node.next;
+    }
+    node.next->prev = node.prev;
+
+    // append
+    node.prev = _lru_tail;
+    node.next = nullptr;
+    _lru_tail->next = &node;
+    _lru_tail = &node;
+}
+
+// delete node that exactly exist
+void HashLRU::delete_node(lru_node &node) {
+    _cur_size -= node.key.size() + node.value.size();
+    Count(StorageCounters::kBytes, -int64_t(node.key.size() + node.value.size()));
+    _lru_index.Erase(node.hash, &node);
+
+    if (node.prev == nullptr) {
+        _lru_head = node.next;
+    } else {
+        node.prev->next = node.next;
+    }
+
+    if (node.next == nullptr) {
+        _lru_tail = node.prev;
+    } else {
+        node.next->prev = node.prev;
+    }
+
+    delete &node;
+    Count(StorageCounters::kItems, -1);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool HashLRU::Put(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    lru_node *node = find_node(key, hash);
+    if (node == nullptr) {
+        return add_element(key, hash, value);
+    }
+    return update_element(*node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool HashLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    if (find_node(key, hash) != nullptr) {
+        return false;
+    }
+    return add_element(key, hash, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool HashLRU::Set(const std::string &key, const std::string &value) {
+    lru_node *node = find_node(key, _hash_func(key));
+    if (node == nullptr) {
+        return false;
+    }
+    return update_element(*node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool HashLRU::Delete(const std::string &key) {
+    lru_node *node = find_node(key, _hash_func(key));
+    if (node == nullptr) {
+        return false;
+    }
+    delete_node(*node);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool HashLRU::Get(const std::string &key, std::string &value) {
+    lru_node *node = find_node(key, _hash_func(key));
+    if (node == nullptr) {
+        return false;
+    }
+    value = node->value;
+    move_tail(*node);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+std::size_t HashLRU::MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) {
+    values.assign(keys.size(), ValueView());
+
+    // All the hashes are computed first and home slot of each one is prefetched right away, so slots of
+    // different keys are loaded from memory in parallel with hashing of the next keys
+    std::vector<std::size_t> hashes(keys.size());
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        hashes[i] = _hash_func(keys[i]);
+        _lru_index.Prefetch(hashes[i]);
+    }
+
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        lru_node *node = find_node(keys[i], hashes[i]);
+        if (node != nullptr) {
+            values[i] = ValueView(node->value);
+            move_tail(*node);
+            found++;
+        }
+    }
+    return found;
+}
+
+} // namespace Backend
+} // namespace Afina
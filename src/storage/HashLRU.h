@@ -0,0 +1,94 @@
+#ifndef AFINA_STORAGE_HASH_LRU_H
+#define AFINA_STORAGE_HASH_LRU_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "RobinHoodIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hash based implementation
+ * Same LRU policy as in SimpleLRU, but nodes are indexed by open addressing hash table instead of the tree,
+ * so lookup costs one hash computation and a short linear probe instead of O(log n) string compares.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class HashLRU : public Afina::Storage {
+public:
+    HashLRU(size_t max_size = 1024) : _max_size(max_size), _cur_size(0), _lru_head(nullptr), _lru_tail(nullptr) {}
+
+    ~HashLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) override;
+
+private:
+    // LRU cache node
+    struct lru_node {
+        const std::string key;
+        std::string value;
+        // hash of the key, cached to not recompute it on eviction and index growth
+        const std::size_t hash;
+        lru_node *prev;
+        lru_node *next;
+    };
+
+    struct node_hash {
+        std::size_t operator()(const lru_node &node) const { return node.hash; }
+    };
+
+    // Maximum number of bytes could be stored in this cache.
+    // i.e all (keys+values) must be less the _max_size
+    std::size_t _max_size;
+    std::size_t _cur_size;
+
+    // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
+    // element that wasn't used for longest time.
+    //
+    // List owns all nodes
+    lru_node *_lru_head;
+    lru_node *_lru_tail;
+
+    // Index of nodes from list above, allows fast random access to elements by lru_node#key
+    RobinHoodIndex<lru_node, node_hash> _lru_index;
+
+    std::hash<std::string> _hash_func;
+
+private:
+    // find node by key and its hash
+    lru_node *find_node(const std::string &key, std::size_t hash) const;
+    // move the most recently used element to tail
+    void move_tail(lru_node &node);
+    // add new element to the storage
+    bool add_element(const std::string &key, std::size_t hash, const std::string &value);
+    // update existing node
+    bool update_element(lru_node &node, const std::string &value);
+    // delete existing node
+    void delete_node(lru_node &node);
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_LRU_H
@@ -0,0 +1,509 @@
+#include "LogStore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char kSegmentPrefix[] = "segment.";
+
+// Partial batch waits for more records at most that long
+const std::chrono::milliseconds kFlushPeriod(100);
+
+// Record of the log, key bytes follow it and value bytes follow the key
+struct record_header {
+    uint32_t key_size;
+    uint32_t value_size;
+    // unix time, zero means never
+    uint32_t expire;
+    uint32_t reserved;
+};
+
+std::runtime_error io_error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+bool write_at(int fd, uint64_t offset, const char *data, std::size_t size) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        offset += written;
+        size -= written;
+    }
+    return true;
+}
+
+// Reads up to size bytes, less only at the end of file
+ssize_t read_at(int fd, uint64_t offset, char *data, std::size_t size) {
+    std::size_t done = 0;
+    while (done < size) {
+        ssize_t got = pread(fd, data + done, size - done, offset + done);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (got == 0) {
+            break;
+        }
+        done += got;
+    }
+    return done;
+}
+
+uint32_t unix_now() { return std::time(nullptr); }
+
+} // namespace
+
+struct LogStore::segment {
+    segment(uint32_t i, const std::string &p, int f) : id(i), path(p), fd(f), size(0), written(0), live(0) {}
+    ~segment() { close(fd); }
+
+    uint32_t id;
+    std::string path;
+    int fd;
+
+    // bytes appended, written to the file and taken by live records
+    uint64_t size;
+    uint64_t written;
+    uint64_t live;
+};
+
+LogStore::LogStore(const std::string &dir, std::size_t max_size, std::size_t segment_size, std::size_t batch_size)
+    : _dir(dir), _max_size(max_size), _segment_size(segment_size), _batch_size(batch_size), _running(false),
+      _flush(false), _next_segment(0), _bytes(0), _compactions(0), _writing(false) {
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw io_error("Failed to create", dir);
+    }
+
+    // Records of the previous process are useless without its index
+    DIR *d = opendir(dir.c_str());
+    if (d == nullptr) {
+        throw io_error("Failed to open", dir);
+    }
+    while (struct dirent *entry = readdir(d)) {
+        if (std::strncmp(entry->d_name, kSegmentPrefix, sizeof(kSegmentPrefix) - 1) == 0) {
+            unlink((dir + "/" + entry->d_name).c_str());
+        }
+    }
+    closedir(d);
+}
+
+LogStore::~LogStore() {
+    Stop();
+    for (auto &entry : _segments) {
+        unlink(entry.second->path.c_str());
+    }
+}
+
+// See LogStore.h
+void LogStore::Start() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    _writer = std::thread(&LogStore::write_loop, this);
+    _reader = std::thread(&LogStore::read_loop, this);
+}
+
+// See LogStore.h
+void LogStore::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _write_cv.notify_all();
+    _read_cv.notify_all();
+    if (_writer.joinable()) {
+        _writer.join();
+    }
+    if (_reader.joinable()) {
+        _reader.join();
+    }
+}
+
+// See LogStore.h
+bool LogStore::Put(const char *key, std::size_t key_size, const char *value, std::size_t value_size, uint32_t ttl) {
+    std::string k(key, key_size);
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_batches.size() >= kMaxPendingBatches && _batches.back().data.size() >= _batch_size) {
+        // Stale record must not outlive the newer value
+        auto found = _index.find(k);
+        if (found != _index.end()) {
+            drop(found);
+        }
+        return false;
+    }
+    return append(k, value, value_size, ttl == 0 ? 0 : unix_now() + ttl);
+}
+
+// See LogStore.h
+bool LogStore::Remove(const std::string &key) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto found = _index.find(key);
+    if (found == _index.end()) {
+        return false;
+    }
+    drop(found);
+    return true;
+}
+
+// See LogStore.h
+bool LogStore::Contains(const std::string &key) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _index.count(key) > 0;
+}
+
+// See LogStore.h
+bool LogStore::Take(const std::string &key, std::string &value, uint32_t &ttl) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return take(lock, key, value, ttl);
+}
+
+// See LogStore.h
+bool LogStore::TakeAsync(const std::string &key, Taken done) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_running) {
+        return false;
+    }
+    auto reading = _reading.find(key);
+    if (reading == _reading.end()) {
+        if (_index.count(key) == 0) {
+            return false;
+        }
+        reading = _reading.emplace(key, std::vector<Taken>()).first;
+        _reads.push_back(key);
+        _read_cv.notify_one();
+    }
+    reading->second.push_back(std::move(done));
+    return true;
+}
+
+// See LogStore.h
+std::size_t LogStore::Items() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _index.size();
+}
+
+// See LogStore.h
+std::size_t LogStore::Bytes() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _bytes;
+}
+
+// See LogStore.h
+std::size_t LogStore::Compactions() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _compactions;
+}
+
+// See LogStore.h
+void LogStore::Flush() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _flush = true;
+    _write_cv.notify_one();
+    _flushed_cv.wait(lock, [this] { return _batches.empty() || !_running; });
+}
+
+// See LogStore.h
+bool LogStore::append(const std::string &key, const char *value, std::size_t value_size, uint32_t expire) {
+    auto found = _index.find(key);
+    if (found != _index.end()) {
+        drop(found);
+    }
+
+    std::size_t size = sizeof(record_header) + key.size() + value_size;
+    if (size > _segment_size || size > UINT32_MAX) {
+        return false;
+    }
+
+    // Segment is sealed once the record doesn't fit
+    if (_segments.empty() || _segments.rbegin()->second->size + size > _segment_size) {
+        uint32_t id = _next_segment++;
+        std::string path = _dir + "/" + kSegmentPrefix + std::to_string(id);
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        _segments.emplace(id, std::make_shared<segment>(id, path, fd));
+    }
+    std::shared_ptr<segment> &seg = _segments.rbegin()->second;
+
+    // Batch being written and full one are not appended to
+    if (_batches.empty() || _batches.back().seg != seg || _batches.back().data.size() >= _batch_size ||
+        (_writing && _batches.size() == 1)) {
+        _batches.push_back(batch{seg, seg->size, std::string()});
+        _batches.back().data.reserve(_batch_size);
+    }
+    batch &tail = _batches.back();
+
+    record_header header = {uint32_t(key.size()), uint32_t(value_size), expire, 0};
+    tail.data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    tail.data.append(key);
+    tail.data.append(value, value_size);
+    if (tail.data.size() >= _batch_size) {
+        _write_cv.notify_one();
+    }
+
+    _index[key] = location{seg->size, seg->id, uint32_t(size), expire};
+    seg->size += size;
+    seg->live += size;
+    _bytes += size;
+    return true;
+}
+
+// See LogStore.h
+void LogStore::drop(std::unordered_map<std::string, location>::iterator it) {
+    _segments[it->second.segment]->live -= it->second.size;
+    _index.erase(it);
+}
+
+// See LogStore.h
+bool LogStore::read(std::unique_lock<std::mutex> &lock, const location &loc, std::string &record) {
+    std::shared_ptr<segment> seg = _segments[loc.segment];
+    if (loc.offset + loc.size > seg->written) {
+        for (auto &b : _batches) {
+            if (b.seg == seg && loc.offset >= b.offset && loc.offset + loc.size <= b.offset + b.data.size()) {
+                record.assign(b.data.data() + (loc.offset - b.offset), loc.size);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // File stays open while segment is referenced, even if it gets compacted meanwhile
+    record.resize(loc.size);
+    lock.unlock();
+    ssize_t got = read_at(seg->fd, loc.offset, &record[0], loc.size);
+    lock.lock();
+    return got == loc.size;
+}
+
+// See LogStore.h
+bool LogStore::take(std::unique_lock<std::mutex> &lock, const std::string &key, std::string &value, uint32_t &ttl) {
+    std::string record;
+    for (;;) {
+        auto found = _index.find(key);
+        if (found == _index.end()) {
+            return false;
+        }
+        location loc = found->second;
+        uint32_t now = unix_now();
+        if (loc.expire != 0 && loc.expire <= now) {
+            drop(found);
+            return false;
+        }
+
+        bool ok = read(lock, loc, record);
+        found = _index.find(key);
+        if (found == _index.end()) {
+            return false;
+        }
+        if (found->second.segment != loc.segment || found->second.offset != loc.offset) {
+            // Key got new record while the old one was being read
+            continue;
+        }
+        drop(found);
+
+        const record_header *header = reinterpret_cast<const record_header *>(record.data());
+        if (!ok || header->key_size != key.size() || header->value_size != loc.size - sizeof(*header) - key.size() ||
+            std::memcmp(record.data() + sizeof(*header), key.data(), key.size()) != 0) {
+            return false;
+        }
+        value.assign(record.data() + sizeof(*header) + key.size(), header->value_size);
+        ttl = loc.expire == 0 ? 0 : std::max<uint32_t>(1, loc.expire - now);
+        return true;
+    }
+}
+
+// See LogStore.h
+void LogStore::write_batches(std::unique_lock<std::mutex> &lock, bool all) {
+    while (!_batches.empty() && (all || _batches.size() > 1 || _batches.front().data.size() >= _batch_size)) {
+        // Records are only appended to the last batch, and not to this one once it is being written
+        batch &b = _batches.front();
+        _writing = true;
+        lock.unlock();
+        bool ok = write_at(b.seg->fd, b.offset, b.data.data(), b.data.size());
+        lock.lock();
+        _writing = false;
+
+        if (ok) {
+            b.seg->written = b.offset + b.data.size();
+        } else {
+            // Records of the batch are lost, as well as all the next ones of the segment
+            for (auto it = _index.begin(); it != _index.end();) {
+                if (it->second.segment == b.seg->id && it->second.offset >= b.offset) {
+                    b.seg->live -= it->second.size;
+                    it = _index.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            b.seg->written = b.offset + b.data.size();
+        }
+        _batches.pop_front();
+    }
+    _flushed_cv.notify_all();
+}
+
+// See LogStore.h
+std::shared_ptr<LogStore::segment> LogStore::victim(bool &keep_live) {
+    // Segment that is still appended to or not written yet is never touched
+    std::shared_ptr<segment> best;
+    for (auto &entry : _segments) {
+        segment &seg = *entry.second;
+        if (entry.first == _segments.rbegin()->first || seg.written < seg.size) {
+            break;
+        }
+        if (_bytes > _max_size) {
+            keep_live = seg.live < seg.size * kCompactRatio;
+            return entry.second;
+        }
+        if (seg.live < seg.size * kCompactRatio && (!best || seg.live * best->size < best->live * seg.size)) {
+            best = entry.second;
+        }
+    }
+    keep_live = true;
+    return best;
+}
+
+// See LogStore.h
+void LogStore::compact(std::unique_lock<std::mutex> &lock, std::shared_ptr<segment> seg, bool keep_live) {
+    // Segment is read in big chunks, records are checked against the index one chunk at a time
+    std::string buffer;
+    uint64_t offset = 0, consumed = 0;
+    while (consumed < seg->size) {
+        std::size_t size = std::min<uint64_t>(std::max(_batch_size, std::size_t(64 * 1024)), seg->size - offset);
+        std::size_t kept = buffer.size();
+        buffer.resize(kept + size);
+        lock.unlock();
+        ssize_t got = read_at(seg->fd, offset, &buffer[kept], size);
+        lock.lock();
+        if (got != ssize_t(size)) {
+            break;
+        }
+        offset += size;
+
+        uint32_t now = unix_now();
+        std::size_t pos = 0;
+        while (buffer.size() - pos >= sizeof(record_header)) {
+            const record_header *header = reinterpret_cast<const record_header *>(buffer.data() + pos);
+            std::size_t record_size = sizeof(record_header) + header->key_size + header->value_size;
+            if (buffer.size() - pos < record_size) {
+                break;
+            }
+
+            std::string key(buffer.data() + pos + sizeof(record_header), header->key_size);
+            auto found = _index.find(key);
+            if (found != _index.end() && found->second.segment == seg->id && found->second.offset == consumed) {
+                if (keep_live && (header->expire == 0 || header->expire > now)) {
+                    append(key, buffer.data() + pos + sizeof(record_header) + header->key_size, header->value_size,
+                           header->expire);
+                } else {
+                    drop(found);
+                }
+            }
+            pos += record_size;
+            consumed += record_size;
+        }
+        buffer.erase(0, pos);
+
+        // Moved records go to the disk as they are read
+        if (_batches.size() >= kMaxPendingBatches / 2) {
+            write_batches(lock, false);
+        }
+    }
+
+    // Whatever is left after read error is lost
+    for (auto it = _index.begin(); consumed < seg->size && it != _index.end();) {
+        if (it->second.segment == seg->id) {
+            it = _index.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    unlink(seg->path.c_str());
+    _segments.erase(seg->id);
+    _bytes -= seg->size;
+    _compactions++;
+}
+
+// See LogStore.h
+void LogStore::write_loop() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_running) {
+        bool woken = _write_cv.wait_for(lock, kFlushPeriod, [this] {
+            return !_running || _flush || _batches.size() > 1 ||
+                   (!_batches.empty() && _batches.front().data.size() >= _batch_size);
+        });
+
+        // Partial batch is written once it has waited long enough
+        write_batches(lock, !woken || _flush || !_running);
+        _flush = false;
+
+        bool keep_live;
+        std::shared_ptr<segment> seg = victim(keep_live);
+        if (seg) {
+            compact(lock, seg, keep_live);
+        }
+    }
+    write_batches(lock, true);
+}
+
+// See LogStore.h
+void LogStore::read_loop() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;) {
+        _read_cv.wait(lock, [this] { return !_running || !_reads.empty(); });
+        if (_reads.empty()) {
+            break;
+        }
+        std::string key = std::move(_reads.front());
+        _reads.pop_front();
+
+        std::string value;
+        uint32_t ttl = 0;
+        bool found = take(lock, key, value, ttl);
+
+        // Callbacks added while the previous ones run get no value: it could be deleted meanwhile
+        for (;;) {
+            auto reading = _reading.find(key);
+            if (reading->second.empty()) {
+                _reading.erase(reading);
+                break;
+            }
+            std::vector<Taken> done;
+            done.swap(reading->second);
+            lock.unlock();
+            for (auto &callback : done) {
+                callback(key, found, value, ttl);
+            }
+            lock.lock();
+            found = false;
+        }
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
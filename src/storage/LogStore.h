@@ -0,0 +1,175 @@
+#ifndef AFINA_STORAGE_LOG_STORE_H
+#define AFINA_STORAGE_LOG_STORE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Log structured file store of evicted items
+ * Second tier under a memory storage: items are appended to the log of segment files in the given
+ * directory, only the key and the place of its record stay in memory.
+ *
+ * Put never touches the disk: record is copied to the tail batch, background thread writes full batches
+ * with a single sequential write each and starts a new segment once the current one reaches
+ * segment_size. Records that are not written yet are read right from the batches. If the disk falls
+ * behind by more than kMaxPendingBatches batches, new items are dropped instead of waiting for it.
+ *
+ * Records are never changed in place: delete and overwrite only drop the index entry and count the
+ * record as dead in its segment. The same background thread compacts the written segment with the
+ * smallest share of live bytes once it is below kCompactRatio: live records are appended to the log
+ * again and the segment file is removed. When the log grows over max_size, the oldest segment is
+ * compacted, or dropped with all its items if most of it is alive anyway.
+ *
+ * Index lives in memory only, so segment files are removed on destruction, and the ones left by the
+ * crashed process are removed on start.
+ *
+ * Take reads the record with a blocking pread, TakeAsync does the same on the reader thread, so the
+ * caller never waits for the disk. Key stays being taken till its callbacks are done, so the item is
+ * always either in the store or already handed to the callbacks for whoever asks.
+ *
+ * All methods are thread safe, disk is accessed with no lock held.
+ */
+class LogStore {
+public:
+    // Called on the reader thread once the key is taken, found is false if the record has gone meanwhile
+    using Taken = std::function<void(const std::string &key, bool found, const std::string &value, uint32_t ttl)>;
+
+    LogStore(const std::string &dir, std::size_t max_size = 1024 * 1024 * 1024,
+             std::size_t segment_size = 64 * 1024 * 1024, std::size_t batch_size = 1024 * 1024);
+
+    ~LogStore();
+
+    // Starts writer and reader threads
+    void Start();
+
+    // Stops the threads, pending batches are written and queued reads are done first
+    void Stop();
+
+    /**
+     * Adds the item, the previous record of the key is dropped. Ttl is number of seconds item has left,
+     * zero means forever. Returns false if the item has been dropped as the disk doesn't keep up
+     */
+    bool Put(const char *key, std::size_t key_size, const char *value, std::size_t value_size, uint32_t ttl);
+
+    // Drops record of the key, returns false if there was none
+    bool Remove(const std::string &key);
+
+    // True if store has record of the key, no disk access
+    bool Contains(const std::string &key);
+
+    /**
+     * Reads value and ttl of the key and removes it from the store, blocks on the disk read. Returns
+     * false if there is no such key or record is expired
+     */
+    bool Take(const std::string &key, std::string &value, uint32_t &ttl);
+
+    /**
+     * Same as Take, but done by the reader thread which calls done once the key is taken. If the key is
+     * being taken already, done is called after the callbacks of that read, with found false. Returns
+     * false and never calls done if there is no record of the key
+     */
+    bool TakeAsync(const std::string &key, Taken done);
+
+    // Number of items in the store
+    std::size_t Items();
+
+    // Size of all the segments, both written and pending bytes
+    std::size_t Bytes();
+
+    // Number of segments compacted or dropped since start
+    std::size_t Compactions();
+
+    // Blocks until all the batches queued so far are written, for tests
+    void Flush();
+
+private:
+    // Segments are compacted when less than that share of bytes is alive
+    static constexpr double kCompactRatio = 0.5;
+    // Batches waiting for the disk, next items are dropped
+    static const std::size_t kMaxPendingBatches = 16;
+
+    struct segment;
+
+    // Place of the record, its expiration time in unix seconds, zero is never
+    struct location {
+        uint64_t offset;
+        uint32_t segment;
+        uint32_t size;
+        uint32_t expire;
+    };
+
+    // Records appended to the segment from the given offset, not on the disk yet
+    struct batch {
+        std::shared_ptr<segment> seg;
+        uint64_t offset;
+        std::string data;
+    };
+
+    // Methods below must be called under the lock, the ones that get it release it for the disk access
+
+    // Appends record, drops the previous one of the key. False if there is no room for it
+    bool append(const std::string &key, const char *value, std::size_t value_size, uint32_t expire);
+    // Drops index entry, counts the record dead
+    void drop(std::unordered_map<std::string, location>::iterator it);
+    // Copies the record bytes, from the batch or from the disk
+    bool read(std::unique_lock<std::mutex> &lock, const location &loc, std::string &record);
+    bool take(std::unique_lock<std::mutex> &lock, const std::string &key, std::string &value, uint32_t &ttl);
+
+    // Writes the batches, the last one only if it is full or all is set
+    void write_batches(std::unique_lock<std::mutex> &lock, bool all);
+    // Rewrites live records of the segment to the log tail, or drops them, and removes the segment
+    void compact(std::unique_lock<std::mutex> &lock, std::shared_ptr<segment> seg, bool keep_live);
+    // Picks segment to compact, if any
+    std::shared_ptr<segment> victim(bool &keep_live);
+
+    void write_loop();
+    void read_loop();
+
+    std::string _dir;
+    std::size_t _max_size;
+    std::size_t _segment_size;
+    std::size_t _batch_size;
+
+    std::mutex _mutex;
+    std::condition_variable _write_cv;
+    std::condition_variable _read_cv;
+    std::condition_variable _flushed_cv;
+    bool _running;
+    // Someone waits for the batches to be written
+    bool _flush;
+
+    std::unordered_map<std::string, location> _index;
+    // All the segments by number, the last one is being appended to
+    std::map<uint32_t, std::shared_ptr<segment>> _segments;
+    uint32_t _next_segment;
+    std::size_t _bytes;
+    std::size_t _compactions;
+
+    // Batches in the order of offsets, the first one could be being written
+    std::deque<batch> _batches;
+    bool _writing;
+
+    // Keys to be taken by the reader thread, and callbacks of the keys being taken
+    std::deque<std::string> _reads;
+    std::unordered_map<std::string, std::vector<Taken>> _reading;
+
+    std::thread _writer;
+    std::thread _reader;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LOG_STORE_H
@@ -0,0 +1,494 @@
+#include "MappedLRU.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Hash.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char kMagic[8] = {'A', 'F', 'I', 'N', 'A', 'M', 'M', '1'};
+const uint32_t kVersion = 2;
+
+// Hash must be the same in every process that maps the file
+const uint64_t kHashSeed = 0x6d617070656421;
+
+// Size classes: the smallest block, growth factor 1.25 and number of classes that covers any sane size
+const std::size_t kMinBlock = 64;
+const std::size_t kClasses = 128;
+
+// Data area starts at the page boundary
+const std::size_t kPage = 4096;
+
+// Blocks of a bigger class are taken for a request only if they are not much bigger
+const std::size_t kClassSlack = 4;
+
+const std::vector<std::size_t> &class_sizes() {
+    static const std::vector<std::size_t> sizes = [] {
+        std::vector<std::size_t> result(kClasses);
+        std::size_t size = kMinBlock;
+        for (std::size_t i = 0; i < kClasses; i++) {
+            result[i] = size;
+            size = std::max(size + 8, (size + size / 4 + 7) & ~std::size_t(7));
+        }
+        return result;
+    }();
+    return sizes;
+}
+
+std::runtime_error io_error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+struct MappedLRU::header {
+    char magic[8];
+    uint32_t version;
+    // zero while some process has the file mapped
+    uint32_t clean;
+
+    uint64_t max_size;
+    uint64_t buckets;
+    // start of the data area and of its untouched tail
+    offset_t data;
+    offset_t top;
+
+    uint64_t items;
+    // least and most recently used nodes
+    offset_t lru_head;
+    offset_t lru_tail;
+
+    // free blocks of each size class linked by node::prev and node::next, block is in the list of the
+    // biggest class not bigger than the block
+    offset_t free_lists[kClasses];
+};
+
+// Block header, key bytes follow it and value bytes follow the key
+struct MappedLRU::node {
+    offset_t prev;
+    offset_t next;
+    // next node in the same bucket
+    offset_t chain;
+    uint64_t hash;
+
+    uint32_t key_size;
+    uint32_t value_size;
+    // bytes of the block, node header included; the next block starts right after it
+    uint32_t size;
+    // nonzero while the block holds an item
+    uint32_t used;
+
+    char *key() { return reinterpret_cast<char *>(this + 1); }
+    char *value() { return key() + key_size; }
+};
+
+MappedLRU::MappedLRU(const std::string &path, size_t max_size)
+    : _path(path), _fd(-1), _max_size(max_size), _base(nullptr), _mapped_size(0), _header(nullptr),
+      _reattached(false) {
+    // Average item is expected to take a few hundred bytes
+    uint64_t buckets = 64;
+    while (buckets < max_size / 256) {
+        buckets *= 2;
+    }
+    offset_t data = (sizeof(header) + buckets * sizeof(offset_t) + kPage - 1) & ~offset_t(kPage - 1);
+    _mapped_size = data + max_size;
+
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        throw io_error("Failed to open", path);
+    }
+    try {
+        if (flock(_fd, LOCK_EX | LOCK_NB) != 0) {
+            throw io_error("Failed to lock", path);
+        }
+        struct stat st;
+        if (fstat(_fd, &st) != 0) {
+            throw io_error("Failed to stat", path);
+        }
+        bool same_size = uint64_t(st.st_size) == _mapped_size;
+        if (!same_size && ftruncate(_fd, _mapped_size) != 0) {
+            throw io_error("Failed to resize", path);
+        }
+
+        void *mapping = mmap(nullptr, _mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if (mapping == MAP_FAILED) {
+            throw io_error("Failed to map", path);
+        }
+        _base = static_cast<char *>(mapping);
+        _header = reinterpret_cast<header *>(_base);
+
+        _reattached = same_size && std::memcmp(_header->magic, kMagic, sizeof(kMagic)) == 0 &&
+                      _header->version == kVersion && _header->clean == 1 && _header->max_size == max_size &&
+                      _header->buckets == buckets && _header->data == data;
+        if (!_reattached) {
+            std::memset(_header, 0, sizeof(header));
+            std::memcpy(_header->magic, kMagic, sizeof(kMagic));
+            _header->version = kVersion;
+            _header->max_size = max_size;
+            _header->buckets = buckets;
+            _header->data = data;
+            reset();
+        }
+        _header->clean = 0;
+    } catch (...) {
+        if (_base != nullptr) {
+            munmap(_base, _mapped_size);
+        }
+        close(_fd);
+        throw;
+    }
+}
+
+MappedLRU::~MappedLRU() {
+    // Data reaches the file before the clean mark does
+    msync(_base, _mapped_size, MS_SYNC);
+    _header->clean = 1;
+    msync(_base, kPage, MS_SYNC);
+
+    munmap(_base, _mapped_size);
+    close(_fd);
+}
+
+// See MappedLRU.h
+std::size_t MappedLRU::class_of(std::size_t size) {
+    const std::vector<std::size_t> &sizes = class_sizes();
+    return std::lower_bound(sizes.begin(), sizes.end(), size) - sizes.begin();
+}
+
+// See MappedLRU.h
+std::size_t MappedLRU::class_size(std::size_t size_class) { return class_sizes()[size_class]; }
+
+// See MappedLRU.h
+std::size_t MappedLRU::class_below(std::size_t size) {
+    const std::vector<std::size_t> &sizes = class_sizes();
+    return std::upper_bound(sizes.begin(), sizes.end(), size) - sizes.begin() - 1;
+}
+
+// See MappedLRU.h
+std::size_t MappedLRU::ItemSize(std::size_t key_size, std::size_t value_size) {
+    std::size_t size_class = class_of(sizeof(node) + key_size + value_size);
+    return size_class < kClasses ? class_size(size_class) : SIZE_MAX;
+}
+
+// See MappedLRU.h
+std::size_t MappedLRU::Size() const { return _header->items; }
+
+// See MappedLRU.h
+void MappedLRU::SetCounters(std::shared_ptr<StorageCounters> counters) {
+    Storage::SetCounters(std::move(counters));
+    Count(StorageCounters::kItems, _header->items);
+
+    // Items left by the previous process are reported too, their blocks are summed once
+    int64_t bytes = 0;
+    for (offset_t o = _header->lru_head; o != 0; o = at(o)->next) {
+        bytes += at(o)->size;
+    }
+    Count(StorageCounters::kBytes, bytes);
+}
+
+MappedLRU::node *MappedLRU::at(offset_t offset) const { return reinterpret_cast<node *>(_base + offset); }
+
+MappedLRU::offset_t MappedLRU::offset_of(const node *n) const { return reinterpret_cast<const char *>(n) - _base; }
+
+MappedLRU::offset_t &MappedLRU::bucket(uint64_t hash) const {
+    return reinterpret_cast<offset_t *>(_base + sizeof(header))[hash & (_header->buckets - 1)];
+}
+
+// all the data area is free, index is empty
+void MappedLRU::reset() {
+    std::memset(_base + sizeof(header), 0, _header->buckets * sizeof(offset_t));
+    std::memset(_header->free_lists, 0, sizeof(_header->free_lists));
+    _header->top = _header->data;
+    _header->items = 0;
+    _header->lru_head = 0;
+    _header->lru_tail = 0;
+}
+
+// See MappedLRU.h
+MappedLRU::node *MappedLRU::find_node(const std::string &key, uint64_t hash) const {
+    for (offset_t o = bucket(hash); o != 0; o = at(o)->chain) {
+        node *n = at(o);
+        if (n->hash == hash && n->key_size == key.size() && std::memcmp(n->key(), key.data(), key.size()) == 0) {
+            return n;
+        }
+    }
+    return nullptr;
+}
+
+// move the most recently used element to the tail
+void MappedLRU::move_tail(node &n) {
+    offset_t o = offset_of(&n);
+    if (o == _header->lru_tail) {
+        return;
+    }
+
+    if (n.prev == 0) {
+        _header->lru_head = n.next;
+    } else {
+        at(n.prev)->next = n.next;
+    }
+    at(n.next)->prev = n.prev;
+
+    n.prev = _header->lru_tail;
+    n.next = 0;
+    at(_header->lru_tail)->next = o;
+    _header->lru_tail = o;
+}
+
+// See MappedLRU.h
+MappedLRU::offset_t MappedLRU::alloc_block(std::size_t size_class) {
+    const std::size_t size = class_size(size_class);
+    for (;;) {
+        std::size_t last = std::min(size_class + kClassSlack, kClasses);
+        for (std::size_t c = size_class; c < last; c++) {
+            offset_t block = _header->free_lists[c];
+            if (block != 0) {
+                take_block(block);
+                return block;
+            }
+        }
+
+        if (_header->top + size <= _header->data + _max_size) {
+            offset_t block = _header->top;
+            _header->top += size;
+            at(block)->size = size;
+            return block;
+        }
+
+        // Storage gets empty at the worst, then the whole area is free again
+        offset_t head = _header->lru_head;
+        if (head == 0) {
+            return 0;
+        }
+
+        // Least recently used item of about the same size frees the block needed
+        std::size_t head_class = class_below(at(head)->size);
+        if (size_class <= head_class && head_class < last) {
+            delete_node(*at(head));
+            Count(StorageCounters::kEvictions);
+            continue;
+        }
+
+        // Otherwise its block is merged with the following ones until they make room for the new block,
+        // items in them are evicted. Part left over must be big enough to be a block itself
+        offset_t end = head;
+        bool emptied = false;
+        while (end < _header->top && (end - head < size || (end - head > size && end - head - size < kMinBlock))) {
+            node *n = at(end);
+            end += n->size;
+            if (n->used) {
+                unlink_node(*n);
+                Count(StorageCounters::kEvictions);
+                if (_header->items == 0) {
+                    emptied = true;
+                    break;
+                }
+            } else {
+                take_block(offset_of(n));
+            }
+        }
+
+        if (emptied) {
+            reset();
+        } else if (end == _header->top) {
+            // Merged blocks join the untouched tail
+            _header->top = head;
+        } else {
+            if (end - head > size) {
+                node *rest = at(head + size);
+                rest->size = end - head - size;
+                free_block(head + size);
+            }
+            at(head)->size = size;
+            return head;
+        }
+    }
+}
+
+// See MappedLRU.h
+void MappedLRU::take_block(offset_t block) {
+    node *n = at(block);
+    if (n->prev == 0) {
+        _header->free_lists[class_below(n->size)] = n->next;
+    } else {
+        at(n->prev)->next = n->next;
+    }
+    if (n->next != 0) {
+        at(n->next)->prev = n->prev;
+    }
+}
+
+// See MappedLRU.h
+void MappedLRU::free_block(offset_t block) {
+    node *n = at(block);
+    offset_t &list = _header->free_lists[class_below(n->size)];
+    n->used = 0;
+    n->prev = 0;
+    n->next = list;
+    if (list != 0) {
+        at(list)->prev = block;
+    }
+    list = block;
+}
+
+// add to the storage the element which exactly is not in storage
+bool MappedLRU::add_element(const std::string &key, uint64_t hash, const std::string &value) {
+    if (ItemSize(key.size(), value.size()) > _max_size) {
+        return false; // no chances to put the element to the storage
+    }
+
+    offset_t o = alloc_block(class_of(sizeof(node) + key.size() + value.size()));
+    if (o == 0) {
+        return false;
+    }
+
+    node *n = at(o);
+    n->used = 1;
+    n->hash = hash;
+    n->key_size = key.size();
+    n->value_size = value.size();
+    std::memcpy(n->key(), key.data(), key.size());
+    std::memcpy(n->value(), value.data(), value.size());
+
+    offset_t &head = bucket(hash);
+    n->chain = head;
+    head = o;
+
+    n->prev = _header->lru_tail;
+    n->next = 0;
+    if (_header->lru_tail == 0) {
+        _header->lru_head = o;
+    } else {
+        at(_header->lru_tail)->next = o;
+    }
+    _header->lru_tail = o;
+    _header->items++;
+    Count(StorageCounters::kBytes, n->size);
+    Count(StorageCounters::kItems);
+    return true;
+}
+
+// delete node that exactly exist
+void MappedLRU::delete_node(node &n) {
+    unlink_node(n);
+    if (_header->items == 0) {
+        // Blocks of all classes merge back into the untouched area
+        reset();
+    } else {
+        free_block(offset_of(&n));
+    }
+}
+
+// remove node from the index and the list, its block is left as is
+void MappedLRU::unlink_node(node &n) {
+    offset_t o = offset_of(&n);
+
+    offset_t *link = &bucket(n.hash);
+    while (*link != o) {
+        link = &at(*link)->chain;
+    }
+    *link = n.chain;
+
+    if (n.prev == 0) {
+        _header->lru_head = n.next;
+    } else {
+        at(n.prev)->next = n.next;
+    }
+    if (n.next == 0) {
+        _header->lru_tail = n.prev;
+    } else {
+        at(n.next)->prev = n.prev;
+    }
+
+    Count(StorageCounters::kBytes, -int64_t(n.size));
+    Count(StorageCounters::kItems, -1);
+    _header->items--;
+}
+
+// update value of the exactly existing element
+bool MappedLRU::update_element(node &n, const std::string &key, const std::string &value) {
+    std::size_t size = sizeof(node) + key.size() + value.size();
+    if (ItemSize(key.size(), value.size()) > _max_size) {
+        return false;
+    }
+
+    // Value is written in place while it fits into the block and the block isn't much bigger than needed
+    std::size_t size_class = class_of(size);
+    std::size_t block_class = class_below(n.size);
+    if (size_class <= block_class && block_class < size_class + kClassSlack) {
+        std::memcpy(n.value(), value.data(), value.size());
+        n.value_size = value.size();
+        move_tail(n);
+        return true;
+    }
+
+    uint64_t hash = n.hash;
+    delete_node(n);
+    return add_element(key, hash, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MappedLRU::Put(const std::string &key, const std::string &value) {
+    uint64_t hash = WyHash(key, kHashSeed);
+    node *n = find_node(key, hash);
+    if (n == nullptr) {
+        return add_element(key, hash, value);
+    } else {
+        return update_element(*n, key, value);
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MappedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    uint64_t hash = WyHash(key, kHashSeed);
+    if (find_node(key, hash) != nullptr) {
+        return false;
+    }
+    return add_element(key, hash, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MappedLRU::Set(const std::string &key, const std::string &value) {
+    node *n = find_node(key, WyHash(key, kHashSeed));
+    if (n == nullptr) {
+        return false;
+    } else {
+        return update_element(*n, key, value);
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MappedLRU::Delete(const std::string &key) {
+    node *n = find_node(key, WyHash(key, kHashSeed));
+    if (n == nullptr) {
+        return false;
+    }
+    delete_node(*n);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MappedLRU::Get(const std::string &key, std::string &value) {
+    node *n = find_node(key, WyHash(key, kHashSeed));
+    if (n == nullptr) {
+        return false;
+    }
+    value.assign(n->value(), n->value_size);
+    move_tail(*n);
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,126 @@
+#ifndef AFINA_STORAGE_MAPPED_LRU_H
+#define AFINA_STORAGE_MAPPED_LRU_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # File mapped implementation
+ * Items, index and LRU list live in a file mapped with MAP_SHARED, so they outlive the process: the next
+ * process maps the same file and serves the items right away, without any loading. Structures refer to
+ * each other by offsets from the start of the mapping instead of addresses, they stay valid wherever the
+ * file gets mapped.
+ *
+ * # Layout
+ * - header: sizes of the parts, list ends, allocator state, clean shutdown mark
+ * - index: fixed number of buckets, each is a chain of nodes with the same low bits of the key hash
+ * - data area of max_size bytes: blocks of size classes growing by factor 1.25, as memcached slabs do.
+ *   Block holds node header, key and value, blocks follow each other without gaps. Freed blocks go to
+ *   the free list of their class, new ones are carved from the untouched tail of the area. Once neither
+ *   has a block, the least recently used item is evicted. If its block is of other size, it is merged
+ *   with the blocks right after it, evicting their items, until the new block fits: only a block worth
+ *   of items goes away, not every item of other classes
+ *
+ * Hash of the key is wyhash with a fixed seed, it must not change between processes.
+ *
+ * File is marked dirty while it is mapped and clean once destructor has synced it back. File that is
+ * dirty, was made by other version or for other max_size is reset to the empty storage: process that died
+ * in the middle of update could leave the structures broken. Only one process could use the file, that is
+ * guarded by flock.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class MappedLRU : public Afina::Storage {
+public:
+    MappedLRU(const std::string &path, size_t max_size = 1024 * 1024);
+
+    ~MappedLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface, reattached items are counted right away
+    void SetCounters(std::shared_ptr<StorageCounters> counters) override;
+
+    /**
+     * Number of bytes an item with given key and value sizes takes from the data area: block of the size
+     * class node header, key and value fit in
+     */
+    static std::size_t ItemSize(std::size_t key_size, std::size_t value_size);
+
+    // Number of items in the storage
+    std::size_t Size() const;
+
+    // True if items of the previous process have been picked up from the file
+    bool Reattached() const { return _reattached; }
+
+private:
+    struct header;
+    struct node;
+
+    // Offset of the node in the mapping, zero means no node
+    typedef uint64_t offset_t;
+
+    node *at(offset_t offset) const;
+    offset_t offset_of(const node *n) const;
+    offset_t &bucket(uint64_t hash) const;
+
+    // Empty storage in the mapped file
+    void reset();
+
+    node *find_node(const std::string &key, uint64_t hash) const;
+    // move the most recently used element to tail
+    void move_tail(node &n);
+    // add new element to the storage, the key must not be there
+    bool add_element(const std::string &key, uint64_t hash, const std::string &value);
+    // update existing node
+    bool update_element(node &n, const std::string &key, const std::string &value);
+    // delete existing node
+    void delete_node(node &n);
+    // remove existing node from the index and the list, but keep its block
+    void unlink_node(node &n);
+
+    // takes block of the class, evicting items if needed, zero if nothing could be freed
+    offset_t alloc_block(std::size_t size_class);
+    void free_block(offset_t block);
+    // removes free block from its free list
+    void take_block(offset_t block);
+
+    // Index of the smallest class block of which holds size bytes
+    static std::size_t class_of(std::size_t size);
+    static std::size_t class_size(std::size_t size_class);
+    // Index of the biggest class not bigger than size
+    static std::size_t class_below(std::size_t size);
+
+    std::string _path;
+    int _fd;
+    std::size_t _max_size;
+
+    char *_base;
+    std::size_t _mapped_size;
+    header *_header;
+    bool _reattached;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MAPPED_LRU_H
@@ -0,0 +1,67 @@
+#include "PolicyStorage.h"
+
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Each step picks one policy by its name and passes the chosen ones to the next step
+
+template <typename Locking, typename Index, typename Eviction>
+std::shared_ptr<Afina::Storage> with_sizing(const std::vector<std::string> &names, std::size_t max_size) {
+    if (names[3] == "bytes") {
+        return std::make_shared<PolicyStorage<Index, Eviction, Locking, Policy::ByteSize>>(max_size);
+    } else if (names[3] == "items") {
+        return std::make_shared<PolicyStorage<Index, Eviction, Locking, Policy::ItemCount>>(max_size);
+    }
+    return nullptr;
+}
+
+template <typename Locking, typename Index>
+std::shared_ptr<Afina::Storage> with_eviction(const std::vector<std::string> &names, std::size_t max_size) {
+    if (names[2] == "lru") {
+        return with_sizing<Locking, Index, Policy::LruEviction>(names, max_size);
+    } else if (names[2] == "fifo") {
+        return with_sizing<Locking, Index, Policy::FifoEviction>(names, max_size);
+    } else if (names[2] == "clock") {
+        return with_sizing<Locking, Index, Policy::ClockEviction>(names, max_size);
+    }
+    return nullptr;
+}
+
+template <typename Locking>
+std::shared_ptr<Afina::Storage> with_index(const std::vector<std::string> &names, std::size_t max_size) {
+    if (names[1] == "map") {
+        return with_eviction<Locking, Policy::OrderedIndex>(names, max_size);
+    } else if (names[1] == "hash") {
+        return with_eviction<Locking, Policy::HashIndex>(names, max_size);
+    }
+    return nullptr;
+}
+
+} // namespace
+
+// See PolicyStorage.h
+std::shared_ptr<Afina::Storage> MakePolicyStorage(const std::string &spec, std::size_t max_size) {
+    std::vector<std::string> names;
+    std::size_t start = 0;
+    for (std::size_t end; (end = spec.find('_', start)) != std::string::npos; start = end + 1) {
+        names.push_back(spec.substr(start, end - start));
+    }
+    names.push_back(spec.substr(start));
+    if (names.size() != 4) {
+        return nullptr;
+    }
+
+    if (names[0] == "st") {
+        return with_index<Policy::NoLock>(names, max_size);
+    } else if (names[0] == "mt") {
+        return with_index<Policy::MutexLock>(names, max_size);
+    }
+    return nullptr;
+}
+
+} // namespace Backend
+} // namespace Afina
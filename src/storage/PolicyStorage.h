@@ -0,0 +1,348 @@
+#ifndef AFINA_STORAGE_POLICY_STORAGE_H
+#define AFINA_STORAGE_POLICY_STORAGE_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "RobinHoodIndex.h"
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Policies of PolicyStorage
+ * Each policy that keeps something per item declares hook struct, storage node derives from the hooks of
+ * all its policies, so an item is still a single allocation.
+ */
+namespace Policy {
+
+// std::map of references to the node keys
+class OrderedIndex {
+public:
+    struct hook {};
+
+    template <typename Node> class table {
+    public:
+        Node *Find(const std::string &key) const {
+            auto found = _map.find(std::cref(key));
+            return found == _map.end() ? nullptr : found->second;
+        }
+        void Insert(Node &node) { _map.emplace(std::cref(node.key), &node); }
+        void Erase(Node &node) { _map.erase(std::cref(node.key)); }
+
+    private:
+        std::map<std::reference_wrapper<const std::string>, Node *, std::less<std::string>> _map;
+    };
+};
+
+// RobinHoodIndex, node keeps hash of its key
+class HashIndex {
+public:
+    struct hook {
+        std::size_t hash;
+    };
+
+    template <typename Node> class table {
+    public:
+        Node *Find(const std::string &key) const {
+            return _index.Find(_hash(key), [&key](const Node &node) { return node.key == key; });
+        }
+        void Insert(Node &node) {
+            node.hash = _hash(node.key);
+            _index.Insert(node.hash, &node);
+        }
+        void Erase(Node &node) { _index.Erase(node.hash, &node); }
+
+    private:
+        struct node_hash {
+            std::size_t operator()(const Node &node) const { return node.hash; }
+        };
+
+        RobinHoodIndex<Node, node_hash> _index;
+        std::hash<std::string> _hash;
+    };
+};
+
+// Victim is the least recently used item: list ordered by the last access, head is the oldest
+class LruEviction {
+public:
+    struct hook {
+        hook *prev;
+        hook *next;
+    };
+
+    LruEviction() : _head(nullptr), _tail(nullptr) {}
+
+    void Insert(hook &h) {
+        h.prev = _tail;
+        h.next = nullptr;
+        if (_tail == nullptr) {
+            _head = &h;
+        } else {
+            _tail->next = &h;
+        }
+        _tail = &h;
+    }
+    void Touch(hook &h) {
+        if (&h != _tail) {
+            Remove(h);
+            Insert(h);
+        }
+    }
+    void Remove(hook &h) {
+        if (h.prev == nullptr) {
+            _head = h.next;
+        } else {
+            h.prev->next = h.next;
+        }
+        if (h.next == nullptr) {
+            _tail = h.prev;
+        } else {
+            h.next->prev = h.prev;
+        }
+    }
+    hook *Victim() { return _head; }
+
+private:
+    hook *_head;
+    hook *_tail;
+};
+
+// Victim is the oldest item, access doesn't change the order
+class FifoEviction : public LruEviction {
+public:
+    void Touch(hook &h) {}
+};
+
+// CLOCK: access only sets the bit, the hand clears bits and stops at the first item without one
+class ClockEviction {
+public:
+    struct hook {
+        hook *prev;
+        hook *next;
+        bool referenced;
+    };
+
+    ClockEviction() : _hand(nullptr) {}
+
+    // New item is placed right behind the hand, so it gets the whole round
+    void Insert(hook &h) {
+        h.referenced = false;
+        if (_hand == nullptr) {
+            h.prev = h.next = &h;
+            _hand = &h;
+        } else {
+            h.next = _hand;
+            h.prev = _hand->prev;
+            _hand->prev->next = &h;
+            _hand->prev = &h;
+        }
+    }
+    void Touch(hook &h) { h.referenced = true; }
+    void Remove(hook &h) {
+        if (h.next == &h) {
+            _hand = nullptr;
+            return;
+        }
+        if (_hand == &h) {
+            _hand = h.next;
+        }
+        h.prev->next = h.next;
+        h.next->prev = h.prev;
+    }
+    hook *Victim() {
+        while (_hand != nullptr && _hand->referenced) {
+            _hand->referenced = false;
+            _hand = _hand->next;
+        }
+        return _hand;
+    }
+
+private:
+    hook *_hand;
+};
+
+// No synchronization at all, for storages used by a single thread
+class NoLock {
+public:
+    void lock() {}
+    void unlock() {}
+};
+
+// Single lock for all the operations
+class MutexLock {
+public:
+    void lock() { _mutex.lock(); }
+    void unlock() { _mutex.unlock(); }
+
+private:
+    std::mutex _mutex;
+};
+
+// max_size is the number of key and value bytes
+struct ByteSize {
+    static std::size_t Of(const std::string &key, const std::string &value) { return key.size() + value.size(); }
+};
+
+// max_size is the number of items
+struct ItemCount {
+    static std::size_t Of(const std::string &key, const std::string &value) { return 1; }
+};
+
+} // namespace Policy
+
+/**
+ * # Storage assembled from compile time policies
+ * Index finds item by key, Eviction orders items and picks the victim, Locking guards every operation and
+ * Sizing tells how much of max_size an item takes, see namespace Policy. All the calls are resolved at
+ * compile time, so each combination gets its own hot path without virtual calls, and NoLock costs nothing.
+ *
+ * Value is replaced in place: item is taken out of the eviction order while room is made for the new value,
+ * so it is never evicted by its own update.
+ *
+ * New policy only has to provide the same members as the existing ones of its kind.
+ */
+template <typename Index, typename Eviction, typename Locking, typename Sizing>
+class PolicyStorage : public Afina::Storage {
+public:
+    explicit PolicyStorage(std::size_t max_size = 1024) : _max_size(max_size), _cur_size(0) {}
+
+    ~PolicyStorage() {
+        while (typename Eviction::hook *victim = _eviction.Victim()) {
+            _eviction.Remove(*victim);
+            delete static_cast<node *>(victim);
+        }
+    }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override {
+        std::lock_guard<Locking> guard(_lock);
+        node *found = _index.Find(key);
+        return found == nullptr ? add_element(key, value) : update_element(*found, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        std::lock_guard<Locking> guard(_lock);
+        return _index.Find(key) == nullptr && add_element(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override {
+        std::lock_guard<Locking> guard(_lock);
+        node *found = _index.Find(key);
+        return found != nullptr && update_element(*found, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override {
+        std::lock_guard<Locking> guard(_lock);
+        node *found = _index.Find(key);
+        if (found == nullptr) {
+            return false;
+        }
+        delete_node(*found);
+        return true;
+    }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override {
+        std::lock_guard<Locking> guard(_lock);
+        node *found = _index.Find(key);
+        if (found == nullptr) {
+            return false;
+        }
+        _eviction.Touch(*found);
+        value = found->value;
+        return true;
+    }
+
+    // Part of max_size taken by the items
+    std::size_t CurrentSize() {
+        std::lock_guard<Locking> guard(_lock);
+        return _cur_size;
+    }
+
+private:
+    struct node : Index::hook, Eviction::hook {
+        std::string key;
+        std::string value;
+    };
+
+    bool add_element(const std::string &key, const std::string &value) {
+        std::size_t size = Sizing::Of(key, value);
+        if (size > _max_size) {
+            return false;
+        }
+        free_space(size);
+
+        node *added = new node;
+        added->key = key;
+        added->value = value;
+        _index.Insert(*added);
+        _eviction.Insert(*added);
+        _cur_size += size;
+        this->Count(StorageCounters::kBytes, key.size() + value.size());
+        this->Count(StorageCounters::kItems);
+        return true;
+    }
+
+    bool update_element(node &updated, const std::string &value) {
+        std::size_t size = Sizing::Of(updated.key, value);
+        if (size > _max_size) {
+            return false;
+        }
+
+        _eviction.Remove(updated);
+        _cur_size -= Sizing::Of(updated.key, updated.value);
+        free_space(size);
+
+        // Bytes are counted as is whatever the budget is measured in
+        this->Count(StorageCounters::kBytes, int64_t(value.size()) - int64_t(updated.value.size()));
+        updated.value = value;
+        _eviction.Insert(updated);
+        _cur_size += size;
+        return true;
+    }
+
+    // evict until item of the given size fits
+    void free_space(std::size_t size) {
+        while (_cur_size + size > _max_size) {
+            delete_node(static_cast<node &>(*_eviction.Victim()));
+            this->Count(StorageCounters::kEvictions);
+        }
+    }
+
+    void delete_node(node &deleted) {
+        _index.Erase(deleted);
+        _eviction.Remove(deleted);
+        _cur_size -= Sizing::Of(deleted.key, deleted.value);
+        this->Count(StorageCounters::kBytes, -int64_t(deleted.key.size() + deleted.value.size()));
+        delete &deleted;
+        this->Count(StorageCounters::kItems, -1);
+    }
+
+    std::size_t _max_size;
+    std::size_t _cur_size;
+
+    typename Index::template table<node> _index;
+    Eviction _eviction;
+    Locking _lock;
+};
+
+/**
+ * Makes storage of the policies named by spec: <st|mt>_<map|hash>_<lru|fifo|clock>_<bytes|items>, that is
+ * locking, index, eviction and sizing, st_ means NoLock and mt_ MutexLock. Returns nullptr if spec doesn't
+ * name any combination
+ */
+std::shared_ptr<Afina::Storage> MakePolicyStorage(const std::string &spec, std::size_t max_size);
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_POLICY_STORAGE_H
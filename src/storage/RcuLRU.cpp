@@ -0,0 +1,393 @@
+#include "RcuLRU.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <sched.h>
+#include <stdexcept>
+#include <thread>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Address of that byte marks deleted slots
+char tombstone_mark;
+
+// Retired items are freed in batches, so writers wait for readers rarely
+const std::size_t kReclaimBatch = 64;
+
+} // namespace
+
+// See RcuLRU.h
+RcuLRU::item *RcuLRU::tombstone() { return reinterpret_cast<item *>(&tombstone_mark); }
+
+RcuLRU::table::table(std::size_t capacity) : mask(capacity - 1), slots(new std::atomic<item *>[capacity]) {
+    for (std::size_t i = 0; i < capacity; i++) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+RcuLRU::RcuLRU(size_t max_size)
+    : _max_size(max_size), _cur_size(0), _table(new table(16)), _used_slots(0), _hand(0), _phase(0) {
+    _cpus = std::max(1u, std::thread::hardware_concurrency());
+    _readers_memory.reset(new char[2 * _cpus * sizeof(reader_count) + alignof(reader_count)]);
+    uintptr_t aligned =
+        (reinterpret_cast<uintptr_t>(_readers_memory.get()) + alignof(reader_count) - 1) & ~(alignof(reader_count) - 1);
+    _readers = reinterpret_cast<reader_count *>(aligned);
+    for (std::size_t i = 0; i < 2 * _cpus; i++) {
+        new (&_readers[i]) reader_count();
+        _readers[i].locks.store(0, std::memory_order_relaxed);
+        _readers[i].unlocks.store(0, std::memory_order_relaxed);
+    }
+}
+
+RcuLRU::~RcuLRU() {
+    // Nobody could read anymore, everything is freed right away
+    for (item *it : _ring) {
+        delete it;
+    }
+    reclaim();
+    delete _table.load(std::memory_order_relaxed);
+}
+
+// See RcuLRU.h
+RcuLRU::reader_count &RcuLRU::current_readers(std::size_t phase) {
+    int cpu = sched_getcpu();
+    return _readers[phase * _cpus + (cpu < 0 ? 0 : std::size_t(cpu) % _cpus)];
+}
+
+// See RcuLRU.h
+std::size_t RcuLRU::read_lock() {
+    std::size_t phase = _phase.load(std::memory_order_seq_cst) & 1;
+    // Full barrier: index must not be read before the reader is announced
+    current_readers(phase).locks.fetch_add(1, std::memory_order_seq_cst);
+    return phase;
+}
+
+// See RcuLRU.h
+void RcuLRU::read_unlock(std::size_t phase) { current_readers(phase).unlocks.fetch_add(1, std::memory_order_seq_cst); }
+
+// See RcuLRU.h
+void RcuLRU::synchronize() {
+    // Reader could take the phase before the flip and announce itself after the counters have been checked,
+    // it is the one the second flip waits for
+    for (int flip = 0; flip < 2; flip++) {
+        std::size_t phase = _phase.fetch_add(1, std::memory_order_seq_cst) & 1;
+        while (true) {
+            // Unlocks go first: every counted unlock has its lock counted as well
+            unsigned long unlocks = 0, locks = 0;
+            for (std::size_t i = 0; i < _cpus; i++) {
+                unlocks += _readers[phase * _cpus + i].unlocks.load(std::memory_order_seq_cst);
+            }
+            for (std::size_t i = 0; i < _cpus; i++) {
+                locks += _readers[phase * _cpus + i].locks.load(std::memory_order_seq_cst);
+            }
+            if (locks == unlocks) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
+
+// See RcuLRU.h
+void RcuLRU::retire(item *it) {
+    _retired_items.push_back(it);
+    if (_retired_items.size() >= kReclaimBatch) {
+        reclaim();
+    }
+}
+
+// See RcuLRU.h
+void RcuLRU::retire(table *t) { _retired_tables.push_back(t); }
+
+// See RcuLRU.h
+void RcuLRU::reclaim() {
+    synchronize();
+    for (item *it : _retired_items) {
+        delete it;
+    }
+    for (table *t : _retired_tables) {
+        delete t;
+    }
+    _retired_items.clear();
+    _retired_tables.clear();
+}
+
+// See RcuLRU.h
+std::size_t RcuLRU::find_slot(const table &t, const std::string &key, std::size_t hash) const {
+    for (std::size_t i = hash & t.mask;; i = (i + 1) & t.mask) {
+        item *it = t.slots[i].load(std::memory_order_relaxed);
+        if (it == nullptr) {
+            return no_slot;
+        }
+        if (it != tombstone() && it->hash == hash && it->key == key) {
+            return i;
+        }
+    }
+}
+
+// See RcuLRU.h
+void RcuLRU::grow() {
+    table *old = _table.load(std::memory_order_relaxed);
+    std::size_t items = _ring.size() - _ring_free.size();
+
+    // Rebuilt table is at most 3/8 full, tombstones are dropped
+    std::size_t capacity = 16;
+    while (capacity * 3 < (items + 1) * 8) {
+        capacity *= 2;
+    }
+
+    table *t = new table(capacity);
+    for (std::size_t i = 0; i <= old->mask; i++) {
+        item *it = old->slots[i].load(std::memory_order_relaxed);
+        if (it == nullptr || it == tombstone()) {
+            continue;
+        }
+
+        std::size_t j = it->hash & t->mask;
+        while (t->slots[j].load(std::memory_order_relaxed) != nullptr) {
+            j = (j + 1) & t->mask;
+        }
+        t->slots[j].store(it, std::memory_order_relaxed);
+    }
+
+    _used_slots = items;
+    _table.store(t, std::memory_order_release);
+    retire(old);
+}
+
+// See RcuLRU.h
+void RcuLRU::link_item(item *it) {
+    // At least a quarter of slots stays empty, so probing always stops
+    table *t = _table.load(std::memory_order_relaxed);
+    if ((_used_slots + 1) * 4 > (t->mask + 1) * 3) {
+        grow();
+        t = _table.load(std::memory_order_relaxed);
+    }
+
+    std::size_t i = it->hash & t->mask;
+    item *current;
+    while ((current = t->slots[i].load(std::memory_order_relaxed)) != nullptr && current != tombstone()) {
+        i = (i + 1) & t->mask;
+    }
+    if (current == nullptr) {
+        _used_slots++;
+    }
+
+    if (_ring_free.empty()) {
+        it->position = _ring.size();
+        _ring.push_back(it);
+    } else {
+        it->position = _ring_free.back();
+        _ring_free.pop_back();
+        _ring[it->position] = it;
+    }
+
+    _cur_size += it->key.size() + it->value.size();
+    Count(StorageCounters::kBytes, it->key.size() + it->value.size());
+    t->slots[i].store(it, std::memory_order_release);
+    Count(StorageCounters::kItems);
+}
+
+// See RcuLRU.h
+void RcuLRU::replace_item(std::size_t slot, item *from, item *to) {
+    to->position = from->position;
+    _ring[to->position] = to;
+    _cur_size = _cur_size - from->value.size() + to->value.size();
+    Count(StorageCounters::kBytes, int64_t(to->value.size()) - int64_t(from->value.size()));
+
+    _table.load(std::memory_order_relaxed)->slots[slot].store(to, std::memory_order_release);
+    retire(from);
+}
+
+// See RcuLRU.h
+void RcuLRU::unlink_item(std::size_t slot, item *it) {
+    _ring[it->position] = nullptr;
+    _ring_free.push_back(it->position);
+    _cur_size -= it->key.size() + it->value.size();
+    Count(StorageCounters::kBytes, -int64_t(it->key.size() + it->value.size()));
+
+    _table.load(std::memory_order_relaxed)->slots[slot].store(tombstone(), std::memory_order_release);
+    retire(it);
+    Count(StorageCounters::kItems, -1);
+}
+
+// See RcuLRU.h
+void RcuLRU::evict() {
+    while (true) {
+        if (_hand >= _ring.size()) {
+            _hand = 0;
+        }
+
+        item *it = _ring[_hand++];
+        if (it == nullptr) {
+            continue;
+        }
+        if (it->referenced.load(std::memory_order_relaxed)) {
+            // Second chance
+            it->referenced.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        unlink_item(find_slot(*_table.load(std::memory_order_relaxed), it->key, it->hash), it);
+        Count(StorageCounters::kEvictions);
+        return;
+    }
+}
+
+// add to the storage the element which exactly is not in storage
+bool RcuLRU::add_element(const std::string &key, std::size_t hash, const std::string &value) {
+    std::size_t addsize = key.size() + value.size();
+    if (addsize > _max_size) {
+        return false; // no chances to put the element to the storage
+    }
+
+    while (addsize + _cur_size > _max_size) {
+        evict();
+    }
+
+    link_item(new item{hash, key, value, {false}, 0});
+    return true;
+}
+
+// update value of the exactly existing element
+bool RcuLRU::update_element(std::size_t slot, const std::string &value) {
+    item *old = _table.load(std::memory_order_relaxed)->slots[slot].load(std::memory_order_relaxed);
+    if (old->key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    // Updated item must survive the sweep: eviction never moves items between slots, but the item
+    // could be evicted itself if it isn't referenced. Put it away from the ring for a while
+    _ring[old->position] = nullptr;
+    while (_cur_size - old->value.size() + value.size() > _max_size) {
+        evict();
+    }
+    _ring[old->position] = old;
+
+    replace_item(slot, old, new item{old->hash, old->key, value, {true}, 0});
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool RcuLRU::Put(const std::string &key, const std::string &value) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    std::size_t hash = _hash_func(key);
+    std::size_t slot = find_slot(*_table.load(std::memory_order_relaxed), key, hash);
+    if (slot == no_slot) {
+        return add_element(key, hash, value);
+    }
+    return update_element(slot, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool RcuLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    std::size_t hash = _hash_func(key);
+    if (find_slot(*_table.load(std::memory_order_relaxed), key, hash) != no_slot) {
+        return false;
+    }
+    return add_element(key, hash, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool RcuLRU::Set(const std::string &key, const std::string &value) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    std::size_t slot = find_slot(*_table.load(std::memory_order_relaxed), key, _hash_func(key));
+    if (slot == no_slot) {
+        return false;
+    }
+    return update_element(slot, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool RcuLRU::Delete(const std::string &key) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    table *t = _table.load(std::memory_order_relaxed);
+    std::size_t slot = find_slot(*t, key, _hash_func(key));
+    if (slot == no_slot) {
+        return false;
+    }
+    unlink_item(slot, t->slots[slot].load(std::memory_order_relaxed));
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool RcuLRU::Get(const std::string &key, std::string &value) {
+    std::size_t hash = _hash_func(key);
+    std::size_t phase = read_lock();
+
+    bool found = false;
+    table *t = _table.load(std::memory_order_acquire);
+    for (std::size_t i = hash & t->mask;; i = (i + 1) & t->mask) {
+        item *it = t->slots[i].load(std::memory_order_acquire);
+        if (it == nullptr) {
+            break;
+        }
+        if (it != tombstone() && it->hash == hash && it->key == key) {
+            value = it->value;
+            // Plain load first: hot items don't bounce the cache line between readers
+            if (!it->referenced.load(std::memory_order_relaxed)) {
+                it->referenced.store(true, std::memory_order_relaxed);
+            }
+            found = true;
+            break;
+        }
+    }
+
+    read_unlock(phase);
+    return found;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool RcuLRU::Append(const std::string &key, const std::string &data) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    std::size_t slot = find_slot(*_table.load(std::memory_order_relaxed), key, _hash_func(key));
+    if (slot == no_slot) {
+        return false;
+    }
+    item *old = _table.load(std::memory_order_relaxed)->slots[slot].load(std::memory_order_relaxed);
+    return update_element(slot, old->value + data);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool RcuLRU::Prepend(const std::string &key, const std::string &data) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    std::size_t slot = find_slot(*_table.load(std::memory_order_relaxed), key, _hash_func(key));
+    if (slot == no_slot) {
+        return false;
+    }
+    item *old = _table.load(std::memory_order_relaxed)->slots[slot].load(std::memory_order_relaxed);
+    return update_element(slot, data + old->value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool RcuLRU::Increment(const std::string &key, uint64_t delta, uint64_t &number) {
+    return add_number(key, delta, false, number);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool RcuLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &number) {
+    return add_number(key, delta, true, number);
+}
+
+// read, change and publish the number under the write lock
+bool RcuLRU::add_number(const std::string &key, uint64_t delta, bool decrement, uint64_t &number) {
+    std::lock_guard<std::mutex> lock(_write_lock);
+    std::size_t slot = find_slot(*_table.load(std::memory_order_relaxed), key, _hash_func(key));
+    if (slot == no_slot) {
+        return false;
+    }
+    item *old = _table.load(std::memory_order_relaxed)->slots[slot].load(std::memory_order_relaxed);
+    if (!ParseNumber(old->value.data(), old->value.size(), number)) {
+        throw std::invalid_argument("Value is not a number");
+    }
+    number = AddDelta(number, delta, decrement);
+    return update_element(slot, std::to_string(number));
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,157 @@
+#ifndef AFINA_STORAGE_RCU_LRU_H
+#define AFINA_STORAGE_RCU_LRU_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Read mostly thread safe implementation
+ * Get never takes a lock. Items are immutable: writer builds a new item and publishes it with a single
+ * atomic store into the open addressing index, old items and old index tables are freed only after all
+ * readers that could see them have left, as in RCU. Readers announce themselves in per CPU counters, so
+ * they don't share cache lines with each other.
+ *
+ * Instead of moving node to the list tail, hit just sets the reference bit of the item. Eviction is
+ * CLOCK: hand sweeps ring of items, clears reference bits and evicts the first item that wasn't used
+ * since the previous sweep.
+ *
+ * Writes are serialized by a mutex and could wait for the running readers from time to time. Append,
+ * Prepend, Increment and Decrement build the new value under the same mutex, so they are atomic even
+ * though items are copied.
+ */
+class RcuLRU : public Afina::Storage {
+public:
+    RcuLRU(size_t max_size = 1024);
+
+    ~RcuLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+    // Implements Afina::Storage interface
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+private:
+    static const std::size_t no_slot = std::size_t(-1);
+
+    // Immutable key-value pair, only reference bit is changed after publication
+    struct item {
+        const std::size_t hash;
+        const std::string key;
+        const std::string value;
+        // set by readers, cleared by the clock hand
+        std::atomic<bool> referenced;
+        // position in the clock ring
+        std::size_t position;
+    };
+
+    // Mark of the slot of deleted item, probing goes on through it
+    static item *tombstone();
+
+    // Index with linear probing, slot is either empty, tombstone or item
+    struct table {
+        explicit table(std::size_t capacity);
+
+        std::size_t mask;
+        std::unique_ptr<std::atomic<item *>[]> slots;
+    };
+
+    // Readers that entered and left critical section on one cpu, takes whole cache line to avoid false
+    // sharing. Reader could leave on other cpu, so only sums over all cpus make sense
+    struct alignas(64) reader_count {
+        std::atomic<unsigned long> locks;
+        std::atomic<unsigned long> unlocks;
+    };
+
+    // Read side critical section
+    reader_count &current_readers(std::size_t phase);
+    std::size_t read_lock();
+    void read_unlock(std::size_t phase);
+
+    // Waits until all readers that entered critical section before the call leave it
+    void synchronize();
+
+    // Memory that could be still used by readers, freed in batches
+    void retire(item *it);
+    void retire(table *t);
+    void reclaim();
+
+    // slot of the key in the table, or no_slot if there is no key
+    std::size_t find_slot(const table &t, const std::string &key, std::size_t hash) const;
+    // places new item into the index and the clock ring
+    void link_item(item *it);
+    // replaces item in the slot
+    void replace_item(std::size_t slot, item *from, item *to);
+    // removes item from the index and the ring
+    void unlink_item(std::size_t slot, item *it);
+
+    bool add_element(const std::string &key, std::size_t hash, const std::string &value);
+    bool update_element(std::size_t slot, const std::string &value);
+    bool add_number(const std::string &key, uint64_t delta, bool decrement, uint64_t &number);
+    // CLOCK sweep, evicts one item
+    void evict();
+    // rebuilds the index once there are too many used slots
+    void grow();
+
+    // Maximum number of bytes could be stored in this cache.
+    // i.e all (keys+values) must be less the _max_size
+    std::size_t _max_size;
+    std::size_t _cur_size;
+
+    std::atomic<table *> _table;
+    // items and tombstones in the current table
+    std::size_t _used_slots;
+
+    // Clock ring, nullptr marks free position
+    std::vector<item *> _ring;
+    std::vector<std::size_t> _ring_free;
+    std::size_t _hand;
+
+    // Readers counters: two phases, one counter per cpu in each. They live in one block aligned by hand,
+    // array new doesn't respect alignas before C++17
+    std::atomic<std::size_t> _phase;
+    std::size_t _cpus;
+    std::unique_ptr<char[]> _readers_memory;
+    reader_count *_readers;
+
+    std::mutex _write_lock;
+    std::vector<item *> _retired_items;
+    std::vector<table *> _retired_tables;
+
+    std::hash<std::string> _hash_func;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_RCU_LRU_H
@@ -0,0 +1,185 @@
+#ifndef AFINA_STORAGE_ROBIN_HOOD_INDEX_H
+#define AFINA_STORAGE_ROBIN_HOOD_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Open addressing hash index
+ * Maps precomputed hash values onto pointers to the objects owned by someone else. Collisions are resolved by
+ * linear probing with Robin Hood displacement, deletion is done by backward shift, so there are no tombstones
+ * and probe sequences stay short even under heavy churn.
+ *
+ * Each slot keeps 32 bits of the hash as a fingerprint, so probing compares keys only when fingerprints match
+ * and the whole probe sequence usually fits in one or two cache lines.
+ *
+ * Index doesn't know anything about keys: lookups take an equality predicate that is called for candidate
+ * objects only. HashOf must return the same hash object has been inserted with, it is used to move elements
+ * on table growth. That is NOT thread safe implementation.
+ */
+template <typename T, typename HashOf> class RobinHoodIndex {
+public:
+    explicit RobinHoodIndex(std::size_t capacity = 16) : _size(0) { rehash(round_up(capacity)); }
+
+    /**
+     * Returns object with the given hash for which predicate returns true or nullptr if there is no such
+     * object in the index
+     */
+    template <typename Eq> T *Find(std::size_t hash, Eq eq) const {
+        const uint32_t fp = fingerprint(hash);
+        std::size_t pos = hash & _mask;
+        for (uint32_t dist = 1;; dist++, pos = (pos + 1) & _mask) {
+            const slot &s = _slots[pos];
+            // Robin Hood invariant: once we meet an element that is closer to its home than we are, the
+            // searched one can't be further in the sequence
+            if (s.dist < dist) {
+                return nullptr;
+            }
+            if (s.fp == fp && eq(*s.value)) {
+                return s.value;
+            }
+        }
+    }
+
+    /**
+     * Adds new object into index. Caller must ensure that there is no equal object in the index already
+     */
+    void Insert(std::size_t hash, T *value) {
+        if ((_size + 1) * 8 > _slots.size() * 7) {
+            rehash(_slots.size() * 2);
+        }
+        place(hash, value);
+        _size++;
+    }
+
+    /**
+     * Removes exactly given object from the index, returns false if it wasn't found
+     */
+    bool Erase(std::size_t hash, const T *value) {
+        std::size_t pos = hash & _mask;
+        for (uint32_t dist = 1;; dist++, pos = (pos + 1) & _mask) {
+            slot &s = _slots[pos];
+            if (s.dist < dist) {
+                return false;
+            }
+            if (s.value == value) {
+                break;
+            }
+        }
+
+        // Backward shift: pull following elements one position closer to their home slots
+        std::size_t next = (pos + 1) & _mask;
+        while (_slots[next].dist > 1) {
+            _slots[pos] = _slots[next];
+            _slots[pos].dist--;
+            pos = next;
+            next = (next + 1) & _mask;
+        }
+        _slots[pos] = slot();
+        _size--;
+        return true;
+    }
+
+    /**
+     * Points existing entry to a new location of the same object, returns false if entry wasn't found
+     */
+    bool Replace(std::size_t hash, const T *from, T *to) {
+        std::size_t pos = hash & _mask;
+        for (uint32_t dist = 1;; dist++, pos = (pos + 1) & _mask) {
+            slot &s = _slots[pos];
+            if (s.dist < dist) {
+                return false;
+            }
+            if (s.value == from) {
+                s.value = to;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Hints CPU to load home slot of the given hash, so that following Find wouldn't wait for memory
+     */
+    void Prefetch(std::size_t hash) const { __builtin_prefetch(&_slots[hash & _mask]); }
+
+    void Clear() {
+        _slots.assign(_slots.size(), slot());
+        _size = 0;
+    }
+
+    std::size_t Size() const { return _size; }
+
+    std::size_t Capacity() const { return _slots.size(); }
+
+    // Number of bytes index occupies on heap
+    std::size_t MemoryUsage() const { return _slots.capacity() * sizeof(slot); }
+
+private:
+    struct slot {
+        slot() : fp(0), dist(0), value(nullptr) {}
+
+        // upper 32 bits of the hash
+        uint32_t fp;
+        // distance from the home slot plus one, 0 means slot is empty
+        uint32_t dist;
+        T *value;
+    };
+
+    static uint32_t fingerprint(std::size_t hash) { return static_cast<uint32_t>(uint64_t(hash) >> 32); }
+
+    static std::size_t round_up(std::size_t n) {
+        std::size_t result = 16;
+        while (result < n) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // Puts element into the table, table must have at least one free slot
+    void place(std::size_t hash, T *value) {
+        slot cur;
+        cur.fp = fingerprint(hash);
+        cur.dist = 1;
+        cur.value = value;
+
+        std::size_t pos = hash & _mask;
+        for (;; pos = (pos + 1) & _mask, cur.dist++) {
+            slot &s = _slots[pos];
+            if (s.dist == 0) {
+                s = cur;
+                return;
+            }
+            // Take from the rich: element closer to its home gives place to the poorer one
+            if (s.dist < cur.dist) {
+                std::swap(s, cur);
+            }
+        }
+    }
+
+    void rehash(std::size_t capacity) {
+        std::vector<slot> old(capacity);
+        old.swap(_slots);
+        _mask = capacity - 1;
+
+        HashOf hash_of;
+        for (std::size_t i = 0; i < old.size(); i++) {
+            if (old[i].dist != 0) {
+                place(hash_of(*old[i].value), old[i].value);
+            }
+        }
+    }
+
+    std::vector<slot> _slots;
+    std::size_t _mask;
+    std::size_t _size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ROBIN_HOOD_INDEX_H
@@ -0,0 +1,284 @@
+#include "SampledLRU.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#include "CoarseClock.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Holds rwlock for reading or writing until the end of the scope
+class lock_guard {
+public:
+    lock_guard(pthread_rwlock_t &lock, bool write) : _lock(lock) {
+        if (write) {
+            pthread_rwlock_wrlock(&_lock);
+        } else {
+            pthread_rwlock_rdlock(&_lock);
+        }
+    }
+    ~lock_guard() { pthread_rwlock_unlock(&_lock); }
+
+private:
+    pthread_rwlock_t &_lock;
+};
+
+} // namespace
+
+SampledLRU::SampledLRU(size_t max_size)
+    : _max_size(max_size), _cur_size(0), _evictions(0), _access(new std::atomic<uint32_t>[16]), _capacity(16),
+      _random(88172645463325252ull) {
+    _pool.reserve(kPoolSize + 1);
+
+    // Otherwise steady stream of gets could starve writers forever
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&_lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+}
+
+SampledLRU::~SampledLRU() {
+    _index.Clear();
+    for (sampled_node *node : _nodes) {
+        free_node(node);
+    }
+    pthread_rwlock_destroy(&_lock);
+}
+
+// See SampledLRU.h
+std::size_t SampledLRU::ItemSize(std::size_t key_size, std::size_t value_size) {
+    // index slot is a fingerprint and distance followed by the pointer
+    const std::size_t arrays = sizeof(sampled_node *) + sizeof(uint32_t) + 2 * sizeof(uint32_t) + sizeof(void *);
+    return sizeof(sampled_node) + key_size + value_size + arrays;
+}
+
+// See SampledLRU.h
+SampledLRU::sampled_node *SampledLRU::new_node(const char *key, std::size_t key_size, std::size_t hash,
+                                               std::size_t value_size) {
+    void *mem = ::operator new(sizeof(sampled_node) + key_size + value_size);
+    sampled_node *node = new (mem) sampled_node{hash, 0, uint32_t(key_size), uint32_t(value_size)};
+    std::memcpy(node->key(), key, key_size);
+    return node;
+}
+
+// See SampledLRU.h
+void SampledLRU::free_node(sampled_node *node) {
+    node->~sampled_node();
+    ::operator delete(node);
+}
+
+// See SampledLRU.h
+SampledLRU::sampled_node *SampledLRU::find_node(const std::string &key, std::size_t hash) const {
+    return _index.Find(hash, [&key](const sampled_node &node) {
+        return node.key_size == key.size() && std::memcmp(node.key(), key.data(), key.size()) == 0;
+    });
+}
+
+// See SampledLRU.h
+void SampledLRU::touch(const sampled_node &node, uint32_t now) {
+    // Hot items are hit many times within the same tick, don't dirty the cache line for nothing
+    std::atomic<uint32_t> &access = _access[node.position];
+    if (access.load(std::memory_order_relaxed) != now) {
+        access.store(now, std::memory_order_relaxed);
+    }
+}
+
+// See SampledLRU.h
+void SampledLRU::sample(uint32_t now) {
+    for (std::size_t i = 0; i < kSamples; i++) {
+        // xorshift64
+        _random ^= _random << 13;
+        _random ^= _random >> 7;
+        _random ^= _random << 17;
+
+        sampled_node *node = _nodes[_random % _nodes.size()];
+        auto same = [node](const candidate &c) { return c.node == node; };
+        if (std::find_if(_pool.begin(), _pool.end(), same) != _pool.end()) {
+            continue;
+        }
+
+        // Idle times are taken relative to the same now, so unsigned difference orders them even over the wrap
+        uint32_t access = _access[node->position].load(std::memory_order_relaxed);
+        auto less_idle = [now](const candidate &a, const candidate &b) { return now - a.access < now - b.access; };
+        candidate added{node, access};
+        _pool.insert(std::upper_bound(_pool.begin(), _pool.end(), added, less_idle), added);
+        if (_pool.size() > kPoolSize) {
+            _pool.erase(_pool.begin());
+        }
+    }
+}
+
+// See SampledLRU.h
+void SampledLRU::evict(const sampled_node *keep) {
+    uint32_t now = CoarseClock::NowMs();
+    while (true) {
+        // Fresh samples every round, pool only keeps the best of them
+        sample(now);
+
+        candidate best = _pool.back();
+        _pool.pop_back();
+        if (best.node == keep) {
+            continue;
+        }
+        if (_access[best.node->position].load(std::memory_order_relaxed) != best.access) {
+            // Used since it was sampled, not a good victim anymore
+            continue;
+        }
+
+        delete_node(*best.node);
+        _evictions.fetch_add(1, std::memory_order_relaxed);
+        Count(StorageCounters::kEvictions);
+        return;
+    }
+}
+
+// add to the storage the element which exactly is not in storage
+bool SampledLRU::add_element(const std::string &key, std::size_t hash, const std::string &value) {
+    std::size_t addsize = ItemSize(key.size(), value.size());
+    if (addsize > _max_size) {
+        return false; // no chances to put the element to the storage
+    }
+
+    while (addsize + _cur_size > _max_size) {
+        evict(nullptr);
+    }
+
+    if (_nodes.size() == _capacity) {
+        // Readers are locked out, so the times could be moved with plain loads and stores
+        std::unique_ptr<std::atomic<uint32_t>[]> access(new std::atomic<uint32_t>[_capacity * 2]);
+        for (std::size_t i = 0; i < _nodes.size(); i++) {
+            access[i].store(_access[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        _access.swap(access);
+        _capacity *= 2;
+    }
+
+    sampled_node *node = new_node(key.data(), key.size(), hash, value.size());
+    std::memcpy(node->value(), value.data(), value.size());
+    node->position = _nodes.size();
+    _nodes.push_back(node);
+    _access[node->position].store(CoarseClock::NowMs(), std::memory_order_relaxed);
+
+    _index.Insert(hash, node);
+    _cur_size += addsize;
+    Count(StorageCounters::kBytes, addsize);
+    Count(StorageCounters::kItems);
+    return true;
+}
+
+// update value of the exactly existing element
+bool SampledLRU::update_element(sampled_node &node, const std::string &value) {
+    std::size_t old_size = ItemSize(node.key_size, node.value_size);
+    std::size_t new_size = ItemSize(node.key_size, value.size());
+    if (new_size > _max_size) {
+        return false;
+    }
+
+    while (_cur_size - old_size + new_size > _max_size) {
+        evict(&node);
+    }
+    _cur_size = _cur_size - old_size + new_size;
+    Count(StorageCounters::kBytes, int64_t(new_size) - int64_t(old_size));
+
+    // Value of other size needs other block. Readers are locked out, so the node is moved with no care
+    sampled_node *updated = &node;
+    if (value.size() != node.value_size) {
+        updated = new_node(node.key(), node.key_size, node.hash, value.size());
+        updated->position = node.position;
+        _nodes[node.position] = updated;
+        _index.Replace(node.hash, &node, updated);
+        for (candidate &c : _pool) {
+            if (c.node == &node) {
+                c.node = updated;
+            }
+        }
+        free_node(&node);
+    }
+    std::memcpy(updated->value(), value.data(), value.size());
+    touch(*updated, CoarseClock::NowMs());
+    return true;
+}
+
+// delete node that exactly exist
+void SampledLRU::delete_node(sampled_node &node) {
+    _cur_size -= ItemSize(node.key_size, node.value_size);
+    Count(StorageCounters::kBytes, -int64_t(ItemSize(node.key_size, node.value_size)));
+    _index.Erase(node.hash, &node);
+
+    auto same = [&node](const candidate &c) { return c.node == &node; };
+    _pool.erase(std::remove_if(_pool.begin(), _pool.end(), same), _pool.end());
+
+    // The last node takes the free place, arrays stay dense for sampling
+    sampled_node *last = _nodes.back();
+    _access[node.position].store(_access[last->position].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    _nodes[node.position] = last;
+    last->position = node.position;
+    _nodes.pop_back();
+    free_node(&node);
+    Count(StorageCounters::kItems, -1);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SampledLRU::Put(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    lock_guard guard(_lock, true);
+    sampled_node *node = find_node(key, hash);
+    if (node == nullptr) {
+        return add_element(key, hash, value);
+    }
+    return update_element(*node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SampledLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    lock_guard guard(_lock, true);
+    if (find_node(key, hash) != nullptr) {
+        return false;
+    }
+    return add_element(key, hash, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SampledLRU::Set(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    lock_guard guard(_lock, true);
+    sampled_node *node = find_node(key, hash);
+    if (node == nullptr) {
+        return false;
+    }
+    return update_element(*node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SampledLRU::Delete(const std::string &key) {
+    std::size_t hash = _hash_func(key);
+    lock_guard guard(_lock, true);
+    sampled_node *node = find_node(key, hash);
+    if (node == nullptr) {
+        return false;
+    }
+    delete_node(*node);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SampledLRU::Get(const std::string &key, std::string &value) {
+    std::size_t hash = _hash_func(key);
+    lock_guard guard(_lock, false);
+    sampled_node *node = find_node(key, hash);
+    if (node == nullptr) {
+        return false;
+    }
+    value.assign(node->value(), node->value_size);
+    touch(*node, CoarseClock::NowMs());
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,145 @@
+#ifndef AFINA_STORAGE_SAMPLED_LRU_H
+#define AFINA_STORAGE_SAMPLED_LRU_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+
+#include <afina/Storage.h>
+
+#include "RobinHoodIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Sampled LRU implementation
+ * Approximates LRU the way Redis does: there is no recency list, each item only has the coarse time of the
+ * last access, see CoarseClock::NowMs. Times live in a dense array next to the array of nodes, so a hit
+ * writes 4 bytes at most, and nothing if the time hasn't changed since the previous hit.
+ *
+ * To free space kSamples random items are sampled and merged into the pool of up to kPoolSize eviction
+ * candidates, ordered by idle time. The candidate idle for the longest time is evicted, unless it has been
+ * used since it got to the pool. Pool is kept between evictions, so it accumulates the best candidates of
+ * several rounds of sampling.
+ *
+ * Key and value are placed right after the node header, so each item costs one allocation. Budget is
+ * charged with the whole footprint of the item, see ItemSize.
+ *
+ * Get takes the lock for reading only, so hits of different threads go in parallel: the access time is an
+ * atomic, the rest of the item is not changed by reads. Writes take the lock exclusively, waiting writer
+ * blocks new readers.
+ */
+class SampledLRU : public Afina::Storage {
+public:
+    SampledLRU(size_t max_size = 1024);
+
+    ~SampledLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    /**
+     * Number of bytes an item with given key and value sizes takes from the storage budget: node header,
+     * key and value bytes, its slots in the arrays of nodes and access times and the index slot
+     */
+    static std::size_t ItemSize(std::size_t key_size, std::size_t value_size);
+
+    // Number of items evicted to free space since the storage creation
+    std::size_t Evictions() const { return _evictions.load(std::memory_order_relaxed); }
+
+private:
+    // Items sampled per round and size of the eviction pool, the same as Redis defaults
+    static const std::size_t kSamples = 5;
+    static const std::size_t kPoolSize = 16;
+
+    // Node header, key and value bytes follow it in the same memory block
+    struct sampled_node {
+        // hash of the key, cached to not recompute it on eviction and index growth
+        std::size_t hash;
+        // position in the arrays of nodes and access times
+        std::size_t position;
+        uint32_t key_size;
+        uint32_t value_size;
+
+        char *key() { return reinterpret_cast<char *>(this + 1); }
+        const char *key() const { return reinterpret_cast<const char *>(this + 1); }
+        char *value() { return key() + key_size; }
+        const char *value() const { return key() + key_size; }
+    };
+
+    struct node_hash {
+        std::size_t operator()(const sampled_node &node) const { return node.hash; }
+    };
+
+    // Eviction candidate and its access time at the moment it was sampled
+    struct candidate {
+        sampled_node *node;
+        uint32_t access;
+    };
+
+    // Maximum number of bytes could be stored in this cache.
+    // i.e all items, see ItemSize, must be less the _max_size
+    std::size_t _max_size;
+    std::size_t _cur_size;
+    std::atomic<std::size_t> _evictions;
+
+    // Dense arrays of nodes and their access times, own all nodes. Times array has room for _capacity items
+    std::vector<sampled_node *> _nodes;
+    std::unique_ptr<std::atomic<uint32_t>[]> _access;
+    std::size_t _capacity;
+
+    // Candidates ordered by idle time ascending, the best one is the last
+    std::vector<candidate> _pool;
+    // State of xorshift generator picking samples
+    uint64_t _random;
+
+    // Index of nodes from the array above, allows fast random access to elements by sampled_node#key
+    RobinHoodIndex<sampled_node, node_hash> _index;
+
+    std::hash<std::string> _hash_func;
+
+    pthread_rwlock_t _lock;
+
+private:
+    // allocate node with key and room for the value placed right after the header
+    static sampled_node *new_node(const char *key, std::size_t key_size, std::size_t hash, std::size_t value_size);
+    static void free_node(sampled_node *node);
+
+    // find node by key and its hash
+    sampled_node *find_node(const std::string &key, std::size_t hash) const;
+    // add new element to the storage
+    bool add_element(const std::string &key, std::size_t hash, const std::string &value);
+    // update existing node
+    bool update_element(sampled_node &node, const std::string &value);
+    // delete existing node
+    void delete_node(sampled_node &node);
+    // evicts one node, but never the keep one
+    void evict(const sampled_node *keep);
+    // adds some random nodes to the pool
+    void sample(uint32_t now);
+    // node has been used right now
+    void touch(const sampled_node &node, uint32_t now);
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SAMPLED_LRU_H
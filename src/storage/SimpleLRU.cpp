@@ -1,186 +1,644 @@
 #include "SimpleLRU.h"
 
+#include <new>
+#include <stdexcept>
+
 namespace Afina {
 namespace Backend {
 
-//add to the storage the element which exactly is not in storage
-bool SimpleLRU::add_element(const std::string &key, const std::string &value){
+const std::size_t SimpleLRU::kReapBatch;
+
+SimpleLRU::~SimpleLRU() {
+    _lru_index.clear();
 
-    std::size_t addsize = key.length() + value.length();
-    if( addsize > _max_size){ 
-        return false; //no chances to put the element to the storage
+    while (_lru_head != nullptr) {
+        lru_node *next = _lru_head->next;
+        unref(_lru_head);
+        _lru_head = next;
     }
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::ItemSize(std::size_t key_size, std::size_t value_size) {
+    // index entry is a red-black tree node: color, parent, left and right links followed by the value
+    const std::size_t index_entry = 4 * sizeof(void *) + sizeof(decltype(_lru_index)::value_type);
+    return sizeof(lru_node) + key_size + value_size + index_entry;
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::node_size(const lru_node &node) { return ItemSize(node.key_size, node.capacity); }
+
+// allocate node with key and room for the value placed right after the header
+SimpleLRU::lru_node *SimpleLRU::alloc_node(const char *key, std::size_t key_size, std::size_t capacity) {
+    void *mem = ::operator new(sizeof(lru_node) + key_size + capacity);
+
+    lru_node *node = new (mem) lru_node;
+    node->prev = nullptr;
+    node->next = nullptr;
+    node->key_size = key_size;
+    node->value_size = 0;
+    node->capacity = capacity;
+    node->is_protected = false;
+    node->version = 0;
+    node->refs.store(1, std::memory_order_relaxed);
+
+    std::memcpy(node->key(), key, key_size);
+    return node;
+}
+
+// allocate node with key and value placed right after the header
+SimpleLRU::lru_node *SimpleLRU::new_node(const char *key, std::size_t key_size, const std::string &value) {
+    lru_node *node = alloc_node(key, key_size, value.size());
+    std::memcpy(node->value(), value.data(), value.size());
+    node->value_size = value.size();
+    return node;
+}
 
-    while( addsize + _cur_size > _max_size){
-        delete_node(std::ref(*_lru_head));
+// See SimpleLRU.h
+void SimpleLRU::unref(SimpleLRU::lru_node *node) {
+    if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        node->~lru_node();
+        ::operator delete(node);
     }
+}
 
-    if (_lru_head == nullptr){
-        SimpleLRU::lru_node *node = new lru_node{key, value, nullptr, nullptr};
-        _lru_head = std::move(std::unique_ptr<lru_node>(node));
-        _lru_index.emplace(std::ref(node->key), std::ref(*node));
-        _lru_tail = node;
+// See SimpleLRU.h
+ValueView SimpleLRU::make_view(SimpleLRU::lru_node &node) {
+    // Reference is taken before the shared_ptr: if its allocation fails, deleter is called anyway
+    node.refs.fetch_add(1, std::memory_order_relaxed);
+    return ValueView(std::shared_ptr<const void>(&node,
+                                                 [](const void *p) {
+                                                     unref(static_cast<lru_node *>(const_cast<void *>(p)));
+                                                 }),
+                     node.value(), node.value_size);
+}
+
+// add to the storage the element which exactly is not in storage
+bool SimpleLRU::add_element(const std::string &key, const std::string &value, uint32_t ttl) {
+    std::size_t addsize = ItemSize(key.size(), value.size());
+    if (addsize > _max_size) {
+        return false; // no chances to put the element to the storage
+    }
+
+    while (addsize + _cur_size > _max_size) {
+        free_space();
     }
-    else{
-        SimpleLRU::lru_node *node = new lru_node{key, value, _lru_tail, nullptr};
-        _lru_tail->next = std::move(std::unique_ptr<lru_node>(node));
-        _lru_index.emplace(std::ref(node->key), std::ref(*node));
+
+    // New node is the most recent one in probation segment
+    lru_node *node = new_node(key.data(), key.size(), value);
+    node->version = ++_last_version;
+    if (_protected_head == nullptr) {
+        node->prev = _lru_tail;
+        if (_lru_tail == nullptr) {
+            _lru_head = node;
+        } else {
+            _lru_tail->next = node;
+        }
         _lru_tail = node;
+    } else {
+        node->prev = _protected_head->prev;
+        node->next = _protected_head;
+        if (node->prev == nullptr) {
+            _lru_head = node;
+        } else {
+            node->prev->next = node;
+        }
+        _protected_head->prev = node;
     }
+
+    _lru_index.emplace(key_ref(node->key(), node->key_size), node);
     _cur_size += addsize;
+    Count(StorageCounters::kBytes, addsize);
+    set_ttl(*node, ttl);
+    Count(StorageCounters::kItems);
+
+    return true;
+}
+
+// update value of the exactly existing element
+bool SimpleLRU::update_element(SimpleLRU::lru_node &node, const std::string &value, uint32_t ttl) {
+    // Value is written in place while it fits into the node and doesn't waste more than half of it,
+    // otherwise node gets reallocated with exact size. Views are created under the same lock as
+    // update runs, so a node with no views now won't get them until update finishes
+    bool in_place = value.size() <= node.capacity && value.size() >= node.capacity / 2 &&
+                    node.refs.load(std::memory_order_acquire) == 1;
+
+    std::size_t old_size = node_size(node);
+    std::size_t new_size = in_place ? old_size : ItemSize(node.key_size, value.size());
+    if (new_size > _max_size) {
+        return false; // а при обращении к элементу с неудачной попыткой замены нужно перемещать его
+    }
+
+    touch(node);
+
+    while (_cur_size - old_size + new_size > _max_size) {
+        free_space();
+    }
+    _cur_size = _cur_size - old_size + new_size;
+    Count(StorageCounters::kBytes, int64_t(new_size) - int64_t(old_size));
+    if (node.is_protected) {
+        _protected_size = _protected_size - old_size + new_size;
+    }
+
+    if (in_place) {
+        std::memcpy(node.value(), value.data(), value.size());
+        node.value_size = value.size();
+        node.version = ++_last_version;
+        set_ttl(node, ttl);
+        return true;
+    }
 
+    lru_node *updated = new_node(node.key(), node.key_size, value);
+    updated->version = ++_last_version;
+    replace_node(node, *updated);
+    set_ttl(*updated, ttl);
     return true;
 }
 
-//update value of the exactly existing element
-bool SimpleLRU::update_element(SimpleLRU::lru_node &node, const std::string &value){
+// add data to either end of the value of the exactly existing element
+bool SimpleLRU::concat_element(SimpleLRU::lru_node &node, const std::string &data, bool front) {
+    std::size_t value_size = node.value_size + data.size();
+    bool in_place = value_size <= node.capacity && node.refs.load(std::memory_order_acquire) == 1;
 
-    size_t newValSize = value.length();
-    size_t oldValSize = node.value.length();
+    // Grown node gets spare room for the next appends, unless that doesn't fit into the storage
+    std::size_t capacity = node.capacity;
+    if (!in_place) {
+        capacity = value_size + value_size / 2;
+        if (ItemSize(node.key_size, capacity) > _max_size) {
+            capacity = value_size;
+        }
+    }
 
-    if(node.key.length()+ newValSize > _max_size){
-        return false; //а при обращении к элементу с неудачной попыткой замены нужно перемещать его 
+    std::size_t old_size = node_size(node);
+    std::size_t new_size = ItemSize(node.key_size, capacity);
+    if (new_size > _max_size) {
+        return false;
     }
 
-    move_tail(node);
+    touch(node);
 
-    while( (_cur_size + newValSize - oldValSize) > _max_size){
-        delete_node(std::ref(*_lru_head));
+    while (_cur_size - old_size + new_size > _max_size) {
+        free_space();
+    }
+    _cur_size = _cur_size - old_size + new_size;
+    Count(StorageCounters::kBytes, int64_t(new_size) - int64_t(old_size));
+    if (node.is_protected) {
+        _protected_size = _protected_size - old_size + new_size;
     }
 
-    _cur_size = _cur_size + newValSize - oldValSize;
-    node.value = value;
+    if (in_place) {
+        if (front) {
+            std::memmove(node.value() + data.size(), node.value(), node.value_size);
+            std::memcpy(node.value(), data.data(), data.size());
+        } else {
+            std::memcpy(node.value() + node.value_size, data.data(), data.size());
+        }
+        node.value_size = value_size;
+        node.version = ++_last_version;
+        return true;
+    }
+
+    lru_node *updated = alloc_node(node.key(), node.key_size, capacity);
+    if (front) {
+        std::memcpy(updated->value(), data.data(), data.size());
+        std::memcpy(updated->value() + data.size(), node.value(), node.value_size);
+    } else {
+        std::memcpy(updated->value(), node.value(), node.value_size);
+        std::memcpy(updated->value() + node.value_size, data.data(), data.size());
+    }
+    updated->value_size = value_size;
+    updated->version = ++_last_version;
+    replace_node(node, *updated);
     return true;
 }
 
+// change the number stored in the exactly existing element
+bool SimpleLRU::add_number(SimpleLRU::lru_node &node, uint64_t delta, bool decrement, uint64_t &number) {
+    if (!ParseNumber(node.value(), node.value_size, number)) {
+        throw std::invalid_argument("Value is not a number");
+    }
+    number = AddDelta(number, delta, decrement);
+
+    char digits[kMaxNumberDigits];
+    std::size_t size = FormatNumber(number, digits);
+    if (size <= node.capacity && node.refs.load(std::memory_order_acquire) == 1) {
+        // Node keeps its size, budget doesn't change
+        std::memcpy(node.value(), digits, size);
+        node.value_size = size;
+        node.version = ++_last_version;
+        touch(node);
+        return true;
+    }
+
+    // find_node has dropped the node if it is expired, so some ttl is left
+    uint32_t ttl = node.expire == 0 ? 0 : node.expire - _now;
+    return update_element(node, std::string(digits, size), ttl);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::replace_node(SimpleLRU::lru_node &node, SimpleLRU::lru_node &updated) {
+    updated.is_protected = node.is_protected;
+    replace_link(node, updated);
+    if (_protected_head == &node) {
+        _protected_head = &updated;
+    }
+    shrink_protected(&updated);
+
+    auto it = _lru_index.find(key_ref(node.key(), node.key_size));
+    it = _lru_index.erase(it);
+    _lru_index.emplace_hint(it, key_ref(updated.key(), updated.key_size), &updated);
 
-//move the most recently used element to the tail
-void SimpleLRU::move_tail(SimpleLRU::lru_node &node){
+    uint32_t expire = node.expire;
+    _wheel.Cancel(node);
+    if (expire != 0) {
+        _wheel.Schedule(updated, expire);
+    }
+    unref(&node);
+}
 
-    if( node.next == nullptr){ //already tail
+// move the most recently used element to the tail
+void SimpleLRU::move_tail(SimpleLRU::lru_node &node) {
+    if (&node == _lru_tail) { // already tail
         return;
     }
-    else if( node.prev == nullptr){ //head element
-        SimpleLRU::lru_node *ptr = node.next->prev;
-        _lru_tail->next = std::move(_lru_head);
-        _lru_tail->next->prev = _lru_tail;
-        _lru_head = std::move(ptr->next);
-        _lru_head->prev = nullptr;
-        _lru_tail = ptr;
-    }
-    else{ //in the middle
-        SimpleLRU::lru_node *ptr = node.next->prev;
-        ptr->next->prev = ptr->prev;
-        _lru_tail->next = std::move(ptr->prev->next);
-        ptr->prev->next = std::move(ptr->next);
-        ptr->prev = _lru_tail;
-        _lru_tail = ptr;
-    }
-    
-    
-    return;
-}
-
-//delete node that exactly exist
-bool SimpleLRU::delete_node(SimpleLRU::lru_node &node){
-
-    _cur_size -= (node.key.length() + node.value.length()); 
-    _lru_index.erase(node.key);
-
-    if( node.next != nullptr ){
-        if(node.prev != nullptr ){ //in the middle
-            SimpleLRU::lru_node * ptr = node.prev;
-            ptr->next = std::move(node.next);
-            ptr->next->prev = ptr;
-        }
-        else{ //head, not tail
-            _lru_head = std::move(_lru_head->next);
-            _lru_head->prev = nullptr;
-        }
+
+    unlink(node);
+
+    node.prev = _lru_tail;
+    _lru_tail->next = &node;
+    _lru_tail = &node;
+}
+
+// move node to the tail, in segmented mode promote it to protected segment first
+void SimpleLRU::touch(SimpleLRU::lru_node &node) {
+    if (_protected_max == 0) {
+        move_tail(node);
+        return;
     }
-    else{
-        if(node.prev != nullptr ){ // tail, not head
-            _lru_tail = _lru_tail->prev;
-            node.prev->next = nullptr;
+
+    if (!node.is_protected) {
+        node.is_protected = true;
+        _protected_size += node_size(node);
+        if (_protected_head == nullptr) {
+            _protected_head = &node;
         }
-        else{ //head and tail at the same time
-            _lru_head = nullptr;
-            _lru_tail = nullptr;
+    } else if (&node == _protected_head && node.next != nullptr) {
+        _protected_head = node.next;
+    }
+
+    move_tail(node);
+    shrink_protected(&node);
+}
+
+// segment boundary moves towards the tail, demoted nodes become the most recent ones in probation
+void SimpleLRU::shrink_protected(const SimpleLRU::lru_node *keep) {
+    while (_protected_size > _protected_max && _protected_head != keep) {
+        _protected_head->is_protected = false;
+        _protected_size -= node_size(*_protected_head);
+        _protected_head = _protected_head->next;
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::evict_head() {
+    lru_node &node = *_lru_head;
+    if (_on_evict && (node.expire == 0 || int32_t(_now - node.expire) < 0)) {
+        _on_evict(node.key(), node.key_size, node.value(), node.value_size, node.expire == 0 ? 0 : node.expire - _now);
+    }
+    delete_node(node);
+    _evictions++;
+    Count(StorageCounters::kEvictions);
+}
+
+// See SimpleLRU.h
+void SimpleLRU::free_space() {
+    if (_wheel.Advance(_now, 1, [this](TimerWheel::entry &timer) {
+            delete_node(static_cast<lru_node &>(timer));
+            _expirations++;
+        }) == 0) {
+        evict_head();
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::advance_clock() {
+    _now = CoarseClock::Now();
+    _wheel.Advance(_now, kReapBatch, [this](TimerWheel::entry &timer) {
+        delete_node(static_cast<lru_node &>(timer));
+        _expirations++;
+    });
+}
+
+// See SimpleLRU.h
+SimpleLRU::lru_node *SimpleLRU::find_node(const std::string &key) {
+    auto found = _lru_index.find(key);
+    if (found == _lru_index.end()) {
+        return nullptr;
+    }
+
+    lru_node &node = *found->second;
+    if (node.expire != 0 && int32_t(_now - node.expire) >= 0) {
+        // Reaper hasn't got to it yet
+        delete_node(node);
+        _expirations++;
+        return nullptr;
+    }
+    return &node;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::set_ttl(SimpleLRU::lru_node &node, uint32_t ttl) {
+    _wheel.Cancel(node);
+    if (ttl != 0) {
+        _wheel.Schedule(node, _now + ttl);
+    }
+}
+
+// See SimpleLRU.h
+void SimpleLRU::SetMaxSize(std::size_t max_size) {
+    if (_max_size > 0) {
+        _protected_max = double(_protected_max) * max_size / _max_size;
+    }
+    _max_size = max_size;
+
+    while (_cur_size > _max_size) {
+        evict_head();
+    }
+    shrink_protected(nullptr);
+}
+
+// pop node out of the list
+void SimpleLRU::unlink(SimpleLRU::lru_node &node) {
+    if (node.prev == nullptr) {
+        _lru_head = node.next;
+    } else {
+        node.prev->next = node.next;
+    }
+
+    if (node.next == nullptr) {
+        _lru_tail = node.prev;
+    } else {
+        node.next->prev = node.prev;
+    }
+
+    node.prev = nullptr;
+    node.next = nullptr;
+}
+
+// put node into list on the place of the other one
+void SimpleLRU::replace_link(SimpleLRU::lru_node &from, SimpleLRU::lru_node &to) {
+    to.prev = from.prev;
+    to.next = from.next;
+
+    if (from.prev == nullptr) {
+        _lru_head = &to;
+    } else {
+        from.prev->next = &to;
+    }
+
+    if (from.next == nullptr) {
+        _lru_tail = &to;
+    } else {
+        from.next->prev = &to;
+    }
+}
+
+// delete node that exactly exist
+bool SimpleLRU::delete_node(SimpleLRU::lru_node &node) {
+    _cur_size -= node_size(node);
+    Count(StorageCounters::kBytes, -int64_t(node_size(node)));
+    _lru_index.erase(key_ref(node.key(), node.key_size));
+    if (node.is_protected) {
+        _protected_size -= node_size(node);
+        if (_protected_head == &node) {
+            _protected_head = node.next;
         }
     }
 
+    unlink(node);
+    _wheel.Cancel(node);
+    unref(&node);
+    Count(StorageCounters::kItems, -1);
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Put(const std::string &key, const std::string &value) { 
-    
-    auto found = _lru_index.find(key);
+bool SimpleLRU::Put(const std::string &key, const std::string &value) { return SimpleLRU::PutWithTTL(key, value, 0); }
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return SimpleLRU::PutIfAbsentWithTTL(key, value, 0);
+}
 
-    if(found == _lru_index.end()){
-        return add_element(key, value);
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Set(const std::string &key, const std::string &value) { return SimpleLRU::SetWithTTL(key, value, 0); }
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    advance_clock();
+
+    lru_node *node = find_node(key);
+    if (node == nullptr) {
+        return add_element(key, value, ttl);
+    } else {
+        return update_element(*node, value, ttl);
     }
-    else{
-        SimpleLRU::lru_node &node = found->second.get();
-        return update_element(node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    advance_clock();
+
+    if (find_node(key) != nullptr) {
+        return false;
+    } else {
+        return add_element(key, value, ttl);
     }
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    advance_clock();
 
+    lru_node *node = find_node(key);
+    if (node == nullptr) {
+        return false;
+    } else {
+        return update_element(*node, value, ttl);
+    }
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) { 
-    
-    auto found = _lru_index.find(key);
-    if(found != _lru_index.end()){
+bool SimpleLRU::Delete(const std::string &key) {
+    advance_clock();
+
+    lru_node *node = find_node(key);
+    if (node == nullptr) {
         return false;
+    } else {
+        return delete_node(*node);
     }
-    else{
-        return add_element(key, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Get(const std::string &key, std::string &value) {
+    advance_clock();
+
+    lru_node *node = find_node(key);
+    if (node == nullptr) {
+        return false;
+    } else {
+        value.assign(node->value(), node->value_size);
+        touch(*node);
+        return true;
     }
-    
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Set(const std::string &key, const std::string &value) {
-    
-    auto found = _lru_index.find(key);
+bool SimpleLRU::GetWithVersion(const std::string &key, std::string &value, uint64_t &version) {
+    advance_clock();
 
-    if(found == _lru_index.end()){
+    lru_node *node = find_node(key);
+    if (node == nullptr) {
         return false;
+    } else {
+        value.assign(node->value(), node->value_size);
+        version = node->version;
+        touch(*node);
+        return true;
     }
-    else{
-        SimpleLRU::lru_node &node = found->second.get();
-        return update_element(node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::GetView(const std::string &key, ValueView &value) {
+    advance_clock();
+
+    lru_node *node = find_node(key);
+    if (node == nullptr) {
+        return false;
     }
+
+    value = make_view(*node);
+    touch(*node);
+    return true;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Delete(const std::string &key) { 
-    
-    auto found = _lru_index.find(key);
+bool SimpleLRU::Append(const std::string &key, const std::string &data) {
+    advance_clock();
 
-    if(found == _lru_index.end()){
+    lru_node *node = find_node(key);
+    if (node == nullptr) {
         return false;
+    } else {
+        return concat_element(*node, data, false);
     }
-    else{
-        SimpleLRU::lru_node &node = found->second.get();
-        return delete_node(node);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Prepend(const std::string &key, const std::string &data) {
+    advance_clock();
+
+    lru_node *node = find_node(key);
+    if (node == nullptr) {
+        return false;
+    } else {
+        return concat_element(*node, data, true);
     }
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Get(const std::string &key, std::string &value) { 
-    
-    auto found = _lru_index.find(key);
+bool SimpleLRU::Dump(const std::function<void(std::vector<StoredItem> &part)> &write) {
+    std::vector<StoredItem> items;
+    Copy(items);
+    write(items);
+    return true;
+}
 
-    if(found == _lru_index.end()){
+// See SimpleLRU.h
+void SimpleLRU::Copy(std::vector<StoredItem> &items) {
+    advance_clock();
+
+    items.reserve(items.size() + _lru_index.size());
+    for (lru_node *node = _lru_head; node != nullptr; node = node->next) {
+        if (node->expire != 0 && int32_t(_now - node->expire) >= 0) {
+            continue;
+        }
+        ValueView value = make_view(*node);
+        ValueView key(value.owner(), node->key(), node->key_size);
+        items.push_back(StoredItem{std::move(key), std::move(value), node->expire == 0 ? 0 : node->expire - _now});
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Increment(const std::string &key, uint64_t delta, uint64_t &number) {
+    advance_clock();
+
+    lru_node *node = find_node(key);
+    if (node == nullptr) {
         return false;
+    } else {
+        return add_number(*node, delta, false, number);
     }
-    else{
-        value = found->second.get().value;
-        move_tail(found->second.get());
-        return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &number) {
+    advance_clock();
+
+    lru_node *node = find_node(key);
+    if (node == nullptr) {
+        return false;
+    } else {
+        return add_number(*node, delta, true, number);
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+std::size_t SimpleLRU::MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) {
+    values.assign(keys.size(), ValueView());
+    std::vector<std::size_t> index(keys.size());
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        index[i] = i;
+    }
+    return SimpleLRU::GetViews(keys, index.data(), index.size(), values);
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::GetViews(const std::vector<std::string> &keys, const std::size_t *index, std::size_t count,
+                                std::vector<ValueView> &values) {
+    advance_clock();
+
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        lru_node *node = find_node(keys[index[i]]);
+        if (node != nullptr) {
+            values[index[i]] = make_view(*node);
+            touch(*node);
+            found++;
+        }
     }
+    return found;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl, uint64_t &version) {
+    advance_clock();
+
+    lru_node *node = find_node(key);
+    if (node == nullptr) {
+        version = 0;
+        return false;
+    } else if (node->version != version) {
+        version = node->version;
+        return false;
+    }
+
+    if (!update_element(*node, value, ttl)) {
+        return false;
+    }
+    version = _last_version;
+    return true;
 }
 
 } // namespace Backend
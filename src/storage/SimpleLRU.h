@@ -1,11 +1,19 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
+#include "CoarseClock.h"
+#include "TimerWheel.h"
 #include <afina/Storage.h>
 
 namespace Afina {
@@ -13,29 +21,43 @@ namespace Backend {
 
 /**
  * # Map based implementation
+ * With non zero protected_fraction works as segmented LRU: new items get into probation segment and are
+ * promoted to protected one on the second hit, so items used just once never push out the ones used
+ * repeatedly. Protected segment takes at most protected_fraction of memory, its overflow goes back to
+ * probation. Both segments share one list: probation is the part before the first protected node.
+ *
+ * Items with ttl sit in the timer wheel. Expired item is dropped on access, and each operation also reaps
+ * up to kReapBatch items whose time has come, so dead items free memory without any scan. Space for new
+ * items is taken from expired ones first and only then from the least recently used.
+ *
+ * Each write gives the item the next number of the storage counter as a version, so versions never
+ * repeat even for a key deleted and added back.
+ *
+ * GetView pins the node: node is freed once both storage and all the views have dropped it. Pinned
+ * node is never written in place, update allocates a new one. Memory of nodes dropped by the storage
+ * but still pinned doesn't count against max_size.
+ *
+ * Append and Prepend write into the spare capacity of the node. Node that has to grow is reallocated
+ * with spare room of half the new value, so a key that is appended to over and over gets copied a
+ * logarithmic number of times instead of on each append. Increment and Decrement rewrite the digits in
+ * place too, node is reallocated only if the number gets longer than node capacity.
+ *
+ * Dump pins all the alive nodes in the list order instead of copying them, so the copy is consistent and
+ * takes one pass over the list. Writes that come while the copy is in use reallocate nodes, as for views.
+ *
+ * Eviction listener sees each item evicted to free space, so it could be kept somewhere else. Items
+ * dropped by ttl, deleted or overwritten don't go to the listener.
+ *
  * That is NOT thread safe implementaiton!!
  */
 class SimpleLRU : public Afina::Storage {
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size), _cur_size(0),
-                                        _lru_tail(nullptr), _lru_head(nullptr) {}
+    SimpleLRU(size_t max_size = 1024, double protected_fraction = 0)
+        : _max_size(max_size), _cur_size(0), _protected_max(max_size * protected_fraction), _protected_size(0),
+          _evictions(0), _expirations(0), _last_version(0), _lru_head(nullptr), _lru_tail(nullptr), _protected_head(nullptr),
+          _now(CoarseClock::Now()), _wheel(_now) {}
 
-    ~SimpleLRU() {
-        _lru_index.clear(); 
-
-        while (_lru_head != nullptr) {
-          auto next = std::move(_lru_head->next);
-          _lru_head.reset(nullptr);
-          _lru_head = std::move(next);
-        }
-        /*/
-        while (_lru_tail != nullptr){
-            auto ptr = _lru_tail->prev;
-            ptr->next.reset(nullptr);
-            _lru_tail = ptr;
-        }
-        /*/
-    }
+    ~SimpleLRU();
 
     // Implements Afina::Storage interface
     bool Put(const std::string &key, const std::string &value) override;
@@ -52,40 +74,209 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface
+    bool PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool GetWithVersion(const std::string &key, std::string &value, uint64_t &version) override;
+
+    // Implements Afina::Storage interface
+    bool GetView(const std::string &key, ValueView &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::vector<StoredItem> &part)> &write) override;
+
+    // Implements Afina::Storage interface
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+    // Implements Afina::Storage interface
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) override;
+
+    /**
+     * Part of MultiGet: looks up keys[index[i]] for i < count and puts views to values[index[i]], values
+     * must be big enough already. Returns number of keys found
+     */
+    std::size_t GetViews(const std::vector<std::string> &keys, const std::size_t *index, std::size_t count,
+                         std::vector<ValueView> &values);
+
+    // Implements Afina::Storage interface
+    bool CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl, uint64_t &version) override;
+
+    /**
+     * Number of bytes an item with given key and value sizes takes from the storage budget: node header,
+     * key and value bytes and the index entry
+     */
+    static std::size_t ItemSize(std::size_t key_size, std::size_t value_size);
+
+    // Number of bytes taken by items of probation segment, all items for plain LRU
+    std::size_t ProbationSize() const { return _cur_size - _protected_size; }
+
+    // Number of bytes taken by items of protected segment
+    std::size_t ProtectedSize() const { return _protected_size; }
+
+    std::size_t MaxSize() const { return _max_size; }
+
+    // Number of items evicted to free space since the storage creation
+    std::size_t Evictions() const { return _evictions; }
+
+    // Number of items dropped because of ttl since the storage creation
+    std::size_t Expirations() const { return _expirations; }
+
+    /**
+     * Gets key, value and seconds left to live (zero means forever) of the evicted item. It is called in
+     * the middle of the storage update, so it must not call the storage back
+     */
+    typedef std::function<void(const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                               uint32_t ttl)>
+        EvictionListener;
+
+    void SetEvictionListener(EvictionListener listener) { _on_evict = std::move(listener); }
+
+    /**
+     * Changes storage limit, protected segment limit is scaled along. Least recently used items are
+     * evicted if they don't fit anymore
+     */
+    void SetMaxSize(std::size_t max_size);
+
+    /**
+     * Appends views of all the alive items to the vector, from the least to the most recently used, that is
+     * the part Dump passes on
+     */
+    void Copy(std::vector<StoredItem> &items);
+
 private:
-    // LRU cache node
-    using lru_node = struct lru_node {
-        const std::string key;
-        std::string value;
-        lru_node * prev;
-        std::unique_ptr<lru_node> next;
+    // Max number of expired items reaped by single operation
+    static const std::size_t kReapBatch = 16;
+
+    // LRU cache node. Header, key and value live in one memory block: key bytes are placed right after
+    // the header and followed by the value bytes, so each item costs exactly one allocation. Timer of
+    // the node is scheduled only if item has ttl
+    struct lru_node : public TimerWheel::entry {
+        lru_node *prev;
+        lru_node *next;
+
+        uint32_t key_size;
+        uint32_t value_size;
+        // number of bytes reserved for the value, could be more than value_size after update in place
+        uint32_t capacity;
+        // node belongs to protected segment
+        bool is_protected;
+        // changes on each write
+        uint64_t version;
+        // one reference of the storage plus one per view, the last one frees the node
+        std::atomic<uint32_t> refs;
+
+        char *key() { return reinterpret_cast<char *>(this + 1); }
+        char *value() { return key() + key_size; }
     };
+
+    // Reference to the key bytes, either stored in some node or owned by the caller
+    struct key_ref {
+        key_ref(const char *d, std::size_t s) : data(d), size(s) {}
+        key_ref(const std::string &s) : data(s.data()), size(s.size()) {}
+
+        bool operator<(const key_ref &other) const {
+            int cmp = std::memcmp(data, other.data, std::min(size, other.size));
+            return cmp < 0 || (cmp == 0 && size < other.size);
+        }
+
+        const char *data;
+        std::size_t size;
+    };
+
     // Maximum number of bytes could be stored in this cache.
-    // i.e all (keys+values) must be less the _max_size
+    // i.e all items, see ItemSize, must be less the _max_size
     std::size_t _max_size;
     std::size_t _cur_size;
 
+    // Limit and size of protected segment, zero limit means plain LRU
+    std::size_t _protected_max;
+    std::size_t _protected_size;
+
+    std::size_t _evictions;
+    std::size_t _expirations;
+
+    // Version given by the last write
+    uint64_t _last_version;
+
     // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
     // element that wasn't used for longest time.
     //
     // List owns all nodes
-    std::unique_ptr<lru_node> _lru_head;
-    //pointer to the last element of the storage
-    lru_node * _lru_tail; 
+    lru_node *_lru_head;
+    // pointer to the last element of the storage
+    lru_node *_lru_tail;
+    // first node of protected segment, all nodes after it are protected too
+    lru_node *_protected_head;
 
     // Index of nodes from list above, allows fast random access to elements by lru_node#key
-    std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>, std::less<const std::string>> _lru_index;
+    std::map<key_ref, lru_node *> _lru_index;
+
+    // Coarse clock value cached at the beginning of the operation
+    uint32_t _now;
+    // Timers of items with ttl
+    TimerWheel _wheel;
+
+    EvictionListener _on_evict;
 
 private:
+    // allocate node with room for value of given capacity, fill its key only
+    static lru_node *alloc_node(const char *key, std::size_t key_size, std::size_t capacity);
+    // allocate node and fill it with key and value
+    static lru_node *new_node(const char *key, std::size_t key_size, const std::string &value);
+    // drop reference to the node, free it if that was the last one
+    static void unref(lru_node *node);
+    // pin node and make a view of its value
+    static ValueView make_view(lru_node &node);
+    // number of bytes node takes from the storage budget
+    static std::size_t node_size(const lru_node &node);
     // move the most recently used element to tail
-    void move_tail(SimpleLRU::lru_node &node);
+    void move_tail(lru_node &node);
+    // node has been used: move it to tail, promote to protected segment if needed
+    void touch(lru_node &node);
+    // demote protected nodes to probation until segment fits its limit, but never the keep one
+    void shrink_protected(const lru_node *keep);
+    // free space evicting the least recently used node
+    void evict_head();
+    // free space evicting expired node if any, otherwise the least recently used one
+    void free_space();
+    // read the clock and reap some expired items
+    void advance_clock();
+    // find node of the key, expired node is deleted and not returned
+    lru_node *find_node(const std::string &key);
+    // schedule node timer for the given ttl, zero means forever
+    void set_ttl(lru_node &node, uint32_t ttl);
     // add new element to the storage
-    bool add_element(const std::string &key, const std::string &value);
+    bool add_element(const std::string &key, const std::string &value, uint32_t ttl);
     // update existing node
-    bool update_element(SimpleLRU::lru_node &node, const std::string &val);
+    bool update_element(lru_node &node, const std::string &value, uint32_t ttl);
+    // add data to the end or to the front of the existing node value, keeping its ttl
+    bool concat_element(lru_node &node, const std::string &data, bool front);
+    // add delta to the number stored in the existing node, keeping its ttl
+    bool add_number(lru_node &node, uint64_t delta, bool decrement, uint64_t &number);
+    // put updated node in place of the old one in the list, index and timer wheel, drop the old one
+    void replace_node(lru_node &node, lru_node &updated);
     // delete existing node
-    bool delete_node(SimpleLRU::lru_node &node);
-
+    bool delete_node(lru_node &node);
+    // pop node out of the list, node stays in index
+    void unlink(lru_node &node);
+    // put node into list on the place of the other one
+    void replace_link(lru_node &from, lru_node &to);
 };
 
 } // namespace Backend
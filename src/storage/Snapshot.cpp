@@ -0,0 +1,440 @@
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Hash.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char kMagic[8] = {'A', 'F', 'I', 'N', 'A', 'S', 'N', '2'};
+
+// Max payload of one block
+const std::size_t kBlockSize = 64 * 1024;
+
+// Seed of block checksums
+const uint64_t kHashSeed = 0x736e617073686f74;
+
+struct file_header {
+    char magic[8];
+    uint32_t sections;
+    uint32_t reserved;
+    uint64_t table;
+};
+
+struct section_entry {
+    uint64_t offset;
+    uint64_t items;
+};
+
+struct block_header {
+    uint32_t size;
+    uint32_t reserved;
+    uint64_t hash;
+};
+
+std::runtime_error io_error(const std::string &what, const std::string &path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+// File descriptor closed on scope exit
+class file {
+public:
+    file(const std::string &path, int flags) : _path(path), _fd(open(path.c_str(), flags | O_CLOEXEC, 0644)) {}
+    ~file() {
+        if (_fd >= 0) {
+            close(_fd);
+        }
+    }
+
+    bool is_open() const { return _fd >= 0; }
+    const std::string &path() const { return _path; }
+
+    void write_at(uint64_t offset, const void *data, std::size_t size) {
+        const char *p = static_cast<const char *>(data);
+        while (size > 0) {
+            ssize_t written = pwrite(_fd, p, size, offset);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw io_error("Failed to write", _path);
+            }
+            p += written;
+            offset += written;
+            size -= written;
+        }
+    }
+
+    void read_at(uint64_t offset, void *data, std::size_t size) const {
+        char *p = static_cast<char *>(data);
+        while (size > 0) {
+            ssize_t got = pread(_fd, p, size, offset);
+            if (got < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw io_error("Failed to read", _path);
+            }
+            if (got == 0) {
+                throw std::runtime_error("Snapshot " + _path + " is truncated");
+            }
+            p += got;
+            offset += got;
+            size -= got;
+        }
+    }
+
+    uint64_t size() const {
+        struct stat st;
+        if (fstat(_fd, &st) != 0) {
+            throw io_error("Failed to stat", _path);
+        }
+        return st.st_size;
+    }
+
+    void sync() {
+        if (fsync(_fd) != 0) {
+            throw io_error("Failed to sync", _path);
+        }
+    }
+
+private:
+    std::string _path;
+    int _fd;
+};
+
+// Writes section payload split into hashed blocks
+class block_writer {
+public:
+    block_writer(file &f, uint64_t offset) : _file(f), _offset(offset) { _buffer.reserve(kBlockSize); }
+
+    void put(const char *data, std::size_t size) {
+        while (size > 0) {
+            std::size_t part = std::min(size, kBlockSize - _buffer.size());
+            _buffer.append(data, part);
+            data += part;
+            size -= part;
+            if (_buffer.size() == kBlockSize) {
+                flush();
+            }
+        }
+    }
+
+    void put_varint(uint64_t value) {
+        char bytes[10];
+        std::size_t size = 0;
+        do {
+            bytes[size++] = char((value & 0x7f) | (value >= 0x80 ? 0x80 : 0));
+            value >>= 7;
+        } while (value != 0);
+        put(bytes, size);
+    }
+
+    // Writes the rest and the end mark, returns offset right after the section
+    uint64_t finish() {
+        if (!_buffer.empty()) {
+            flush();
+        }
+        flush();
+        return _offset;
+    }
+
+private:
+    // Empty buffer makes the empty block which ends the section
+    void flush() {
+        block_header header = {uint32_t(_buffer.size()), 0, WyHash(_buffer.data(), _buffer.size(), kHashSeed)};
+        _file.write_at(_offset, &header, sizeof(header));
+        _file.write_at(_offset + sizeof(header), _buffer.data(), _buffer.size());
+        _offset += sizeof(header) + _buffer.size();
+        _buffer.clear();
+    }
+
+    file &_file;
+    uint64_t _offset;
+    std::string _buffer;
+};
+
+// Reads section payload, each block is checked before use
+class block_reader {
+public:
+    block_reader(const file &f, uint64_t offset) : _file(f), _offset(offset), _pos(0), _end(false) {}
+
+    // True once all the section blocks have been read
+    bool at_end() {
+        if (_pos == _buffer.size() && !_end) {
+            next_block();
+        }
+        return _end;
+    }
+
+    void get(char *data, std::size_t size) {
+        while (size > 0) {
+            if (at_end()) {
+                throw std::runtime_error("Snapshot " + _file.path() + " has broken record");
+            }
+            std::size_t part = std::min(size, _buffer.size() - _pos);
+            std::memcpy(data, _buffer.data() + _pos, part);
+            _pos += part;
+            data += part;
+            size -= part;
+        }
+    }
+
+    uint64_t get_varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            char byte;
+            get(&byte, 1);
+            value |= uint64_t(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Snapshot " + _file.path() + " has broken number");
+    }
+
+private:
+    void next_block() {
+        block_header header;
+        _file.read_at(_offset, &header, sizeof(header));
+        if (header.size > kBlockSize) {
+            throw std::runtime_error("Snapshot " + _file.path() + " has broken block");
+        }
+        _buffer.resize(header.size);
+        _file.read_at(_offset + sizeof(header), &_buffer[0], header.size);
+        if (WyHash(_buffer.data(), _buffer.size(), kHashSeed) != header.hash) {
+            throw std::runtime_error("Snapshot " + _file.path() + " has block with wrong checksum");
+        }
+        _offset += sizeof(header) + header.size;
+        _pos = 0;
+        _end = header.size == 0;
+    }
+
+    const file &_file;
+    uint64_t _offset;
+    std::string _buffer;
+    std::size_t _pos;
+    bool _end;
+};
+
+// Puts records of one section into the storage, returns number of items stored
+std::size_t load_section(Afina::Storage &storage, const file &f, const section_entry &section) {
+    block_reader reader(f, section.offset);
+    std::string key, value;
+    std::size_t loaded = 0;
+    while (!reader.at_end()) {
+        uint64_t key_size = reader.get_varint();
+        uint64_t value_size = reader.get_varint();
+        uint64_t expire = reader.get_varint();
+        if (key_size > UINT32_MAX || value_size > UINT32_MAX) {
+            throw std::runtime_error("Snapshot " + f.path() + " has broken record");
+        }
+        key.resize(key_size);
+        value.resize(value_size);
+        reader.get(&key[0], key_size);
+        reader.get(&value[0], value_size);
+
+        uint32_t ttl = 0;
+        if (expire != 0) {
+            uint64_t now = std::time(nullptr);
+            if (expire <= now) {
+                continue;
+            }
+            ttl = std::min<uint64_t>(expire - now, UINT32_MAX);
+        }
+        loaded += storage.PutWithTTL(key, value, ttl);
+    }
+    return loaded;
+}
+
+} // namespace
+
+Snapshot::Snapshot(std::shared_ptr<Afina::Storage> storage, const std::string &path)
+    : _storage(std::move(storage)), _path(path), _running(false) {}
+
+Snapshot::~Snapshot() { Stop(); }
+
+// See Snapshot.h
+std::size_t Snapshot::Save() {
+    std::string tmp_path = _path + ".tmp";
+    std::size_t saved = 0;
+    try {
+        saved = write(tmp_path);
+        if (rename(tmp_path.c_str(), _path.c_str()) != 0) {
+            throw io_error("Failed to replace", _path);
+        }
+    } catch (...) {
+        // Partial file is never loaded, but it would take disk space until the next successful save
+        unlink(tmp_path.c_str());
+        throw;
+    }
+
+    // Rename is durable only once the directory entry is on disk as well
+    std::size_t slash = _path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : _path.substr(0, slash));
+    file d(dir, O_RDONLY | O_DIRECTORY);
+    if (!d.is_open()) {
+        throw io_error("Failed to open", dir);
+    }
+    d.sync();
+    return saved;
+}
+
+// See Snapshot.h
+std::size_t Snapshot::write(const std::string &tmp_path) {
+    file f(tmp_path, O_WRONLY | O_CREAT | O_TRUNC);
+    if (!f.is_open()) {
+        throw io_error("Failed to create", tmp_path);
+    }
+
+    // Each part is written as soon as it is taken, storage releases it right after that
+    std::vector<section_entry> sections;
+    uint64_t offset = sizeof(file_header);
+    std::size_t saved = 0;
+    bool dumped = _storage->Dump([&](std::vector<StoredItem> &part) {
+        uint64_t now = std::time(nullptr);
+        sections.push_back(section_entry{offset, part.size()});
+
+        block_writer writer(f, offset);
+        for (auto &item : part) {
+            writer.put_varint(item.key.size());
+            writer.put_varint(item.value.size());
+            writer.put_varint(item.ttl == 0 ? 0 : now + item.ttl);
+            writer.put(item.key.data(), item.key.size());
+            writer.put(item.value.data(), item.value.size());
+        }
+        offset = writer.finish();
+        saved += part.size();
+    });
+    if (!dumped) {
+        throw std::runtime_error("Storage doesn't support snapshots");
+    }
+
+    file_header header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.sections = sections.size();
+    header.reserved = 0;
+    header.table = offset;
+    f.write_at(offset, sections.data(), sections.size() * sizeof(section_entry));
+    f.write_at(0, &header, sizeof(header));
+    f.sync();
+    return saved;
+}
+
+// See Snapshot.h
+std::size_t Snapshot::Load(std::size_t threads) {
+    file f(_path, O_RDONLY);
+    if (!f.is_open()) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        throw io_error("Failed to open", _path);
+    }
+
+    file_header header;
+    f.read_at(0, &header, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("File " + _path + " is not a snapshot");
+    }
+    uint64_t file_size = f.size();
+    if (header.table < sizeof(header) || header.table > file_size ||
+        header.sections > (file_size - header.table) / sizeof(section_entry)) {
+        throw std::runtime_error("Snapshot " + _path + " is truncated");
+    }
+    std::vector<section_entry> sections(header.sections);
+    f.read_at(header.table, sections.data(), sections.size() * sizeof(section_entry));
+    for (auto &section : sections) {
+        if (section.offset >= header.table) {
+            throw std::runtime_error("Snapshot " + _path + " is truncated");
+        }
+    }
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max<std::size_t>(1, std::min(threads, sections.size()));
+
+    // Each thread takes next section until none is left, order of items is kept inside the section
+    std::atomic<std::size_t> next(0), loaded(0);
+    std::vector<std::exception_ptr> errors(threads);
+    auto worker = [&](std::size_t id) {
+        try {
+            for (std::size_t i = next++; i < sections.size(); i = next++) {
+                loaded += load_section(*_storage, f, sections[i]);
+            }
+        } catch (...) {
+            errors[id] = std::current_exception();
+            next = sections.size();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < threads; i++) {
+        workers.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto &t : workers) {
+        t.join();
+    }
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return loaded;
+}
+
+// See Snapshot.h
+void Snapshot::Start(uint32_t period, Report report) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_running) {
+        return;
+    }
+    _running = true;
+    _thread = std::thread(&Snapshot::background, this, period, std::move(report));
+}
+
+// See Snapshot.h
+void Snapshot::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _stop_cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+// save storage every period seconds until stopped
+void Snapshot::background(uint32_t period, Report report) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stop_cv.wait_for(lock, std::chrono::seconds(period), [this] { return !_running; })) {
+        lock.unlock();
+        try {
+            std::size_t saved = Save();
+            report(saved, std::string());
+        } catch (std::exception &ex) {
+            report(0, ex.what());
+        }
+        lock.lock();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
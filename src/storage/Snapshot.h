@@ -0,0 +1,93 @@
+#ifndef AFINA_STORAGE_SNAPSHOT_H
+#define AFINA_STORAGE_SNAPSHOT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Point-in-time copy of the storage in a file
+ * Save takes the copy with Storage::Dump part by part: each part is written out with no storage lock held
+ * and released before the next one is taken, so the storage goes on serving requests meanwhile and at
+ * most one part is kept in memory on top of the storage itself. Items are pinned, not copied, but the ones
+ * overwritten while pinned hold their old memory until the part is written. File is written next to the
+ * target and renamed over it once complete, readers never see a partial snapshot. Failed save removes the
+ * temporary file, successful one syncs the directory too, so the rename survives a crash.
+ *
+ * File keeps keys, values, expiration times and the order of items: each part of the dump is a separate
+ * section, its items go from the least to the most recently used. Load puts them back in the same order,
+ * so the recently used items are the ones that survive if the new storage is smaller. Sections are
+ * independent and are loaded by several threads at once when storage is thread safe.
+ *
+ * Expiration time is saved as unix time, so the time server was down counts against item ttl.
+ *
+ * File layout, numbers are in the native byte order:
+ * - header: magic, number of sections, offset of the section table
+ * - sections: sequence of blocks ended by an empty one, block has size and wyhash of its payload, so
+ *   corruption is found before the data is used. Payload of all the section blocks together is a sequence
+ *   of records: varint key size, varint value size, varint expiration time, zero means never, key and
+ *   value bytes.
+ * - section table: offset and number of items of each section, it is written last as the number of
+ *   sections is known only once the dump is over
+ */
+class Snapshot {
+public:
+    // Called from the background thread after each save: number of items saved or error message
+    using Report = std::function<void(std::size_t items, const std::string &error)>;
+
+    Snapshot(std::shared_ptr<Afina::Storage> storage, const std::string &path);
+
+    ~Snapshot();
+
+    /**
+     * Restores storage from the file with up to the given number of threads, zero means one per hardware
+     * thread. Storage must be thread safe to use more than one. Missing file is an empty snapshot
+     *
+     * Returns number of restored items, throws std::runtime_error if file is broken
+     */
+    std::size_t Load(std::size_t threads = 1);
+
+    /**
+     * Writes storage contents to the file. Returns number of saved items, throws std::runtime_error on
+     * failure, file is kept intact then
+     */
+    std::size_t Save();
+
+    /**
+     * Starts background thread that saves storage every period seconds, storage must be thread safe
+     */
+    void Start(uint32_t period, Report report);
+
+    /**
+     * Stops background thread, running save is completed first
+     */
+    void Stop();
+
+private:
+    void background(uint32_t period, Report report);
+
+    // Writes and syncs the whole snapshot to the given file, returns number of saved items
+    std::size_t write(const std::string &tmp_path);
+
+    std::shared_ptr<Afina::Storage> _storage;
+    std::string _path;
+
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _stop_cv;
+    bool _running;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SNAPSHOT_H
@@ -1,33 +1,301 @@
+#include "StripedLRU.h"
 
+#include <algorithm>
+#include <new>
+#include <random>
+#include <thread>
 
-#include "StripedLRU.h"
+#include "Hash.h"
 
 namespace Afina {
 namespace Backend {
 
+const size_t StripedLRU::kMinShardSize;
+const size_t StripedLRU::kRebalancePeriod;
+const size_t StripedLRU::kRebalanceChunks;
+constexpr double StripedLRU::kRebalanceStep;
+constexpr double StripedLRU::kMinShare;
+
+StripedLRU::StripedLRU(size_t shards_number, size_t max_storage_size, double protected_fraction)
+    : _max_storage_size(max_storage_size), _moving(0), _donor(0), _receiver(0) {
+    if (shards_number == 0) {
+        shards_number = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    _shards_number = 1;
+    while (_shards_number < shards_number) {
+        _shards_number *= 2;
+    }
+    while (_shards_number > 1 && _max_storage_size / _shards_number < kMinShardSize) {
+        _shards_number /= 2;
+    }
+
+    _shard_size = _max_storage_size / _shards_number;
+    _memory.reset(new char[_shards_number * sizeof(shard) + alignof(shard)]);
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(_memory.get()) + alignof(shard) - 1) & ~(alignof(shard) - 1);
+    _shards = reinterpret_cast<shard *>(aligned);
+    for (size_t i = 0; i < _shards_number; i++) {
+        new (&_shards[i]) shard(_shard_size, protected_fraction);
+    }
+    _last_evictions.assign(_shards_number, 0);
+    _last_hits.assign(_shards_number, 0);
+
+    // Random seed: nobody could pick keys that all go to the same shard
+    std::random_device random;
+    _seed = (uint64_t(random()) << 32) | random();
+}
+
+StripedLRU::~StripedLRU() {
+    for (size_t i = 0; i < _shards_number; i++) {
+        _shards[i].~shard();
+    }
+}
+
+// See StripedLRU.h
+size_t StripedLRU::ShardOf(const std::string &key) const { return WyHash(key, _seed) & (_shards_number - 1); }
+
+// See StripedLRU.h
+void StripedLRU::SetEvictionListener(const SimpleLRU::EvictionListener &listener) {
+    for (size_t i = 0; i < _shards_number; i++) {
+        _shards[i].storage.SetEvictionListener(listener);
+    }
+}
+
+// See StripedLRU.h
+void StripedLRU::SetCounters(std::shared_ptr<StorageCounters> counters) {
+    for (size_t i = 0; i < _shards_number; i++) {
+        _shards[i].storage.SetCounters(counters);
+    }
+}
+
+// See StripedLRU.h
+void StripedLRU::account(shard &s, size_t requests, size_t hits) {
+    if (hits > 0) {
+        s.hits.fetch_add(hits, std::memory_order_relaxed);
+    }
+    size_t before = s.requests.fetch_add(requests, std::memory_order_relaxed);
+    if (before / kRebalancePeriod != (before + requests) / kRebalancePeriod) {
+        rebalance();
+    } else if (_moving.load(std::memory_order_relaxed) > 0) {
+        move_chunk();
+    }
+}
+
+// See StripedLRU.h
+void StripedLRU::rebalance() {
+    std::unique_lock<std::mutex> lock(_rebalance_lock, std::try_to_lock);
+    if (!lock.owns_lock() || _shards_number == 1 || _moving.load(std::memory_order_relaxed) > 0) {
+        return;
+    }
+
+    const size_t step = _shard_size * kRebalanceStep;
+    const size_t min_capacity = _shard_size * kMinShare;
+
+    // Pressure since the previous check: evictions show the shard needs more memory, hits show the
+    // memory it has is useful
+    std::vector<size_t> evictions(_shards_number), hits(_shards_number);
+    for (size_t i = 0; i < _shards_number; i++) {
+        size_t e = _shards[i].storage.Evictions();
+        size_t h = _shards[i].hits.load(std::memory_order_relaxed);
+        evictions[i] = e - _last_evictions[i];
+        hits[i] = h - _last_hits[i];
+        _last_evictions[i] = e;
+        _last_hits[i] = h;
+    }
+
+    size_t receiver = 0;
+    for (size_t i = 1; i < _shards_number; i++) {
+        if (evictions[i] > evictions[receiver]) {
+            receiver = i;
+        }
+    }
+
+    size_t donor = _shards_number;
+    for (size_t i = 0; i < _shards_number; i++) {
+        if (i == receiver || ShardCapacity(i) < min_capacity + step) {
+            continue;
+        }
+        if (donor == _shards_number || evictions[i] < evictions[donor] ||
+            (evictions[i] == evictions[donor] && hits[i] < hits[donor])) {
+            donor = i;
+        }
+    }
+
+    // Move memory only if pressure is clearly uneven
+    if (donor == _shards_number || evictions[receiver] == 0 || evictions[receiver] < 2 * evictions[donor] + 16) {
+        return;
+    }
+
+    _donor = donor;
+    _receiver = receiver;
+    _moving.store(step, std::memory_order_relaxed);
+}
+
+// See StripedLRU.h
+void StripedLRU::move_chunk() {
+    std::unique_lock<std::mutex> lock(_rebalance_lock, std::try_to_lock);
+    size_t left = _moving.load(std::memory_order_relaxed);
+    if (!lock.owns_lock() || left == 0) {
+        return;
+    }
+    size_t chunk = std::min(left, std::max<size_t>(1, size_t(_shard_size * kRebalanceStep) / kRebalanceChunks));
+
+    // Donor shrinks first, so the total never goes over the budget
+    size_t donor_capacity = ShardCapacity(_donor) - chunk;
+    _shards[_donor].storage.SetMaxSize(donor_capacity);
+    _shards[_donor].capacity.store(donor_capacity, std::memory_order_relaxed);
+
+    size_t receiver_capacity = ShardCapacity(_receiver) + chunk;
+    _shards[_receiver].storage.SetMaxSize(receiver_capacity);
+    _shards[_receiver].capacity.store(receiver_capacity, std::memory_order_relaxed);
+
+    _moving.store(left - chunk, std::memory_order_relaxed);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLRU::Put(const std::string &key, const std::string &value) { return StripedLRU::PutWithTTL(key, value, 0); }
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLRU::PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    shard &s = shard_of(key);
+    bool result = s.storage.PutWithTTL(key, value, ttl);
+    account(s, 1, 0);
+    return result;
+}
+
 // See MapBasedGlobalLockImpl.h
-bool StripedLRU::Put(const std::string &key, const std::string &value) { 
-    return _shards[_hash_func(key) % _shards_number]->Put(key, value);
+bool StripedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return StripedLRU::PutIfAbsentWithTTL(key, value, 0);
 }
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLRU::PutIfAbsent(const std::string &key, const std::string &value) { 
-    return _shards[_hash_func(key) % _shards_number]->PutIfAbsent(key, value);
+bool StripedLRU::PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    shard &s = shard_of(key);
+    bool result = s.storage.PutIfAbsentWithTTL(key, value, ttl);
+    account(s, 1, 0);
+    return result;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLRU::Set(const std::string &key, const std::string &value) {
-    return _shards[_hash_func(key) % _shards_number]->Set(key, value);
+bool StripedLRU::Set(const std::string &key, const std::string &value) { return StripedLRU::SetWithTTL(key, value, 0); }
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLRU::SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    shard &s = shard_of(key);
+    bool result = s.storage.SetWithTTL(key, value, ttl);
+    account(s, 1, 0);
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLRU::Delete(const std::string &key) { return shard_of(key).storage.Delete(key); }
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLRU::Get(const std::string &key, std::string &value) {
+    shard &s = shard_of(key);
+    bool result = s.storage.Get(key, value);
+    account(s, 1, result);
+    return result;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLRU::Delete(const std::string &key) { 
-    return _shards[_hash_func(key) % _shards_number]->Delete(key);
+bool StripedLRU::GetWithVersion(const std::string &key, std::string &value, uint64_t &version) {
+    shard &s = shard_of(key);
+    bool result = s.storage.GetWithVersion(key, value, version);
+    account(s, 1, result);
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLRU::GetView(const std::string &key, ValueView &value) {
+    shard &s = shard_of(key);
+    bool result = s.storage.GetView(key, value);
+    account(s, 1, result);
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLRU::Append(const std::string &key, const std::string &data) {
+    shard &s = shard_of(key);
+    bool result = s.storage.Append(key, data);
+    account(s, 1, 0);
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLRU::Prepend(const std::string &key, const std::string &data) {
+    shard &s = shard_of(key);
+    bool result = s.storage.Prepend(key, data);
+    account(s, 1, 0);
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLRU::Dump(const std::function<void(std::vector<StoredItem> &part)> &write) {
+    for (size_t i = 0; i < _shards_number; i++) {
+        _shards[i].storage.Dump(write);
+    }
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLRU::Increment(const std::string &key, uint64_t delta, uint64_t &number) {
+    shard &s = shard_of(key);
+    bool result = s.storage.Increment(key, delta, number);
+    account(s, 1, 0);
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool StripedLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &number) {
+    shard &s = shard_of(key);
+    bool result = s.storage.Decrement(key, delta, number);
+    account(s, 1, 0);
+    return result;
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t StripedLRU::MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) {
+    values.assign(keys.size(), ValueView());
+
+    // Shard of each key, shard lock is prefetched while the next keys are hashed. Keys are ordered by
+    // shard with counting sort: start[i] is the first position of shard i keys in order
+    std::vector<size_t> key_shard(keys.size());
+    std::vector<size_t> start(_shards_number + 1, 0);
+    for (size_t i = 0; i < keys.size(); i++) {
+        key_shard[i] = ShardOf(keys[i]);
+        __builtin_prefetch(&_shards[key_shard[i]], 1);
+        start[key_shard[i] + 1]++;
+    }
+    for (size_t i = 0; i < _shards_number; i++) {
+        start[i + 1] += start[i];
+    }
+
+    std::vector<size_t> order(keys.size());
+    std::vector<size_t> next(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < keys.size(); i++) {
+        order[next[key_shard[i]]++] = i;
+    }
+
+    size_t found = 0;
+    for (size_t i = 0; i < _shards_number; i++) {
+        size_t count = start[i + 1] - start[i];
+        if (count == 0) {
+            continue;
+        }
+        size_t hits = _shards[i].storage.GetViews(keys, &order[start[i]], count, values);
+        account(_shards[i], count, hits);
+        found += hits;
+    }
+    return found;
 }
 
 // See MapBasedGlobalLockImpl.h
-bool StripedLRU::Get(const std::string &key, std::string &value) { 
-    return _shards[_hash_func(key) % _shards_number]->Get(key, value);
+bool StripedLRU::CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl, uint64_t &version) {
+    shard &s = shard_of(key);
+    bool result = s.storage.CompareAndSet(key, value, ttl, version);
+    account(s, 1, 0);
+    return result;
 }
 
 } // namespace Backend
@@ -1,11 +1,11 @@
 #ifndef AFINA_STORAGE_STRIPED_LRU_H
 #define AFINA_STORAGE_STRIPED_LRU_H
 
-#include <map>
-#include <functional>
-#include <string>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
 #include "ThreadSafeSimpleLRU.h"
@@ -17,27 +17,39 @@ namespace Backend {
 /**
  * # Based on ThreadSafeSimplLRU
  * Consists of some copies of ThreadSafeSimplLRU
- * every part works independently  
+ * every part works independently
+ *
+ * Number of shards is rounded up to the power of two, shard is chosen by low bits of the seeded wyhash
+ * of the key. Zero shards_number means one shard per hardware thread. Shards are never smaller than
+ * kMinShardSize, small storage gets fewer shards instead.
+ *
+ * Each shard takes whole number of cache lines, so threads working with different shards never write
+ * the same cache line.
+ *
+ * max_storage_size is a budget of the whole storage, shards start with equal parts of it and then
+ * trade memory: every kRebalancePeriod requests to some shard, the shard that evicted most since the
+ * previous check borrows kRebalanceStep of its share from the shard under the least pressure, the one
+ * with fewest evictions and hits. Shard never goes below kMinShare of its initial size. The step is moved in
+ * kRebalanceChunks parts by the following requests, one part per request, so none of them evicts more than a
+ * small part of the donor under its lock.
+ *
+ * Item versions are counted by each shard on its own: key always lives in the same shard, so its versions
+ * never repeat, and compare-and-set is atomic under the shard lock.
+ *
+ * MultiGet groups keys by shard and takes each shard lock once per batch.
+ *
+ * Dump copies shards one by one, each of them is a separate part: shard is locked only for its own copy,
+ * the rest keep serving requests. Copy of each shard is written out and released before the next shard is
+ * taken. Copy of each shard is consistent, but shards are taken at different moments.
  */
 class StripedLRU : public Afina::Storage {
 public:
-    explicit StripedLRU(size_t shards_number = 4,
-                        size_t max_storage_size = 1024*1024*8): _shards_number(shards_number),
-                                                        _max_storage_size(max_storage_size)
-    {
-        size_t shard_size = _max_storage_size/_shards_number;
-        
-        if(_max_storage_size/(_shards_number) < 1024*1024){
-            throw std::runtime_error("Storage size too small");
-        }
+    static const size_t kMinShardSize = 64 * 1024;
 
-        for (size_t i=0; i<_shards_number; i++){
-            _shards.emplace_back(new ThreadSafeSimplLRU(shard_size));
-        }
+    explicit StripedLRU(size_t shards_number = 0, size_t max_storage_size = 1024 * 1024 * 8,
+                        double protected_fraction = 0);
 
-    }
-    
-    ~StripedLRU() {};
+    ~StripedLRU();
 
     // Implements Afina::Storage interface
     bool Put(const std::string &key, const std::string &value) override;
@@ -54,15 +66,105 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface
+    bool PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool GetWithVersion(const std::string &key, std::string &value, uint64_t &version) override;
+
+    // Implements Afina::Storage interface
+    bool GetView(const std::string &key, ValueView &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::vector<StoredItem> &part)> &write) override;
+
+    // Implements Afina::Storage interface
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+    // Implements Afina::Storage interface
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) override;
+
+    // Implements Afina::Storage interface
+    bool CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl, uint64_t &version) override;
+
+    // Implements Afina::Storage interface, all the shards report to the same counters
+    void SetCounters(std::shared_ptr<StorageCounters> counters) override;
 
+    size_t ShardsNumber() const { return _shards_number; }
+
+    // Number of shard the key belongs to
+    size_t ShardOf(const std::string &key) const;
+
+    // Sets the listener of all the shards, see SimpleLRU::EvictionListener. It is called under the shard lock
+    void SetEvictionListener(const SimpleLRU::EvictionListener &listener);
+
+    // Current memory limit of the shard
+    size_t ShardCapacity(size_t shard) const { return _shards[shard].capacity.load(std::memory_order_relaxed); }
 
 private:
+    static const size_t kRebalancePeriod = 4096;
+    // Parts of the initial shard size
+    static constexpr double kRebalanceStep = 1.0 / 16;
+    static constexpr double kMinShare = 1.0 / 4;
+    static const size_t kRebalanceChunks = 16;
+
+    // Shard is aligned and padded to the cache line
+    struct alignas(64) shard {
+        shard(size_t max_size, double protected_fraction)
+            : storage(max_size, protected_fraction), requests(0), hits(0), capacity(max_size) {}
+
+        ThreadSafeSimplLRU storage;
+
+        // Statistics for rebalancing, updated without shard lock
+        std::atomic<size_t> requests;
+        std::atomic<size_t> hits;
+        std::atomic<size_t> capacity;
+    };
+
+    shard &shard_of(const std::string &key) { return _shards[ShardOf(key)]; }
+
+    // Counts requests and moves memory between shards once in a while
+    void account(shard &s, size_t requests, size_t hits);
+    // Picks shards to move memory between
+    void rebalance();
+    // Moves next part of the memory picked by rebalance
+    void move_chunk();
+
     size_t _shards_number;
-    //size_t _max_shard_size;
     size_t _max_storage_size;
-    
-    std::hash<std::string> _hash_func;
-    std::vector< std::unique_ptr<ThreadSafeSimplLRU>> _shards;
+    size_t _shard_size;
+
+    // Shards live in one block, aligned to the cache line by hand as operator new doesn't do that
+    std::unique_ptr<char[]> _memory;
+    shard *_shards;
+
+    uint64_t _seed;
+
+    // Only one thread moves memory at a time, others just skip the check
+    std::mutex _rebalance_lock;
+    // Shard counters at the previous check
+    std::vector<size_t> _last_evictions;
+    std::vector<size_t> _last_hits;
+
+    // Memory being moved and between which shards, changed under the rebalance lock
+    std::atomic<size_t> _moving;
+    size_t _donor;
+    size_t _receiver;
 };
 
 } // namespace Backend
@@ -17,7 +17,8 @@ namespace Backend {
  */
 class ThreadSafeSimplLRU : public SimpleLRU {
 public:
-    ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
+    ThreadSafeSimplLRU(size_t max_size = 1024, double protected_fraction = 0)
+        : SimpleLRU(max_size, protected_fraction) {}
     ~ThreadSafeSimplLRU() {}
 
     // see SimpleLRU.h
@@ -55,6 +56,115 @@ public:
         return SimpleLRU::Get(key, value);
     }
 
+    // see SimpleLRU.h
+    bool PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::PutWithTTL(key, value, ttl);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::PutIfAbsentWithTTL(key, value, ttl);
+    }
+
+    // see SimpleLRU.h
+    bool SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::SetWithTTL(key, value, ttl);
+    }
+
+    // see SimpleLRU.h
+    bool GetWithVersion(const std::string &key, std::string &value, uint64_t &version) override {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::GetWithVersion(key, value, version);
+    }
+
+    // see SimpleLRU.h
+    bool GetView(const std::string &key, ValueView &value) override {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::GetView(key, value);
+    }
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, const std::string &data) override {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::Append(key, data);
+    }
+
+    // see SimpleLRU.h
+    bool Prepend(const std::string &key, const std::string &data) override {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::Prepend(key, data);
+    }
+
+    // see SimpleLRU.h
+    bool Dump(const std::function<void(std::vector<StoredItem> &part)> &write) override {
+        // Items are pinned under the lock, but written out without it
+        std::vector<StoredItem> items;
+        {
+            std::unique_lock<std::mutex> lock(storage_mtx);
+            SimpleLRU::Copy(items);
+        }
+        write(items);
+        return true;
+    }
+
+    // see SimpleLRU.h
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &number) override {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::Increment(key, delta, number);
+    }
+
+    // see SimpleLRU.h
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &number) override {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::Decrement(key, delta, number);
+    }
+
+    // see SimpleLRU.h
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) override {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::MultiGet(keys, values);
+    }
+
+    // see SimpleLRU.h
+    std::size_t GetViews(const std::vector<std::string> &keys, const std::size_t *index, std::size_t count,
+                         std::vector<ValueView> &values) {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::GetViews(keys, index, count, values);
+    }
+
+    // see SimpleLRU.h
+    bool CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl, uint64_t &version) override {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::CompareAndSet(key, value, ttl, version);
+    }
+
+    // see SimpleLRU.h
+    void SetMaxSize(size_t max_size) {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        SimpleLRU::SetMaxSize(max_size);
+    }
+
+    // see SimpleLRU.h
+    void SetEvictionListener(EvictionListener listener) {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        SimpleLRU::SetEvictionListener(std::move(listener));
+    }
+
+    // see SimpleLRU.h
+    size_t Evictions() {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::Evictions();
+    }
+
+    // see SimpleLRU.h
+    size_t Expirations() {
+        std::unique_lock<std::mutex> lock(storage_mtx);
+        return SimpleLRU::Expirations();
+    }
+
 private:
     std::mutex storage_mtx;
     // TODO: sinchronization primitives
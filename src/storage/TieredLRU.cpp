@@ -0,0 +1,199 @@
+#include "TieredLRU.h"
+
+#include <atomic>
+#include <memory>
+
+namespace Afina {
+namespace Backend {
+
+TieredLRU::TieredLRU(const std::string &dir, size_t shards_number, size_t memory_size, size_t file_size,
+                     bool async_reads, size_t segment_size, size_t batch_size)
+    : _memory(shards_number, memory_size), _file(dir, file_size, segment_size, batch_size),
+      _async_reads(async_reads) {
+    _memory.SetEvictionListener(
+        [this](const char *key, std::size_t key_size, const char *value, std::size_t value_size, uint32_t ttl) {
+            _file.Put(key, key_size, value, value_size, ttl);
+        });
+}
+
+TieredLRU::~TieredLRU() {
+    // Reader thread puts items to memory, it must be gone before memory is
+    _file.Stop();
+}
+
+// See TieredLRU.h
+void TieredLRU::Start() { _file.Start(); }
+
+// See TieredLRU.h
+void TieredLRU::Stop() { _file.Stop(); }
+
+// See TieredLRU.h
+void TieredLRU::SetCounters(std::shared_ptr<StorageCounters> counters) { _memory.SetCounters(std::move(counters)); }
+
+// See TieredLRU.h
+bool TieredLRU::promote(const std::string &key, std::string *value) {
+    std::string taken;
+    uint32_t ttl;
+    if (!_file.Take(key, taken, ttl)) {
+        return false;
+    }
+
+    // Write that came meanwhile is newer than the file record
+    _memory.PutIfAbsentWithTTL(key, taken, ttl);
+    if (value != nullptr) {
+        *value = std::move(taken);
+    }
+    return true;
+}
+
+// See TieredLRU.h
+bool TieredLRU::get_file(const std::string &key, ValueView &value) {
+    std::string taken;
+    if (!promote(key, &taken)) {
+        return false;
+    }
+    value = ValueView(std::move(taken));
+    return true;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Prepare(const std::vector<std::string> &keys, std::function<void()> ready) {
+    if (!_async_reads) {
+        return false;
+    }
+
+    // Reads not done yet, plus one till all of them are queued
+    auto left = std::make_shared<std::atomic<std::size_t>>(1);
+    LogStore::Taken done = [this, left, ready](const std::string &key, bool found, const std::string &value,
+                                               uint32_t ttl) {
+        // Write that came meanwhile is newer than the file record
+        if (found) {
+            _memory.PutIfAbsentWithTTL(key, value, ttl);
+        }
+        if (left->fetch_sub(1) == 1) {
+            ready();
+        }
+    };
+    for (auto &key : keys) {
+        left->fetch_add(1);
+        if (!_file.TakeAsync(key, done)) {
+            left->fetch_sub(1);
+        }
+    }
+    return left->fetch_sub(1) != 1;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::Put(const std::string &key, const std::string &value) { return TieredLRU::PutWithTTL(key, value, 0); }
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    return TieredLRU::PutIfAbsentWithTTL(key, value, 0);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::Set(const std::string &key, const std::string &value) { return TieredLRU::SetWithTTL(key, value, 0); }
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    _file.Remove(key);
+    return _memory.PutWithTTL(key, value, ttl);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    if (_file.Contains(key)) {
+        return false;
+    }
+    return _memory.PutIfAbsentWithTTL(key, value, ttl);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) {
+    if (_file.Remove(key)) {
+        return _memory.PutWithTTL(key, value, ttl);
+    }
+    return _memory.SetWithTTL(key, value, ttl);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::Delete(const std::string &key) {
+    // Item could be evicted to the file right before memory drops it
+    bool in_memory = _memory.Delete(key);
+    bool in_file = _file.Remove(key);
+    return in_memory || in_file;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::Get(const std::string &key, std::string &value) {
+    if (_memory.Get(key, value)) {
+        return true;
+    }
+    ValueView view;
+    if (!get_file(key, view)) {
+        return false;
+    }
+    value.assign(view.data(), view.size());
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::GetView(const std::string &key, ValueView &value) {
+    return _memory.GetView(key, value) || get_file(key, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t TieredLRU::MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) {
+    size_t found = _memory.MultiGet(keys, values);
+    for (size_t i = 0; i < keys.size() && found < keys.size(); i++) {
+        if (!values[i].valid()) {
+            found += get_file(keys[i], values[i]);
+        }
+    }
+    return found;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::GetWithVersion(const std::string &key, std::string &value, uint64_t &version) {
+    return _memory.GetWithVersion(key, value, version) ||
+           (promote(key, nullptr) && _memory.GetWithVersion(key, value, version));
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl, uint64_t &version) {
+    // Version of the file tier item is gone, so it never matches
+    promote(key, nullptr);
+    return _memory.CompareAndSet(key, value, ttl, version);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::Append(const std::string &key, const std::string &data) {
+    promote(key, nullptr);
+    return _memory.Append(key, data);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::Prepend(const std::string &key, const std::string &data) {
+    promote(key, nullptr);
+    return _memory.Prepend(key, data);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::Increment(const std::string &key, uint64_t delta, uint64_t &number) {
+    promote(key, nullptr);
+    return _memory.Increment(key, delta, number);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &number) {
+    promote(key, nullptr);
+    return _memory.Decrement(key, delta, number);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TieredLRU::Dump(const std::function<void(std::vector<StoredItem> &part)> &write) {
+    return _memory.Dump(write);
+}
+
+} // namespace Backend
+} // namespace Afina
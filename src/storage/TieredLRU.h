@@ -0,0 +1,123 @@
+#ifndef AFINA_STORAGE_TIERED_LRU_H
+#define AFINA_STORAGE_TIERED_LRU_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "LogStore.h"
+#include "StripedLRU.h"
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # StripedLRU over the file log
+ * Memory tier is StripedLRU, items it evicts go to LogStore instead of being lost, so the storage keeps
+ * far more items than fit into memory and only keys of the file tier take memory.
+ *
+ * Item found in the file tier is taken out of it and put back to memory, as the recently used one. Get
+ * waits for the disk read. With async_reads Prepare moves items to memory on the reader thread instead,
+ * so event loop networks, which must never block on the disk, park the command till it is done and
+ * then find the items in memory.
+ *
+ * Writes drop the file tier record of the key before going to memory, so the file tier never has a value
+ * newer than the memory one. Commands which change the current value (append, incr, cas, ...) move the
+ * item to memory first, always waiting for the disk.
+ *
+ * Dump copies the memory tier only.
+ */
+class TieredLRU : public Afina::Storage {
+public:
+    TieredLRU(const std::string &dir, size_t shards_number = 0, size_t memory_size = 1024 * 1024 * 8,
+              size_t file_size = 1024 * 1024 * 1024, bool async_reads = false, size_t segment_size = 64 * 1024 * 1024,
+              size_t batch_size = 1024 * 1024);
+
+    ~TieredLRU();
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface, items and evictions are the ones of the memory tier
+    void SetCounters(std::shared_ptr<StorageCounters> counters) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsentWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool SetWithTTL(const std::string &key, const std::string &value, uint32_t ttl) override;
+
+    // Implements Afina::Storage interface
+    bool Prepare(const std::vector<std::string> &keys, std::function<void()> ready) override;
+
+    // Implements Afina::Storage interface
+    bool GetWithVersion(const std::string &key, std::string &value, uint64_t &version) override;
+
+    // Implements Afina::Storage interface
+    bool GetView(const std::string &key, ValueView &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Dump(const std::function<void(std::vector<StoredItem> &part)> &write) override;
+
+    // Implements Afina::Storage interface
+    bool Increment(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+    // Implements Afina::Storage interface
+    bool Decrement(const std::string &key, uint64_t delta, uint64_t &number) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiGet(const std::vector<std::string> &keys, std::vector<ValueView> &values) override;
+
+    // Implements Afina::Storage interface
+    bool CompareAndSet(const std::string &key, const std::string &value, uint32_t ttl, uint64_t &version) override;
+
+    StripedLRU &Memory() { return _memory; }
+    LogStore &File() { return _file; }
+
+private:
+    /**
+     * Moves item of the file tier to memory, waiting for the disk. If value isn't null it gets the item
+     * value, even if it doesn't fit into memory. Returns false if file tier has no such item
+     */
+    bool promote(const std::string &key, std::string *value);
+
+    // Item missed in memory: moves it from the file tier, view gets the value
+    bool get_file(const std::string &key, ValueView &value);
+
+    StripedLRU _memory;
+    LogStore _file;
+    bool _async_reads;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TIERED_LRU_H
@@ -0,0 +1,176 @@
+#ifndef AFINA_STORAGE_TIMER_WHEEL_H
+#define AFINA_STORAGE_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hierarchical timer wheel
+ * Keeps intrusive timers ordered by expiration second without sorting. Level L has kSlots slots each
+ * covering kSlots^L seconds, so a timer due in less than kSlots seconds sits in the exact slot of level 0,
+ * timers further away sit in the coarse slots of upper levels. When the wheel passes a multiple of
+ * kSlots^L seconds, the next slot of level L is cascaded: its timers are spread over lower levels.
+ * Timers beyond the last level wait in its furthest slot and are rescheduled on cascade.
+ *
+ * Schedule and Cancel are O(1), Advance touches only the slots wheel goes through and the timers that
+ * are due or cascaded, with no scan over all the items.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class TimerWheel {
+public:
+    static const int kLevels = 4;
+    static const int kBits = 6;
+    static const uint32_t kSlots = 1 << kBits;
+
+    // Timer is embedded into the owner object, zero expire means the timer isn't scheduled
+    struct entry {
+        entry() : timer_prev(nullptr), timer_next(nullptr), expire(0) {}
+
+        entry *timer_prev;
+        entry *timer_next;
+        uint32_t expire;
+    };
+
+    explicit TimerWheel(uint32_t now) : _time(now), _size(0) {
+        for (int level = 0; level < kLevels; level++) {
+            for (uint32_t slot = 0; slot < kSlots; slot++) {
+                _slots[level][slot].timer_prev = &_slots[level][slot];
+                _slots[level][slot].timer_next = &_slots[level][slot];
+            }
+        }
+    }
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    // Number of scheduled timers
+    std::size_t Size() const { return _size; }
+
+    // Second which is processed next
+    uint32_t Time() const { return _time; }
+
+    // Schedules the timer, which must not be scheduled already, to fire at the given second, non zero
+    void Schedule(entry &timer, uint32_t expire) {
+        timer.expire = expire;
+        link(timer);
+        _size++;
+    }
+
+    // Removes timer from the wheel, does nothing if timer isn't scheduled
+    void Cancel(entry &timer) {
+        if (timer.expire == 0) {
+            return;
+        }
+        unlink(timer);
+        timer.expire = 0;
+        _size--;
+    }
+
+    /**
+     * Moves the wheel up to the given second and calls fire(entry &) for the timers that are due, but no
+     * more than limit times: the rest are fired by the next calls. Timer is removed from the wheel before
+     * the callback, so callback is free to destroy it.
+     *
+     * Returns number of fired timers
+     */
+    template <typename F> std::size_t Advance(uint32_t now, std::size_t limit, F fire) {
+        std::size_t fired = 0;
+        if (_size == 0) {
+            // Nothing to cascade, wheel may jump over the idle time
+            if (int32_t(now - _time) > 0) {
+                _time = now;
+            }
+            return fired;
+        }
+
+        while (int32_t(now - _time) >= 0) {
+            entry &slot = _slots[0][_time & (kSlots - 1)];
+            while (slot.timer_next != &slot) {
+                if (fired == limit) {
+                    return fired;
+                }
+                entry &timer = *slot.timer_next;
+                unlink(timer);
+                timer.expire = 0;
+                _size--;
+                fired++;
+                fire(timer);
+            }
+
+            if (_time == now) {
+                break;
+            }
+            _time++;
+            cascade();
+        }
+        return fired;
+    }
+
+private:
+    // Spreads the upper level slots reached by the current second over lower levels
+    void cascade() {
+        for (int level = 1; level < kLevels; level++) {
+            if ((_time & ((uint32_t(1) << (kBits * level)) - 1)) != 0) {
+                break;
+            }
+
+            // Detach the whole list first, timers may get back to the same slot
+            entry &slot = _slots[level][(_time >> (kBits * level)) & (kSlots - 1)];
+            if (slot.timer_next == &slot) {
+                continue;
+            }
+            entry *timer = slot.timer_next;
+            slot.timer_prev->timer_next = nullptr;
+            slot.timer_prev = slot.timer_next = &slot;
+            while (timer != nullptr) {
+                entry *next = timer->timer_next;
+                link(*timer);
+                timer = next;
+            }
+        }
+    }
+
+    // Puts timer into the slot its expire falls to relatively to the current second
+    void link(entry &timer) {
+        uint32_t delta = int32_t(timer.expire - _time) > 0 ? timer.expire - _time : 0;
+        uint32_t when = _time + delta;
+
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (uint32_t(1) << (kBits * (level + 1)))) {
+            level++;
+        }
+        if (level == kLevels - 1 && delta >= (uint32_t(1) << (kBits * kLevels)) - 1) {
+            // Too far, the furthest slot gets it and the timer is rescheduled on cascade
+            when = _time + (uint32_t(1) << (kBits * kLevels)) - 1;
+        }
+
+        entry &slot = _slots[level][(when >> (kBits * level)) & (kSlots - 1)];
+        timer.timer_prev = &slot;
+        timer.timer_next = slot.timer_next;
+        slot.timer_next->timer_prev = &timer;
+        slot.timer_next = &timer;
+    }
+
+    void unlink(entry &timer) {
+        timer.timer_prev->timer_next = timer.timer_next;
+        timer.timer_next->timer_prev = timer.timer_prev;
+        timer.timer_prev = nullptr;
+        timer.timer_next = nullptr;
+    }
+
+    // Next second to process: all timers of earlier seconds have fired
+    uint32_t _time;
+    std::size_t _size;
+
+    // Sentinels of circular intrusive lists of timers
+    entry _slots[kLevels][kSlots];
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TIMER_WHEEL_H
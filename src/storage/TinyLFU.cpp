@@ -0,0 +1,254 @@
+#include "TinyLFU.h"
+
+namespace Afina {
+namespace Backend {
+
+TinyLFU::TinyLFU(size_t max_size)
+    : _max_size(max_size), _lists{{nullptr, nullptr, 0}, {nullptr, nullptr, 0}, {nullptr, nullptr, 0}},
+      // A counter per row for each item of typical size, small sketch mistakes scan keys for hot ones
+      _sketch(max_size / kTypicalItem) {
+    // Sketch is paid from the same budget; the smallest one would eat a tiny cache whole, so it is free there
+    if (_sketch.Bytes() * 2 <= _max_size) {
+        _max_size -= _sketch.Bytes();
+    }
+    _window_max = _max_size / 100;
+    _protected_max = (_max_size - _window_max) * 8 / 10;
+}
+
+TinyLFU::~TinyLFU() {
+    _index.Clear();
+    for (lru_list &list : _lists) {
+        while (list.head != nullptr) {
+            lru_node *next = list.head->next;
+            delete list.head;
+            list.head = next;
+        }
+    }
+}
+
+// See TinyLFU.h
+TinyLFU::lru_node *TinyLFU::find_node(const std::string &key, std::size_t hash) const {
+    return _index.Find(hash, [&key](const lru_node &node) { return node.key == key; });
+}
+
+// See TinyLFU.h
+void TinyLFU::link_tail(lru_node &node, Segment segment) {
+    lru_list &list = list_of(segment);
+    node.segment = segment;
+    node.prev = list.tail;
+    node.next = nullptr;
+    if (list.tail == nullptr) {
+        list.head = &node;
+    } else {
+        list.tail->next = &node;
+    }
+    list.tail = &node;
+    list.size += node.key.size() + node.value.size();
+}
+
+// See TinyLFU.h
+void TinyLFU::unlink(lru_node &node) {
+    lru_list &list = list_of(node.segment);
+    if (node.prev == nullptr) {
+        list.head = node.next;
+    } else {
+        node.prev->next = node.next;
+    }
+
+    if (node.next == nullptr) {
+        list.tail = node.prev;
+    } else {
+        node.next->prev = node.prev;
+    }
+    list.size -= node.key.size() + node.value.size();
+}
+
+// See TinyLFU.h
+void TinyLFU::touch(lru_node &node) {
+    Segment segment = node.segment;
+    unlink(node);
+    if (segment == Segment::Window) {
+        link_tail(node, Segment::Window);
+        return;
+    }
+
+    // Second hit in main LRU promotes node to protected segment, overflow of which goes back to probation
+    link_tail(node, Segment::Protected);
+    lru_list &protect = list_of(Segment::Protected);
+    while (protect.size > _protected_max && protect.head != &node) {
+        lru_node *demoted = protect.head;
+        unlink(*demoted);
+        link_tail(*demoted, Segment::Probation);
+    }
+}
+
+// See TinyLFU.h
+TinyLFU::Segment TinyLFU::first_segment(const lru_node &node) const {
+    // Window couldn't hold such a node, it would be pushed out by the same put anyway
+    return node.key.size() + node.value.size() > _window_max ? Segment::Probation : Segment::Window;
+}
+
+// See TinyLFU.h
+TinyLFU::lru_node *TinyLFU::main_victim(const lru_node *skip1, const lru_node *skip2) {
+    for (Segment segment : {Segment::Probation, Segment::Protected}) {
+        lru_node *node = list_of(segment).head;
+        while (node != nullptr && (node == skip1 || node == skip2)) {
+            node = node->next;
+        }
+        if (node != nullptr) {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+// See TinyLFU.h
+bool TinyLFU::admit(lru_node &candidate, const lru_node *keep) {
+    while (main_size() > _max_size - _window_max) {
+        lru_node *victim = main_victim(&candidate, keep);
+        if (victim == nullptr) {
+            break;
+        }
+
+        if (_sketch.Estimate(candidate.hash) <= _sketch.Estimate(victim->hash)) {
+            delete_node(candidate);
+            Count(StorageCounters::kEvictions);
+            return false;
+        }
+        delete_node(*victim);
+        Count(StorageCounters::kEvictions);
+    }
+    return true;
+}
+
+// See TinyLFU.h
+void TinyLFU::rebalance(const lru_node *keep) {
+    lru_list &window = list_of(Segment::Window);
+
+    // Nodes pushed out of the window enter main LRU only if they are used more often than its victims
+    while (window.size > _window_max && window.head != keep) {
+        lru_node *candidate = window.head;
+        unlink(*candidate);
+        link_tail(*candidate, Segment::Probation);
+        admit(*candidate, keep);
+    }
+
+    // Window could still be over its limit because of the keep node, so check the whole budget
+    while (window.size + main_size() > _max_size) {
+        lru_node *victim = main_victim(keep, nullptr);
+        if (victim == nullptr) {
+            victim = (window.head != keep) ? window.head : window.head->next;
+        }
+        delete_node(*victim);
+        Count(StorageCounters::kEvictions);
+    }
+}
+
+// add to the storage the element which exactly is not in storage
+bool TinyLFU::add_element(const std::string &key, std::size_t hash, const std::string &value) {
+    if (key.size() + value.size() > _max_size) {
+        return false; // no chances to put the element to the storage
+    }
+
+    lru_node *node = new lru_node{key, value, hash, nullptr, nullptr, Segment::Window};
+    link_tail(*node, first_segment(*node));
+    _index.Insert(hash, node);
+    Count(StorageCounters::kBytes, key.size() + value.size());
+    Count(StorageCounters::kItems);
+    if (node->segment == Segment::Window || admit(*node, nullptr)) {
+        rebalance(node);
+    }
+    return true;
+}
+
+// update value of the exactly existing element
+bool TinyLFU::update_element(lru_node &node, const std::string &value) {
+    if (node.key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    lru_list &list = list_of(node.segment);
+    list.size = list.size - node.value.size() + value.size();
+    Count(StorageCounters::kBytes, int64_t(value.size()) - int64_t(node.value.size()));
+    node.value = value;
+
+    touch(node);
+    if (node.segment == Segment::Window && first_segment(node) != Segment::Window) {
+        // Grown out of the window, so it enters main LRU as any other candidate
+        unlink(node);
+        link_tail(node, Segment::Probation);
+        if (!admit(node, nullptr)) {
+            return true;
+        }
+    }
+    rebalance(&node);
+    return true;
+}
+
+// delete node that exactly exist
+void TinyLFU::delete_node(lru_node &node) {
+    unlink(node);
+    Count(StorageCounters::kBytes, -int64_t(node.key.size() + node.value.size()));
+    _index.Erase(node.hash, &node);
+    delete &node;
+    Count(StorageCounters::kItems, -1);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TinyLFU::Put(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    _sketch.Increment(hash);
+    lru_node *node = find_node(key, hash);
+    if (node == nullptr) {
+        return add_element(key, hash, value);
+    }
+    return update_element(*node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TinyLFU::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    _sketch.Increment(hash);
+    if (find_node(key, hash) != nullptr) {
+        return false;
+    }
+    return add_element(key, hash, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TinyLFU::Set(const std::string &key, const std::string &value) {
+    std::size_t hash = _hash_func(key);
+    _sketch.Increment(hash);
+    lru_node *node = find_node(key, hash);
+    if (node == nullptr) {
+        return false;
+    }
+    return update_element(*node, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TinyLFU::Delete(const std::string &key) {
+    lru_node *node = find_node(key, _hash_func(key));
+    if (node == nullptr) {
+        return false;
+    }
+    delete_node(*node);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool TinyLFU::Get(const std::string &key, std::string &value) {
+    // Misses count as well: key that is asked often deserves the place
+    std::size_t hash = _hash_func(key);
+    _sketch.Increment(hash);
+    lru_node *node = find_node(key, hash);
+    if (node == nullptr) {
+        return false;
+    }
+    value = node->value;
+    touch(*node);
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
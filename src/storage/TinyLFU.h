@@ -0,0 +1,128 @@
+#ifndef AFINA_STORAGE_TINY_LFU_H
+#define AFINA_STORAGE_TINY_LFU_H
+
+#include <functional>
+#include <string>
+
+#include <afina/Storage.h>
+
+#include "FrequencySketch.h"
+#include "RobinHoodIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # W-TinyLFU implementation
+ * New items get into the small window LRU (1% of memory). Items pushed out of the window compete for
+ * the place in the main segmented LRU: candidate is admitted only if it was accessed more often than the
+ * items main LRU would evict for it. Items bigger than the whole window skip it and compete at once, so
+ * put of a rarely used one could drop it right away, as the window would do a bit later. Frequencies of
+ * all the keys, even absent ones, are kept by the count-min sketch. So one-time keys of the scan go through
+ * the window and leave, while hot items stay. Memory of the sketch is charged to max_size, as is the memory
+ * of keys and values.
+ *
+ * Main LRU is segmented: items enter probation segment and get promoted to protected one (80% of main)
+ * on the next hit, overflow of protected segment goes back to probation.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class TinyLFU : public Afina::Storage {
+public:
+    TinyLFU(size_t max_size = 1024);
+
+    ~TinyLFU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+private:
+    // Item size the sketch is dimensioned for
+    static const std::size_t kTypicalItem = 32;
+
+    enum class Segment { Window = 0, Probation = 1, Protected = 2 };
+
+    // LRU cache node
+    struct lru_node {
+        const std::string key;
+        std::string value;
+        // hash of the key, cached to not recompute it on eviction and index growth
+        const std::size_t hash;
+        lru_node *prev;
+        lru_node *next;
+        Segment segment;
+    };
+
+    struct node_hash {
+        std::size_t operator()(const lru_node &node) const { return node.hash; }
+    };
+
+    // Segment list, head is the least recently used node
+    struct lru_list {
+        lru_node *head;
+        lru_node *tail;
+        // keys and values size
+        std::size_t size;
+    };
+
+    // Maximum number of bytes could be stored in this cache, without the sketch.
+    // i.e all (keys+values) must be less the _max_size
+    std::size_t _max_size;
+    std::size_t _window_max;
+    std::size_t _protected_max;
+
+    // Lists of the segments, own all nodes
+    lru_list _lists[3];
+
+    // Index of all nodes, allows fast random access to elements by lru_node#key
+    RobinHoodIndex<lru_node, node_hash> _index;
+
+    FrequencySketch _sketch;
+
+    std::hash<std::string> _hash_func;
+
+private:
+    lru_list &list_of(Segment segment) { return _lists[static_cast<int>(segment)]; }
+    std::size_t main_size() const { return _lists[1].size + _lists[2].size; }
+
+    // find node by key and its hash
+    lru_node *find_node(const std::string &key, std::size_t hash) const;
+    // append node to the tail of the segment
+    void link_tail(lru_node &node, Segment segment);
+    void unlink(lru_node &node);
+    // node has been accessed: move to the tail or promote to protected
+    void touch(lru_node &node);
+    // add new element to the storage
+    bool add_element(const std::string &key, std::size_t hash, const std::string &value);
+    // update existing node
+    bool update_element(lru_node &node, const std::string &value);
+    // delete existing node
+    void delete_node(lru_node &node);
+
+    // Segment new or grown node starts in
+    Segment first_segment(const lru_node &node) const;
+    // Least recently used node of main LRU, skipping the given ones
+    lru_node *main_victim(const lru_node *skip1, const lru_node *skip2);
+    // Makes room in main LRU for the candidate just linked to probation, evicting victims used less often
+    // than the candidate. Returns false if some victim is used as often and the candidate is evicted instead
+    bool admit(lru_node &candidate, const lru_node *keep);
+    // Restores segment limits after node has been added or grown, never evicts keep node
+    void rebalance(const lru_node *keep);
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TINY_LFU_H
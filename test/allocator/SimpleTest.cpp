@@ -103,6 +103,21 @@ TEST(SimpleTest, AllocNoMem) {
     }
 }
 
+TEST(SimpleTest, Fits) {
+    Simple a(buf, sizeof(buf));
+    EXPECT_TRUE(a.fits(1));
+    EXPECT_FALSE(a.fits(sizeof(buf)));
+
+    // The largest block that fits could be allocated indeed, the next size can't be
+    size_t size = 1;
+    while (a.fits(size + 1)) {
+        size++;
+    }
+    Pointer p = a.alloc(size);
+    a.free(p);
+    EXPECT_THROW(a.alloc(size + 1), AllocError);
+}
+
 TEST(SimpleTest, AllocReuse) {
     Simple a(buf, sizeof(buf));
 
@@ -322,3 +337,137 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, DoubleFree) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p = a.alloc(100);
+    Pointer copy = p;
+    a.free(p);
+    EXPECT_EQ(p.get(), nullptr);
+
+    // Freeing empty pointer does nothing, copy still refers to the released descriptor
+    a.free(p);
+    try {
+        a.free(copy);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+}
+
+TEST(SimpleTest, FreeMergesNeighbours) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs;
+    int size = 135;
+    ASSERT_TRUE(fillUp(a, size, ptrs));
+
+    // Three adjacent free blocks make enough room for the bigger one without defrag
+    a.free(ptrs[4]);
+    a.free(ptrs[5]);
+    a.free(ptrs[6]);
+    ptrs.erase(ptrs.begin() + 4, ptrs.begin() + 7);
+
+    Pointer p = a.alloc(size * 2);
+    writeTo(p, size * 2);
+    EXPECT_TRUE(isValidMemory(p, size * 2));
+
+    for (Pointer &p : ptrs) {
+        EXPECT_TRUE(isDataOk(p, size));
+        a.free(p);
+    }
+    EXPECT_TRUE(isDataOk(p, size * 2));
+    a.free(p);
+}
+
+TEST(SimpleTest, DefragStep) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs;
+    int size = 135;
+    ASSERT_TRUE(fillUp(a, size, ptrs));
+
+    // Every second block is free, there are no two adjacent holes
+    vector<Pointer> alive;
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        if (i % 2 == 0 && i + 1 < ptrs.size()) {
+            a.free(ptrs[i]);
+        } else {
+            alive.push_back(ptrs[i]);
+        }
+    }
+    EXPECT_GT(a.holes(), 0);
+    EXPECT_THROW(a.alloc(size * 4), AllocError);
+
+    // Compaction goes one block at a time and survives allocations in between
+    size_t steps = 0;
+    while (!a.defrag_step(1)) {
+        if (steps++ % 5 == 0) {
+            alive.push_back(a.alloc(size));
+            writeTo(alive.back(), size);
+        }
+        for (Pointer &p : alive) {
+            ASSERT_TRUE(isDataOk(p, size));
+        }
+    }
+    EXPECT_EQ(a.holes(), 0);
+    EXPECT_GT(steps, 1);
+
+    Pointer p = a.alloc(size * 4);
+    writeTo(p, size * 4);
+    for (Pointer &p : alive) {
+        EXPECT_TRUE(isValidMemory(p, size));
+        EXPECT_TRUE(isDataOk(p, size));
+        a.free(p);
+    }
+    EXPECT_TRUE(isDataOk(p, size * 4));
+    a.free(p);
+    EXPECT_NE(a.dump().find(" 0 used blocks"), std::string::npos);
+}
+
+TEST(SimpleTest, RandomChurn) {
+    Simple a(buf, sizeof(buf));
+
+    vector<pair<Pointer, size_t>> ptrs;
+    unsigned seed = 42;
+    for (int i = 0; i < 20000; i++) {
+        seed = seed * 1103515245 + 12345;
+        size_t size = 1 + (seed >> 8) % 700;
+        if (i % 7 == 0) {
+            a.defrag_step(2);
+        }
+
+        if (ptrs.empty() || (seed & 3) != 0) {
+            try {
+                ptrs.emplace_back(a.alloc(size), size);
+                writeTo(ptrs.back().first, size);
+            } catch (AllocError &) {
+                a.defrag();
+            }
+        } else {
+            size_t victim = (seed >> 4) % ptrs.size();
+            EXPECT_TRUE(isDataOk(ptrs[victim].first, ptrs[victim].second));
+            if (seed & 4) {
+                a.free(ptrs[victim].first);
+                ptrs.erase(ptrs.begin() + victim);
+            } else {
+                try {
+                    a.realloc(ptrs[victim].first, size);
+                    ptrs[victim].second = std::min(size, ptrs[victim].second);
+                    EXPECT_TRUE(isDataOk(ptrs[victim].first, ptrs[victim].second));
+                    ptrs[victim].second = size;
+                    writeTo(ptrs[victim].first, size);
+                } catch (AllocError &) {
+                }
+            }
+        }
+    }
+
+    for (auto &p : ptrs) {
+        EXPECT_TRUE(isValidMemory(p.first, p.second));
+        EXPECT_TRUE(isDataOk(p.first, p.second));
+        a.free(p.first);
+    }
+    EXPECT_NE(a.dump().find(" 0 used blocks"), std::string::npos);
+}
@@ -0,0 +1,152 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/SlabCache.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+namespace {
+
+const size_t kSlabSize = 4096;
+const size_t kSlabs = 64;
+
+struct Area {
+    Area() : data(new char[kSlabSize * kSlabs]) {}
+    std::unique_ptr<char[]> data;
+};
+
+} // namespace
+
+TEST(SlabCacheTest, TakeAllSlabs) {
+    Area area;
+    SlabCache cache(area.data.get(), kSlabSize * kSlabs, kSlabSize);
+    EXPECT_EQ(kSlabs, cache.slabs_count());
+
+    set<void *> slabs;
+    for (size_t i = 0; i < kSlabs; i++) {
+        void *s = cache.alloc();
+        EXPECT_TRUE(cache.owns(s));
+        EXPECT_TRUE(slabs.insert(s).second);
+    }
+    EXPECT_EQ(0, cache.free_slabs());
+
+    try {
+        cache.alloc();
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::NoMemory);
+    }
+
+    void *s = *slabs.begin();
+    cache.free(s);
+    EXPECT_EQ(s, cache.alloc());
+
+    try {
+        cache.free(reinterpret_cast<char *>(s) + 1);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+}
+
+TEST(SlabCacheTest, PoolReturnsSlabs) {
+    Area area;
+    SlabCache cache(area.data.get(), kSlabSize * kSlabs, kSlabSize);
+
+    {
+        Mempool pool(cache, 100);
+        set<void *> objects;
+        for (int i = 0; i < 1000; i++) {
+            void *p = pool.alloc();
+            EXPECT_TRUE(objects.insert(p).second);
+            memset(p, 0xAB, pool.object_size());
+        }
+        EXPECT_LT(cache.free_slabs(), kSlabs);
+
+        for (void *p : objects) {
+            pool.free(p);
+        }
+
+        // Freed objects are reused before new slabs are taken
+        size_t free_slabs = cache.free_slabs();
+        for (int i = 0; i < 1000; i++) {
+            EXPECT_EQ(1, objects.count(pool.alloc()));
+        }
+        EXPECT_EQ(free_slabs, cache.free_slabs());
+    }
+
+    EXPECT_EQ(kSlabs, cache.free_slabs());
+}
+
+TEST(SlabCacheTest, PoolExhausted) {
+    Area area;
+    SlabCache cache(area.data.get(), kSlabSize * 2, kSlabSize);
+    Mempool pool(cache, 1000);
+
+    try {
+        for (int i = 0; i < 100; i++) {
+            pool.alloc();
+        }
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::NoMemory);
+    }
+}
+
+TEST(SlabCacheTest, ConcurrentPools) {
+    Area area;
+    SlabCache cache(area.data.get(), kSlabSize * kSlabs, kSlabSize);
+    Mempool pool(cache, 48);
+
+    const int threads_count = 8;
+    const int objects_per_thread = 64;
+    std::atomic<bool> failed(false);
+
+    // Every thread stamps objects with its id, so that if two threads got the same object one of them
+    // notices the other stamp
+    auto worker = [&](int id) {
+        vector<uint64_t *> own;
+        for (int round = 0; round < 2000; round++) {
+            while (own.size() < objects_per_thread) {
+                uint64_t *p = reinterpret_cast<uint64_t *>(pool.alloc());
+                for (int j = 0; j < 6; j++) {
+                    p[j] = id;
+                }
+                own.push_back(p);
+            }
+            for (size_t i = round % 2; i < own.size(); i += 2) {
+                for (int j = 0; j < 6; j++) {
+                    if (own[i][j] != uint64_t(id)) {
+                        failed = true;
+                    }
+                }
+                pool.free(own[i]);
+                own[i] = nullptr;
+            }
+            vector<uint64_t *> rest;
+            for (auto p : own) {
+                if (p != nullptr) {
+                    rest.push_back(p);
+                }
+            }
+            own.swap(rest);
+        }
+        for (auto p : own) {
+            pool.free(p);
+        }
+    };
+
+    vector<thread> threads;
+    for (int i = 0; i < threads_count; i++) {
+        threads.emplace_back(worker, i + 1);
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_FALSE(failed);
+}
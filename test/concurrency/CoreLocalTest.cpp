@@ -0,0 +1,44 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/CoreLocal.h>
+
+using namespace Afina::Concurrency;
+
+TEST(CoreLocalTest, CopiesArePadded) {
+    CoreLocal<std::atomic<long>> counters;
+    EXPECT_GE(counters.Size(), 1);
+
+    const std::atomic<long> *previous = nullptr;
+    counters.ForEach([&previous](const std::atomic<long> &value) {
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(&value) % 64);
+        if (previous != nullptr) {
+            EXPECT_GE(reinterpret_cast<const char *>(&value) - reinterpret_cast<const char *>(previous), 64);
+        }
+        previous = &value;
+        EXPECT_EQ(0, value.load());
+    });
+}
+
+TEST(CoreLocalTest, SumOfCopies) {
+    CoreLocal<std::atomic<long>> counters;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 8; t++) {
+        workers.emplace_back([&counters]() {
+            for (int i = 0; i < 100000; i++) {
+                counters.Local().fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    long total = 0;
+    counters.ForEach([&total](const std::atomic<long> &value) { total += value.load(); });
+    EXPECT_EQ(800000, total);
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+using namespace Afina::Concurrency;
+
+namespace {
+
+// Updated by the owner thread only, so no read-modify-write is needed
+void add(std::atomic<long> &value, long delta) {
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+long sum(const ThreadLocal<std::atomic<long>> &counters) {
+    long total = 0;
+    counters.ForEach([&total](const std::atomic<long> &value) { total += value.load(); });
+    return total;
+}
+
+} // namespace
+
+TEST(ThreadLocalTest, CopyPerThread) {
+    ThreadLocal<std::atomic<long>> counters;
+    add(counters.Local(), 1);
+    EXPECT_EQ(&counters.Local(), &counters.Local());
+
+    std::atomic<long> *other = nullptr;
+    std::thread([&counters, &other]() {
+        other = &counters.Local();
+        add(*other, 2);
+    }).join();
+
+    EXPECT_NE(other, &counters.Local());
+
+    // Each copy takes its own cache line
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(other) % 64);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(&counters.Local()) % 64);
+    EXPECT_EQ(1, counters.Local().load());
+    EXPECT_EQ(3, sum(counters));
+}
+
+TEST(ThreadLocalTest, FinishedThreadsAreReused) {
+    ThreadLocal<std::atomic<long>> counters;
+
+    // Threads run one by one, so a single copy serves all of them and nothing is lost
+    for (int t = 0; t < 100; t++) {
+        std::thread([&counters]() {
+            for (int i = 0; i < 1000; i++) {
+                add(counters.Local(), 1);
+            }
+        }).join();
+    }
+    EXPECT_EQ(1, counters.Size());
+    EXPECT_EQ(100000, sum(counters));
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 8; t++) {
+        workers.emplace_back([&counters]() {
+            for (int i = 0; i < 100000; i++) {
+                add(counters.Local(), 1);
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    EXPECT_LE(counters.Size(), 8);
+    EXPECT_EQ(900000, sum(counters));
+}
+
+TEST(ThreadLocalTest, SeveralObjects) {
+    std::unique_ptr<ThreadLocal<std::atomic<long>>> first(new ThreadLocal<std::atomic<long>>);
+    ThreadLocal<std::atomic<long>> second;
+    add(first->Local(), 1);
+    add(second.Local(), 2);
+    EXPECT_EQ(1, first->Local().load());
+    EXPECT_EQ(2, second.Local().load());
+
+    // Copy of the destroyed object is forgotten, new object starts from scratch
+    first.reset(new ThreadLocal<std::atomic<long>>);
+    EXPECT_EQ(0, first->Local().load());
+    EXPECT_EQ(2, second.Local().load());
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+
+#include <afina/LatencyHistogram.h>
+#include <afina/Metrics.h>
+#include <afina/execute/Stats.h>
+
+#include "storage/CountedStorage.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+
+namespace {
+
+std::string stats(Metrics *metrics, const std::string &group = "") {
+    Backend::SimpleLRU storage;
+    std::string out;
+    Execute::Stats(metrics, group.empty() ? std::vector<std::string>() : std::vector<std::string>{group})
+        .Execute(storage, "", out);
+    return out;
+}
+
+} // namespace
+
+TEST(StatsTest, NoRegistry) { EXPECT_EQ("END", stats(nullptr)); }
+
+TEST(StatsTest, General) {
+    auto counters = std::make_shared<StorageCounters>();
+    Backend::CountedStorage storage(std::make_shared<Backend::SimpleLRU>(1024), counters);
+    Metrics metrics(counters, 1024);
+
+    std::string value;
+    storage.Put("KEY1", "val1");
+    storage.Get("KEY1", value);
+    storage.Get("KEY2", value);
+    metrics.Read(10);
+    metrics.Written(20);
+
+    std::string out = stats(&metrics);
+    EXPECT_EQ(0, out.find("STAT pid "));
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT cmd_get 2\r\n"));
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT cmd_set 1\r\n"));
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT get_hits 1\r\n"));
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT get_misses 1\r\n"));
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT bytes_read 10\r\n"));
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT bytes_written 20\r\n"));
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT limit_maxbytes 1024\r\n"));
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT curr_items 1\r\n"));
+    std::string bytes = std::to_string(Backend::SimpleLRU::ItemSize(4, 4));
+    EXPECT_NE(std::string::npos, out.find("\r\nSTAT bytes " + bytes + "\r\n"));
+    EXPECT_EQ(out.size() - 5, out.rfind("\r\nEND"));
+}
+
+TEST(StatsTest, Items) {
+    auto counters = std::make_shared<StorageCounters>();
+    Backend::CountedStorage storage(std::make_shared<Backend::SimpleLRU>(1024), counters);
+    Metrics metrics(counters, 1024);
+
+    // Does not fit into the storage
+    for (int i = 0; i < 100; i++) {
+        storage.Put("KEY" + std::to_string(i), std::string(20, 'a'));
+    }
+    int64_t number = counters->Total(StorageCounters::kItems);
+    int64_t evicted = counters->Total(StorageCounters::kEvictions);
+    EXPECT_LT(0, evicted);
+    EXPECT_EQ(100, number + evicted);
+    EXPECT_EQ("STAT items:1:number " + std::to_string(number) + "\r\nSTAT items:1:evicted " +
+                  std::to_string(evicted) + "\r\nEND",
+              stats(&metrics, "items"));
+}
+
+TEST(StatsTest, Conns) {
+    Metrics metrics(std::make_shared<StorageCounters>(), 0);
+
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(11211);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    metrics.Opened(7, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+    metrics.Opened(8, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+    metrics.Closed(8);
+
+    EXPECT_EQ(1, metrics.Total(Metrics::kCurrentConnections));
+    EXPECT_EQ(2, metrics.Total(Metrics::kTotalConnections));
+    EXPECT_EQ("STAT 7:addr tcp:127.0.0.1:11211\r\nSTAT 7:secs_since_connect 0\r\nEND", stats(&metrics, "conns"));
+}
+
+TEST(StatsTest, Reports) {
+    Metrics metrics(std::make_shared<StorageCounters>(), 0);
+    EXPECT_EQ("END", stats(&metrics, "slabs"));
+    EXPECT_EQ("CLIENT_ERROR unknown stats group", stats(&metrics, "foo"));
+
+    metrics.AddReport("foo", "bar", [](Metrics::Lines &out) { out.emplace_back("bar:size", "42"); });
+    EXPECT_EQ("STAT bar:size 42\r\nEND", stats(&metrics, "foo"));
+
+    metrics.RemoveReport("foo", "bar");
+    EXPECT_EQ("CLIENT_ERROR unknown stats group", stats(&metrics, "foo"));
+
+    // Standard group stays valid once its reports are gone
+    metrics.AddReport("slabs", "bar", [](Metrics::Lines &out) { out.emplace_back("bar:size", "42"); });
+    EXPECT_EQ("STAT bar:size 42\r\nEND", stats(&metrics, "slabs"));
+    metrics.RemoveReport("slabs", "bar");
+    EXPECT_EQ("END", stats(&metrics, "slabs"));
+}
+
+TEST(StatsTest, HistogramPercentiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0, histogram.Percentile(99));
+
+    // Small values are exact, others are within the bucket width
+    for (uint64_t i = 1; i <= 100000; i++) {
+        histogram.Record(i);
+    }
+    EXPECT_EQ(100000, histogram.Count());
+    EXPECT_EQ(50000, histogram.Mean());
+    EXPECT_EQ(100000, histogram.Max());
+    EXPECT_EQ(1, histogram.Percentile(0));
+    EXPECT_EQ(100000, histogram.Percentile(100));
+    for (double percent : {50.0, 90.0, 99.0, 99.9}) {
+        uint64_t exact = uint64_t(percent * 1000);
+        EXPECT_LE(exact, histogram.Percentile(percent));
+        EXPECT_GE(exact + exact / LatencyHistogram::kSubBuckets, histogram.Percentile(percent));
+    }
+
+    histogram.Record(UINT64_MAX);
+    EXPECT_EQ(uint64_t(LatencyHistogram::kMaxValue), histogram.Max());
+    EXPECT_EQ(uint64_t(LatencyHistogram::kMaxValue), histogram.Percentile(100));
+}
+
+TEST(StatsTest, Latency) {
+    Metrics metrics(std::make_shared<StorageCounters>(), 0);
+    EXPECT_EQ("END", stats(&metrics, "latency"));
+
+    // Threads run one after another, each takes over histograms of the finished one
+    for (int t = 0; t < 4; t++) {
+        std::thread([&metrics]() {
+            for (int i = 0; i < 1000; i++) {
+                metrics.Took(Metrics::kGet, Metrics::kTotal, 10);
+            }
+            metrics.Took(Metrics::kSet, Metrics::kParse, 20);
+        }).join();
+    }
+
+    LatencyHistogram get;
+    metrics.Latency(Metrics::kGet, Metrics::kTotal, get);
+    EXPECT_EQ(4000, get.Count());
+    EXPECT_EQ(1, metrics.Workers());
+
+    std::string lines = "STAT get:total:count 4000\r\nSTAT get:total:mean_ns 10\r\nSTAT get:total:p50_ns 10\r\n"
+                        "STAT get:total:p90_ns 10\r\nSTAT get:total:p99_ns 10\r\nSTAT get:total:p999_ns 10\r\n"
+                        "STAT get:total:max_ns 10\r\n"
+                        "STAT set:parse:count 4\r\nSTAT set:parse:mean_ns 20\r\nSTAT set:parse:p50_ns 20\r\n"
+                        "STAT set:parse:p90_ns 20\r\nSTAT set:parse:p99_ns 20\r\nSTAT set:parse:p999_ns 20\r\n"
+                        "STAT set:parse:max_ns 20\r\n";
+    // So they all are the worker 0
+    std::string worker = lines;
+    for (std::size_t at = 0; (at = worker.find("STAT ", at)) != std::string::npos; at += 7) {
+        worker.insert(at + 5, "0:");
+    }
+    EXPECT_EQ(lines + worker + "END", stats(&metrics, "latency"));
+}
+
+TEST(StatsTest, WorkerLatency) {
+    Metrics metrics(std::make_shared<StorageCounters>(), 0);
+
+    // Workers running at the same time have histograms of their own
+    std::atomic<int> started(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 2; t++) {
+        workers.emplace_back([&metrics, &started, t]() {
+            metrics.Took(Metrics::kGet, Metrics::kExecute, 10 * (t + 1));
+            started++;
+            while (started.load() < 2) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    EXPECT_EQ(2, metrics.Workers());
+    uint64_t total = 0;
+    for (std::size_t worker = 0; worker < 2; worker++) {
+        LatencyHistogram histogram;
+        metrics.WorkerLatency(worker, Metrics::kGet, Metrics::kExecute, histogram);
+        EXPECT_EQ(1, histogram.Count());
+        total += histogram.Max();
+    }
+    EXPECT_EQ(30, total);
+
+    std::string out = stats(&metrics, "latency");
+    EXPECT_NE(std::string::npos, out.find("STAT get:execute:count 2\r\n"));
+    EXPECT_NE(std::string::npos, out.find("STAT 0:get:execute:count 1\r\n"));
+    EXPECT_NE(std::string::npos, out.find("STAT 1:get:execute:count 1\r\n"));
+}
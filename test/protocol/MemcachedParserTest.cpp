@@ -3,8 +3,12 @@
 #include <memory>
 #include <string>
 
+#include <afina/Metrics.h>
 #include <afina/execute/Add.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/Prepend.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
 
@@ -98,3 +102,139 @@ TEST(MemcachedParserTest, Stats) {
     Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
     ASSERT_FALSE(tmp == nullptr);
 }
+
+// Verify stats group argument and counting of commands
+TEST(MemcachedParserTest, StatsGroup) {
+    Metrics metrics(std::make_shared<StorageCounters>(), 0);
+    Protocol::Parser parser(&metrics);
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("stats items\r\nget", consumed));
+    ASSERT_EQ(13, consumed);
+    ASSERT_EQ("stats", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Stats *stats = reinterpret_cast<Execute::Stats *>(cmd.get());
+    ASSERT_EQ(1, stats->args().size());
+    ASSERT_EQ("items", stats->args()[0]);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("get foo bar\r\n", consumed));
+    parser.Build(value_size);
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("set foo 0 0 1\r\n", consumed));
+    parser.Build(value_size);
+
+    EXPECT_EQ(1, metrics.Total(Metrics::kStats));
+    EXPECT_EQ(1, metrics.Total(Metrics::kGet));
+    EXPECT_EQ(1, metrics.Total(Metrics::kSet));
+    EXPECT_EQ(0, metrics.Total(Metrics::kCas));
+}
+
+// Verify expiration time with several digits and its overflow
+TEST(MemcachedParserTest, ExprTimeDigits) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("set foo 0 3600 6\r\n", consumed));
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_EQ(3600, reinterpret_cast<Execute::Set *>(cmd.get())->expire());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("set foo 0 -120 6\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_EQ(-120, reinterpret_cast<Execute::Set *>(cmd.get())->expire());
+
+    parser.Reset();
+    EXPECT_THROW(parser.Parse("set foo 0 99999999999 6\r\n", consumed), std::runtime_error);
+}
+
+// Verify gets and cas commands
+TEST(MemcachedParserTest, GetsAndCas) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("gets foo bar\r\n", consumed));
+    ASSERT_EQ("gets", parser.Name());
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Get *get = reinterpret_cast<Execute::Get *>(cmd.get());
+    ASSERT_EQ(2, get->keys().size());
+    ASSERT_TRUE(get->with_versions());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("cas foo 5 0 6 18446744073709551615\r\nfooval\r\n", consumed));
+    ASSERT_EQ(36, consumed);
+    ASSERT_EQ("cas", parser.Name());
+    cmd = parser.Build(value_size);
+    ASSERT_EQ(6, value_size);
+    Execute::Cas *cas = reinterpret_cast<Execute::Cas *>(cmd.get());
+    ASSERT_EQ("foo", cas->key());
+    ASSERT_EQ(5, cas->flags());
+    ASSERT_EQ(18446744073709551615ull, cas->version());
+
+    parser.Reset();
+    EXPECT_THROW(parser.Parse("cas foo 5 0 6 18446744073709551616\r\n", consumed), std::runtime_error);
+}
+
+// Verify prepend command is built
+TEST(MemcachedParserTest, Prepend) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("prepend log 0 0 4\r\nhead\r\n", consumed));
+    ASSERT_EQ(19, consumed);
+    ASSERT_EQ("prepend", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(4, value_size);
+
+    Execute::Prepend *tmp = reinterpret_cast<Execute::Prepend *>(cmd.get());
+    ASSERT_EQ("log", tmp->key());
+}
+
+// Verify incr and decr commands have no data block
+TEST(MemcachedParserTest, IncrDecr) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("incr counter 18446744073709551615\r\ndecr", consumed));
+    ASSERT_EQ(35, consumed);
+    ASSERT_EQ("incr", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0, value_size);
+
+    Execute::Incr *incr = reinterpret_cast<Execute::Incr *>(cmd.get());
+    ASSERT_EQ("counter", incr->key());
+    ASSERT_EQ(UINT64_MAX, incr->delta());
+    ASSERT_FALSE(incr->decrement());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("decr counter 7\r\n", consumed));
+    cmd = parser.Build(value_size);
+    incr = reinterpret_cast<Execute::Incr *>(cmd.get());
+    ASSERT_EQ(7, incr->delta());
+    ASSERT_TRUE(incr->decrement());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr counter 18446744073709551616\r\n", consumed), std::runtime_error);
+
+    // Delta is required and must be a number
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr counter\r\n", consumed), std::runtime_error);
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("decr\r\n", consumed), std::runtime_error);
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr counter 1x2\r\n", consumed), std::runtime_error);
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr counter -1\r\n", consumed), std::runtime_error);
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr counter \r\n", consumed), std::runtime_error);
+}
@@ -0,0 +1,75 @@
+#include "gtest/gtest.h"
+#include <map>
+#include <string>
+
+#include "storage/ArenaLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(ArenaLRUTest, AllocatorOverhead) {
+    ArenaLRU storage(1024);
+    EXPECT_TRUE(storage.Put("KEY", "val"));
+
+    // Fits into max_size, but not with allocator overhead: nothing is evicted for it
+    EXPECT_FALSE(storage.Put("KEY2", std::string(1024 - 4, 'x')));
+    EXPECT_FALSE(storage.Set("KEY", std::string(1024 - 3, 'x')));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY", value));
+    EXPECT_EQ("val", value);
+    EXPECT_LT(1024, ArenaLRU::ItemSize(4, 1024 - 4));
+}
+
+TEST(ArenaLRUTest, EvictLeastRecentlyUsed) {
+    ArenaLRU storage(4096);
+
+    // Way more than fits into the arena
+    for (int i = 0; i < 200; i++) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), std::string(100, 'a' + i % 26)));
+
+        // The first key is always fresh, so it is never evicted
+        std::string value;
+        EXPECT_TRUE(storage.Get("KEY0", value));
+    }
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY199", value));
+    EXPECT_EQ(std::string(100, 'a' + 199 % 26), value);
+}
+
+TEST(ArenaLRUTest, FragmentationChurn) {
+    const size_t arena_size = 64 * 1024;
+    ArenaLRU storage(arena_size);
+
+    // Values of very different sizes fragment the arena, compaction has to keep the data intact
+    map<string, string> model;
+    unsigned seed = 7;
+    for (int i = 0; i < 50000; i++) {
+        seed = seed * 1103515245 + 12345;
+        std::string key = "KEY" + std::to_string((seed >> 8) % 500);
+        size_t size = 1 + (seed >> 4) % ((seed & 1) ? 32 : 2000);
+
+        if ((seed >> 20) % 8 == 0) {
+            storage.Delete(key);
+            model.erase(key);
+        } else {
+            std::string value(size, char('a' + i % 26));
+            ASSERT_TRUE(storage.Put(key, value));
+            model[key] = value;
+        }
+    }
+
+    // Evicted items are gone, all the others must be untouched
+    size_t found = 0;
+    for (auto &kv : model) {
+        std::string value;
+        if (storage.Get(kv.first, value)) {
+            EXPECT_EQ(kv.second, value);
+            found++;
+        }
+    }
+    EXPECT_GT(found, 10);
+    EXPECT_LT(storage.Arena().holes(), arena_size / 4);
+}
@@ -0,0 +1,75 @@
+#include "gtest/gtest.h"
+#include <string>
+
+#include "storage/ClockLRU.h"
+#include "storage/SimpleLRU.h"
+
+#include "Workload.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(ClockLRUTest, SecondChance) {
+    ClockLRU storage(24);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    // KEY1 has reference bit set, so hand skips it and evicts KEY2
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_TRUE(storage.Get("KEY4", value));
+
+    // Growing value evicts others but never the updated node itself
+    EXPECT_TRUE(storage.Set("KEY3", "val3val3val3val3"));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_EQ("val3val3val3val3", value);
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY4", value));
+}
+
+TEST(ClockLRUTest, DeletedPositionsReused) {
+    ClockLRU storage(1000);
+
+    // Ring does not grow past the most items ever stored at once
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 10; i++) {
+            EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "value"));
+        }
+        EXPECT_EQ(10, storage.RingSize());
+        for (int i = 0; i < 10; i++) {
+            EXPECT_TRUE(storage.Delete("KEY" + std::to_string(i)));
+        }
+        EXPECT_EQ(10, storage.RingSize());
+    }
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY", "value"));
+    EXPECT_TRUE(storage.Get("KEY", value));
+    EXPECT_EQ(10, storage.RingSize());
+}
+
+// Compares CLOCK to the exact LRU, both keep the same number of items
+TEST(ClockLRUTest, CompareWithLRU) {
+    const size_t items = 1000;
+    const std::string value(32, 'v');
+    auto trace = Afina::Test::ZipfTrace(300000, 20000, 0.9, 42, 5000, 2000);
+
+    SimpleLRU lru(items * SimpleLRU::ItemSize(8, value.size()));
+    ClockLRU clock(items * (8 + value.size()));
+
+    auto lru_result = Afina::Test::Replay(lru, trace, value);
+    auto clock_result = Afina::Test::Replay(clock, trace, value);
+    Afina::Test::PrintReplay("SimpleLRU", lru_result);
+    Afina::Test::PrintReplay("ClockLRU", clock_result);
+
+    // Second chance is an approximation, but it must not be much worse
+    EXPECT_GT(lru_result.HitRatio(), 0.15);
+    EXPECT_GT(clock_result.HitRatio(), lru_result.HitRatio() - 0.02);
+}
@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/ClockLRU.h"
+#include "storage/CountedStorage.h"
+#include "storage/PolicyStorage.h"
+#include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
+
+using namespace Afina::Backend;
+using Afina::StorageCounters;
+using namespace std;
+
+TEST(CountedStorageTest, Requests) {
+    CountedStorage storage(std::make_shared<SimpleLRU>(1024));
+    const StorageCounters &counters = storage.Counters();
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Set("KEY1", "value"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+
+    std::vector<Afina::ValueView> values;
+    EXPECT_EQ(1, storage.MultiGet({"KEY1", "KEY2", "KEY3"}, values));
+
+    EXPECT_EQ(5, counters.Total(StorageCounters::kGets));
+    EXPECT_EQ(2, counters.Total(StorageCounters::kHits));
+    EXPECT_EQ(3, counters.Total(StorageCounters::kMisses));
+    EXPECT_EQ(3, counters.Total(StorageCounters::kSets));
+    EXPECT_EQ(12, counters.Total(StorageCounters::kBytesIn));
+    EXPECT_EQ(10, counters.Total(StorageCounters::kBytesOut));
+    EXPECT_EQ(1, counters.Total(StorageCounters::kItems));
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_EQ(0, counters.Total(StorageCounters::kItems));
+}
+
+TEST(CountedStorageTest, ItemsAndEvictions) {
+    // Every kind of storage reports its own items and evictions
+    std::vector<std::shared_ptr<Afina::Storage>> storages = {
+        std::make_shared<SimpleLRU>(100 * SimpleLRU::ItemSize(8, 8)), std::make_shared<ClockLRU>(100 * 16),
+        MakePolicyStorage("st_hash_fifo_items", 100)};
+
+    for (auto &inner : storages) {
+        CountedStorage storage(inner);
+        char key[16];
+        for (int i = 0; i < 150; i++) {
+            snprintf(key, sizeof(key), "KEY%05d", i);
+            EXPECT_TRUE(storage.Put(key, "value123"));
+        }
+        EXPECT_EQ(100, storage.Counters().Total(StorageCounters::kItems));
+        EXPECT_EQ(50, storage.Counters().Total(StorageCounters::kEvictions));
+    }
+}
+
+TEST(CountedStorageTest, ConcurrentShards) {
+    CountedStorage storage(std::make_shared<StripedLRU>(4, 4 * StripedLRU::kMinShardSize));
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, t]() {
+            std::string value;
+            for (int i = 0; i < 10000; i++) {
+                std::string key = "Key " + std::to_string(t) + " " + std::to_string(i);
+                storage.Put(key, std::string(100, 'a'));
+                storage.Get(key, value);
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    const StorageCounters &counters = storage.Counters();
+    EXPECT_EQ(40000, counters.Total(StorageCounters::kGets));
+    EXPECT_EQ(40000, counters.Total(StorageCounters::kSets));
+    EXPECT_EQ(40000, counters.Total(StorageCounters::kItems) + counters.Total(StorageCounters::kEvictions));
+    EXPECT_GT(counters.Total(StorageCounters::kEvictions), 0);
+}
@@ -0,0 +1,101 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/ExpiringStorage.h"
+#include "storage/HashLRU.h"
+#include "storage/SampledLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(ExpiringStorageTest, Expiration) {
+    ExpiringStorage storage(std::make_shared<HashLRU>(1024));
+
+    EXPECT_TRUE(storage.PutWithTTL("KEY1", "val1", 1));
+    EXPECT_TRUE(storage.PutIfAbsentWithTTL("KEY2", "val2", 1));
+    EXPECT_TRUE(storage.PutWithTTL("KEY3", "val3", 1000));
+    EXPECT_TRUE(storage.PutWithTTL("KEY4", "val4", 1));
+    // Put without ttl makes the key unexpirable again
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+    EXPECT_EQ(3, storage.Deadlines());
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Set("KEY2", "val"));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_TRUE(storage.Get("KEY4", value));
+    EXPECT_EQ(1, storage.Deadlines());
+
+    // Expired key is gone from the storage itself, so it could be added again
+    EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2"));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("val2", value);
+}
+
+TEST(ExpiringStorageTest, UpdatesOfExpiredKeys) {
+    ExpiringStorage storage(std::make_shared<HashLRU>(1024));
+
+    EXPECT_TRUE(storage.PutWithTTL("KEY1", "1", 1));
+    EXPECT_TRUE(storage.PutWithTTL("KEY2", "val2", 1));
+    EXPECT_TRUE(storage.PutWithTTL("KEY3", "val3", 1));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+
+    uint64_t number = 0;
+    EXPECT_FALSE(storage.Increment("KEY1", 1, number));
+    EXPECT_FALSE(storage.Append("KEY2", "data"));
+    EXPECT_FALSE(storage.Delete("KEY3"));
+
+    std::vector<Afina::ValueView> values;
+    EXPECT_EQ(0, storage.MultiGet({"KEY1", "KEY2", "KEY3"}, values));
+    EXPECT_EQ(0, storage.Deadlines());
+}
+
+TEST(ExpiringStorageTest, EvictedKeysSwept) {
+    auto inner = std::make_shared<HashLRU>(1024);
+    ExpiringStorage storage(inner);
+
+    // Storage keeps few of the keys, deadlines of the rest are swept once they expire
+    for (int i = 0; i < 10000; i++) {
+        EXPECT_TRUE(storage.PutWithTTL("KEY" + std::to_string(i), "val", 1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    for (int i = 0; i < 10000; i++) {
+        EXPECT_TRUE(storage.PutWithTTL("NEW" + std::to_string(i), "val", 1000));
+    }
+    EXPECT_GT(15000, storage.Deadlines());
+
+    std::string value;
+    for (int i = 0; i < 10000; i++) {
+        EXPECT_FALSE(storage.Get("KEY" + std::to_string(i), value));
+    }
+}
+
+TEST(ExpiringStorageTest, ConcurrentWrites) {
+    ExpiringStorage storage(std::make_shared<SampledLRU>(1024 * 1024));
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, t]() {
+            for (int i = 0; i < 1000; i++) {
+                std::string key = "KEY" + std::to_string(t) + ":" + std::to_string(i % 100);
+                EXPECT_TRUE(storage.PutWithTTL(key, "val", i / 100 % 2 == 0 ? 0 : 1000));
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    // Last write of every key has ttl
+    EXPECT_EQ(400, storage.Deadlines());
+}
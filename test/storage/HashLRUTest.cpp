@@ -0,0 +1,235 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+#include "storage/HashLRU.h"
+#include "storage/RobinHoodIndex.h"
+
+#include "Workload.h"
+
+using namespace Afina::Backend;
+using namespace Afina::Test;
+using namespace std;
+
+namespace {
+
+struct Entry {
+    std::string key;
+    std::size_t hash;
+};
+
+struct EntryHash {
+    std::size_t operator()(const Entry &e) const { return e.hash; }
+};
+
+} // namespace
+
+TEST(RobinHoodIndexTest, CollidingHashes) {
+    RobinHoodIndex<Entry, EntryHash> index;
+
+    // All entries share the same home slot and fingerprint, so only predicate tells them apart
+    std::vector<Entry> entries;
+    for (int i = 0; i < 100; i++) {
+        entries.push_back(Entry{"key" + std::to_string(i), 42});
+    }
+    for (auto &e : entries) {
+        index.Insert(e.hash, &e);
+    }
+    EXPECT_EQ(100, index.Size());
+
+    for (auto &e : entries) {
+        Entry *found = index.Find(e.hash, [&e](const Entry &o) { return o.key == e.key; });
+        EXPECT_EQ(&e, found);
+    }
+
+    for (size_t i = 0; i < entries.size(); i += 2) {
+        EXPECT_TRUE(index.Erase(entries[i].hash, &entries[i]));
+    }
+    EXPECT_FALSE(index.Erase(entries[0].hash, &entries[0]));
+    EXPECT_EQ(50, index.Size());
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        const std::string &key = entries[i].key;
+        Entry *found = index.Find(42, [&key](const Entry &o) { return o.key == key; });
+        EXPECT_EQ(i % 2 == 0 ? nullptr : &entries[i], found);
+    }
+}
+
+TEST(RobinHoodIndexTest, GrowAndShrink) {
+    RobinHoodIndex<Entry, EntryHash> index;
+    std::hash<std::string> hash_func;
+
+    std::vector<Entry> entries;
+    entries.reserve(10000);
+    for (int i = 0; i < 10000; i++) {
+        std::string key = "key" + std::to_string(i);
+        entries.push_back(Entry{key, hash_func(key)});
+        index.Insert(entries.back().hash, &entries.back());
+    }
+    EXPECT_EQ(10000, index.Size());
+    EXPECT_GE(index.Capacity() * 7, index.Size() * 8);
+
+    for (auto &e : entries) {
+        EXPECT_EQ(&e, index.Find(e.hash, [&e](const Entry &o) { return o.key == e.key; }));
+    }
+
+    for (auto &e : entries) {
+        EXPECT_TRUE(index.Erase(e.hash, &e));
+    }
+    EXPECT_EQ(0, index.Size());
+    EXPECT_EQ(nullptr, index.Find(entries[0].hash, [](const Entry &) { return true; }));
+}
+
+TEST(HashLRUTest, TooBigElement) {
+    HashLRU storage(16);
+
+    EXPECT_FALSE(storage.Put("KEY1", std::string(16, 'v')));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.Set("KEY1", std::string(16, 'v')));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+}
+
+TEST(HashLRUTest, EvictLeastRecentlyUsed) {
+    HashLRU storage(24);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    // KEY1 becomes the freshest one, so KEY2 has to go first
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_TRUE(storage.Get("KEY4", value));
+
+    // Growing value evicts from the head but never the updated node itself
+    EXPECT_TRUE(storage.Set("KEY3", "val3val3val3val3"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY4", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_EQ("val3val3val3val3", value);
+}
+
+TEST(HashLRUTest, Churn) {
+    const size_t length = 16;
+    HashLRU storage(2 * 500 * length);
+
+    // Constant eviction and deletes keep index full of backward shifts
+    for (long round = 0; round < 20; ++round) {
+        for (long i = 0; i < 1000; ++i) {
+            auto key = PadSpace("Key " + std::to_string(round * 1000 + i), length);
+            EXPECT_TRUE(storage.Put(key, key));
+            if (i % 3 == 0) {
+                EXPECT_TRUE(storage.Delete(key));
+            }
+        }
+    }
+
+    std::string res;
+    for (long i = 0; i < 1000; ++i) {
+        auto key = PadSpace("Key " + std::to_string(i), length);
+        EXPECT_FALSE(storage.Get(key, res));
+    }
+
+    // Last 333 survived keys for sure fit into the storage
+    for (long i = 19500; i < 20000; ++i) {
+        auto key = PadSpace("Key " + std::to_string(i), length);
+        if ((i % 1000) % 3 == 0) {
+            EXPECT_FALSE(storage.Get(key, res));
+        } else {
+            EXPECT_TRUE(storage.Get(key, res));
+            EXPECT_EQ(key, res);
+        }
+    }
+}
+
+TEST(HashLRUTest, MultiGet) {
+    HashLRU storage(64 * 1024);
+    for (int i = 0; i < 1000; i += 2) {
+        ASSERT_TRUE(storage.Put("Key " + std::to_string(i), "Value " + std::to_string(i)));
+    }
+
+    std::vector<std::string> keys;
+    for (int i = 0; i < 1000; i += 3) {
+        keys.push_back("Key " + std::to_string(i));
+    }
+
+    std::vector<Afina::ValueView> values;
+    EXPECT_EQ(167, storage.MultiGet(keys, values));
+    ASSERT_EQ(keys.size(), values.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i * 3 % 2 == 0) {
+            ASSERT_TRUE(values[i].valid());
+            EXPECT_EQ("Value " + std::to_string(i * 3), values[i].str());
+        } else {
+            EXPECT_FALSE(values[i].valid());
+        }
+    }
+}
+
+TEST(HashLRUTest, IncrementDecrement) {
+    // Default implementation of the interface
+    HashLRU storage;
+    uint64_t number;
+
+    EXPECT_FALSE(storage.Increment("KEY1", 1, number));
+    EXPECT_TRUE(storage.Put("KEY1", "99"));
+    EXPECT_TRUE(storage.Increment("KEY1", 1, number));
+    EXPECT_EQ(100, number);
+    EXPECT_TRUE(storage.Decrement("KEY1", 101, number));
+    EXPECT_EQ(0, number);
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("0", value);
+
+    EXPECT_TRUE(storage.Put("KEY1", "-1"));
+    EXPECT_THROW(storage.Increment("KEY1", 1, number), std::invalid_argument);
+}
+
+TEST(HashLRUTest, UntrackedVersions) {
+    HashLRU storage(1024);
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+
+    // Versions aren't tracked, but the value is still there for gets
+    std::string value;
+    uint64_t version = 0;
+    EXPECT_TRUE(storage.GetWithVersion("KEY1", value, version));
+    EXPECT_EQ("val1", value);
+    EXPECT_EQ(uint64_t(Afina::Storage::kUntracked), version);
+    EXPECT_FALSE(storage.GetWithVersion("KEY2", value, version));
+
+    // Existing key is never reported as missing, the value isn't changed
+    EXPECT_FALSE(storage.CompareAndSet("KEY1", "val2", 0, version));
+    EXPECT_NE(0, version);
+    version = 0;
+    EXPECT_FALSE(storage.CompareAndSet("KEY1", "val2", 0, version));
+    EXPECT_NE(0, version);
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+
+    EXPECT_FALSE(storage.CompareAndSet("KEY2", "val2", 0, version));
+    EXPECT_EQ(0, version);
+}
+
+TEST(HashLRUTest, TtlRejected) {
+    HashLRU storage(1024);
+
+    // HashLRU can't expire items, so it stores only ones without ttl, see ExpiringStorage
+    EXPECT_FALSE(storage.PutWithTTL("KEY1", "val1", 60));
+    EXPECT_FALSE(storage.PutIfAbsentWithTTL("KEY2", "val2", 60));
+    EXPECT_TRUE(storage.PutWithTTL("KEY1", "val1", 0));
+    EXPECT_FALSE(storage.SetWithTTL("KEY1", "val3", 60));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+    EXPECT_FALSE(storage.Get("KEY2", value));
+}
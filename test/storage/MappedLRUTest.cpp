@@ -0,0 +1,192 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "storage/MappedLRU.h"
+
+#include "Workload.h"
+
+using namespace Afina::Backend;
+using namespace Afina::Test;
+using namespace std;
+
+namespace {
+
+// Path of the storage file, removed once the test is over
+struct temp_file {
+    explicit temp_file(const std::string &name)
+        : path("/tmp/afina_mapped_" + std::to_string(getpid()) + "_" + name) {}
+    ~temp_file() { std::remove(path.c_str()); }
+
+    const std::string path;
+};
+
+} // namespace
+
+TEST(MappedLRUTest, PutOverwrite) {
+    temp_file file("overwrite");
+    MappedLRU storage(file.path);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY1", "val2"));
+    EXPECT_TRUE(storage.Put("KEY2", "short"));
+    EXPECT_TRUE(storage.Put("KEY2", std::string(1000, 'l')));
+    EXPECT_TRUE(storage.Put("KEY2", "short again"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val2", value);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("short again", value);
+    EXPECT_EQ(2, storage.Size());
+}
+
+TEST(MappedLRUTest, TooBigElement) {
+    temp_file file("too_big");
+    MappedLRU storage(file.path, 4096);
+
+    EXPECT_FALSE(storage.Put("KEY1", std::string(4096, 'v')));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.Set("KEY1", std::string(4096, 'v')));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+}
+
+TEST(MappedLRUTest, EvictLeastRecentlyUsed) {
+    temp_file file("evict");
+    MappedLRU storage(file.path, 3 * MappedLRU::ItemSize(4, 4));
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    // KEY1 becomes the freshest one, so KEY2 has to go first
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_TRUE(storage.Get("KEY4", value));
+}
+
+TEST(MappedLRUTest, MixedSizesChurn) {
+    temp_file file("churn");
+    MappedLRU storage(file.path, 64 * 1024);
+
+    // Blocks of different classes are reused and evicted, the newest items always fit
+    for (long i = 0; i < 20000; ++i) {
+        auto key = "Key " + std::to_string(i);
+        EXPECT_TRUE(storage.Put(key, std::string(i * 37 % 2000, 'a' + i % 26)));
+        if (i % 5 == 0) {
+            EXPECT_TRUE(storage.Delete(key));
+        }
+    }
+
+    std::string res;
+    EXPECT_TRUE(storage.Get("Key 19999", res));
+    EXPECT_EQ(std::string(19999 * 37 % 2000, 'a' + 19999 % 26), res);
+    EXPECT_FALSE(storage.Get("Key 19995", res));
+}
+
+TEST(MappedLRUTest, BigItemAmongSmallOnes) {
+    temp_file file("big_item");
+    MappedLRU storage(file.path, 1024 * 1024);
+
+    long count = 0;
+    while (storage.Size() == std::size_t(count)) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(count++), std::string(100, 'a')));
+    }
+    std::size_t small = storage.Size();
+
+    // Only blocks right after the oldest one make room for the big item, the rest stay
+    EXPECT_TRUE(storage.Put("Big", std::string(10 * 1024, 'b')));
+    EXPECT_GT(storage.Size(), small * 95 / 100);
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("Big", value));
+    EXPECT_EQ(std::string(10 * 1024, 'b'), value);
+    EXPECT_TRUE(storage.Get("Key " + std::to_string(count - 1), value));
+
+    // Area stays consistent: small items reuse what is left of the merged blocks
+    for (long i = 0; i < 2 * count; i++) {
+        EXPECT_TRUE(storage.Put("Key " + std::to_string(i), std::string(100 + i % 50, 'c')));
+    }
+    EXPECT_TRUE(storage.Get("Key " + std::to_string(2 * count - 1), value));
+    EXPECT_EQ(std::string(100 + (2 * count - 1) % 50, 'c'), value);
+}
+
+TEST(MappedLRUTest, Reattach) {
+    const size_t length = 12;
+    temp_file file("reattach");
+    {
+        MappedLRU storage(file.path, 256 * 1024);
+        EXPECT_FALSE(storage.Reattached());
+        for (int i = 0; i < 1000; i++) {
+            auto key = PadSpace("Key " + std::to_string(i), length);
+            EXPECT_TRUE(storage.Put(key, PadSpace("Val " + std::to_string(i), length)));
+        }
+
+        // Only one process at a time
+        EXPECT_THROW(MappedLRU(file.path, 256 * 1024), std::runtime_error);
+    }
+
+    {
+        MappedLRU storage(file.path, 256 * 1024);
+        EXPECT_TRUE(storage.Reattached());
+        EXPECT_EQ(1000, storage.Size());
+
+        std::string value;
+        for (int i = 0; i < 1000; i++) {
+            EXPECT_TRUE(storage.Get(PadSpace("Key " + std::to_string(i), length), value));
+            EXPECT_EQ(PadSpace("Val " + std::to_string(i), length), value);
+        }
+        EXPECT_TRUE(storage.Get(PadSpace("Key 0", length), value));
+    }
+
+    {
+        // LRU order has survived as well: Key 1 is the oldest one now
+        MappedLRU storage(file.path, 256 * 1024);
+        EXPECT_TRUE(storage.Reattached());
+        for (int i = 1000; storage.Size() == std::size_t(i); i++) {
+            auto key = PadSpace("Key " + std::to_string(i), length);
+            EXPECT_TRUE(storage.Put(key, PadSpace("Val " + std::to_string(i), length)));
+        }
+
+        std::string value;
+        EXPECT_FALSE(storage.Get(PadSpace("Key 1", length), value));
+        EXPECT_TRUE(storage.Get(PadSpace("Key 0", length), value));
+        EXPECT_TRUE(storage.Get(PadSpace("Key 2", length), value));
+    }
+
+    // Other size makes an empty storage
+    {
+        MappedLRU storage(file.path, 512 * 1024);
+        EXPECT_FALSE(storage.Reattached());
+        EXPECT_EQ(0, storage.Size());
+    }
+}
+
+TEST(MappedLRUTest, DirtyFileIsReset) {
+    temp_file file("dirty"), copy("dirty_copy");
+    MappedLRU storage(file.path, 64 * 1024);
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+
+    // Copy of the file taken while it is in use looks like one left by a crashed process
+    {
+        std::ifstream in(file.path, std::ios::binary);
+        std::ofstream out(copy.path, std::ios::binary);
+        out << in.rdbuf();
+    }
+    MappedLRU restarted(copy.path, 64 * 1024);
+    EXPECT_FALSE(restarted.Reattached());
+    EXPECT_EQ(0, restarted.Size());
+}
@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/PolicyStorage.h"
+
+#include "Workload.h"
+
+using namespace Afina::Backend;
+using namespace Afina::Test;
+using namespace std;
+
+namespace {
+
+template <typename Storage> class PolicyStorageTest : public ::testing::Test {};
+
+// Every policy appears at least once, the common storage contract is checked by StorageTest
+typedef ::testing::Types<
+    PolicyStorage<Policy::OrderedIndex, Policy::LruEviction, Policy::NoLock, Policy::ByteSize>,
+    PolicyStorage<Policy::HashIndex, Policy::LruEviction, Policy::MutexLock, Policy::ByteSize>,
+    PolicyStorage<Policy::HashIndex, Policy::FifoEviction, Policy::NoLock, Policy::ByteSize>,
+    PolicyStorage<Policy::OrderedIndex, Policy::ClockEviction, Policy::MutexLock, Policy::ByteSize>,
+    PolicyStorage<Policy::HashIndex, Policy::ClockEviction, Policy::NoLock, Policy::ItemCount>>
+    Combinations;
+TYPED_TEST_CASE(PolicyStorageTest, Combinations);
+
+} // namespace
+
+TYPED_TEST(PolicyStorageTest, KeepsLimit) {
+    const size_t length = 20;
+    TypeParam storage(1000 * 2 * length);
+
+    // Item size is either 40 bytes or 1 item, both limits are not less than 1000 items
+    for (long i = 0; i < 1100; ++i) {
+        auto key = PadSpace("Key " + std::to_string(i), length);
+        auto val = PadSpace("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+    EXPECT_LE(storage.CurrentSize(), 1000 * 2 * length);
+
+    std::string value;
+    auto last = PadSpace("Key 1099", length);
+    EXPECT_TRUE(storage.Get(last, value));
+    EXPECT_EQ(PadSpace("Val 1099", length), value);
+}
+
+TEST(PolicyStorageTest, EvictionOrder) {
+    // Room for three items
+    PolicyStorage<Policy::HashIndex, Policy::LruEviction, Policy::NoLock, Policy::ItemCount> lru(3);
+    PolicyStorage<Policy::HashIndex, Policy::FifoEviction, Policy::NoLock, Policy::ItemCount> fifo(3);
+    PolicyStorage<Policy::HashIndex, Policy::ClockEviction, Policy::NoLock, Policy::ItemCount> clock(3);
+
+    std::vector<Afina::Storage *> storages = {&lru, &fifo, &clock};
+    std::string value;
+    for (auto storage : storages) {
+        EXPECT_TRUE(storage->Put("KEY1", "val1"));
+        EXPECT_TRUE(storage->Put("KEY2", "val2"));
+        EXPECT_TRUE(storage->Put("KEY3", "val3"));
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        EXPECT_TRUE(storage->Put("KEY4", "val4"));
+    }
+
+    // LRU and CLOCK keep the used item, FIFO doesn't care
+    EXPECT_TRUE(lru.Get("KEY1", value));
+    EXPECT_FALSE(lru.Get("KEY2", value));
+    EXPECT_FALSE(fifo.Get("KEY1", value));
+    EXPECT_TRUE(fifo.Get("KEY2", value));
+    EXPECT_TRUE(clock.Get("KEY1", value));
+    EXPECT_FALSE(clock.Get("KEY2", value));
+}
+
+TEST(PolicyStorageTest, ConcurrentAccess) {
+    PolicyStorage<Policy::HashIndex, Policy::ClockEviction, Policy::MutexLock, Policy::ByteSize> storage(64 * 1024);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, t]() {
+            std::string value;
+            for (int i = 0; i < 10000; i++) {
+                std::string key = "Key " + std::to_string(i % 500);
+                storage.Put(key, std::string(i % 100, 'a' + t));
+                if (storage.Get(key, value)) {
+                    EXPECT_EQ(std::string(value.size(), value.empty() ? 'a' : value[0]), value);
+                }
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    EXPECT_LE(storage.CurrentSize(), 64 * 1024);
+}
+
+TEST(PolicyStorageTest, MakeFromSpec) {
+    EXPECT_TRUE(MakePolicyStorage("st_map_lru_bytes", 1024) != nullptr);
+    EXPECT_TRUE(MakePolicyStorage("mt_hash_clock_items", 1024) != nullptr);
+    EXPECT_TRUE(MakePolicyStorage("mt_map_fifo_bytes", 1024) != nullptr);
+
+    EXPECT_TRUE(MakePolicyStorage("st_lru", 1024) == nullptr);
+    EXPECT_TRUE(MakePolicyStorage("xt_map_lru_bytes", 1024) == nullptr);
+    EXPECT_TRUE(MakePolicyStorage("st_map_lru_bytes_more", 1024) == nullptr);
+    EXPECT_TRUE(MakePolicyStorage("st_tree_lru_bytes", 1024) == nullptr);
+
+    auto storage = MakePolicyStorage("st_hash_lru_items", 2);
+    std::string value;
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+    EXPECT_TRUE(storage->Put("KEY2", "val2"));
+    EXPECT_TRUE(storage->Put("KEY3", "val3"));
+    EXPECT_FALSE(storage->Get("KEY1", value));
+    EXPECT_TRUE(storage->Get("KEY3", value));
+}
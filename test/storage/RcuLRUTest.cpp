@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/RcuLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(RcuLRUTest, SecondChance) {
+    RcuLRU storage(24);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    // KEY1 has reference bit set, so hand skips it and evicts KEY2
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_TRUE(storage.Get("KEY4", value));
+
+    // Growing value evicts others but never the updated item itself
+    EXPECT_TRUE(storage.Set("KEY3", "val3val3val3val3"));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_EQ("val3val3val3val3", value);
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY4", value));
+}
+
+TEST(RcuLRUTest, BigTest) {
+    const size_t length = 20;
+    RcuLRU storage(2 * 100000 * length);
+
+    for (long i = 0; i < 100000; ++i) {
+        auto key = "Key " + std::to_string(i);
+        std::string val = "Val " + std::to_string(i);
+        val.resize(length, ' ');
+        key.resize(length, ' ');
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    for (long i = 99999; i >= 0; --i) {
+        if (i % 3 == 0) {
+            auto key = "Key " + std::to_string(i);
+            key.resize(length, ' ');
+            EXPECT_TRUE(storage.Delete(key));
+        }
+    }
+
+    for (long i = 99999; i >= 0; --i) {
+        auto key = "Key " + std::to_string(i);
+        std::string val = "Val " + std::to_string(i);
+        val.resize(length, ' ');
+        key.resize(length, ' ');
+
+        std::string res;
+        EXPECT_EQ(i % 3 != 0, storage.Get(key, res));
+        if (i % 3 != 0) {
+            EXPECT_EQ(val, res);
+        }
+    }
+}
+
+TEST(RcuLRUTest, ConcurrentReaders) {
+    RcuLRU storage(16 * 1024);
+
+    // Value always starts with its key, so torn or freed item would be visible
+    auto value_of = [](int key, int version) { return "KEY" + std::to_string(key) + ":" + std::to_string(version); };
+    for (int i = 0; i < 100; i++) {
+        storage.Put("KEY" + std::to_string(i), value_of(i, 0));
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<long> errors(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&storage, &stop, &errors, t]() {
+            std::string value;
+            for (unsigned i = t; !stop.load(); i++) {
+                std::string key = "KEY" + std::to_string(i % 500);
+                if (storage.Get(key, value) && value.compare(0, key.size() + 1, key + ":") != 0) {
+                    errors++;
+                }
+            }
+        });
+    }
+
+    // Writer updates, deletes and evicts, tables get rebuilt in the meantime
+    for (int v = 1; v < 20000; v++) {
+        int key = v % 500;
+        if (v % 7 == 0) {
+            storage.Delete("KEY" + std::to_string(key));
+        } else {
+            storage.Put("KEY" + std::to_string(key), value_of(key, v) + std::string(v % 100, 'x'));
+        }
+    }
+
+    stop = true;
+    for (auto &t : readers) {
+        t.join();
+    }
+    EXPECT_EQ(0, errors.load());
+}
@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/SampledLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(SampledLRUTest, ItemOverheadAccounted) {
+    const size_t item_size = SampledLRU::ItemSize(4, 4);
+    EXPECT_GT(item_size, 8);
+
+    SampledLRU storage(2 * item_size);
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_EQ(0, storage.Evictions());
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+    EXPECT_EQ(1, storage.Evictions());
+}
+
+TEST(SampledLRUTest, UpdatedNodeIsNotEvicted) {
+    const size_t item_size = SampledLRU::ItemSize(4, 4);
+    SampledLRU storage(3 * item_size);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    // Growing value evicts others but never the updated node itself
+    std::string value;
+    const std::string big(2 * item_size, 'v');
+    EXPECT_TRUE(storage.Set("KEY2", big));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ(big, value);
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY3", value));
+    EXPECT_EQ(2, storage.Evictions());
+}
+
+TEST(SampledLRUTest, ChurnKeepsLimit) {
+    SampledLRU storage(1000);
+
+    std::string value;
+    for (int i = 0; i < 10000; i++) {
+        std::string key = "KEY" + std::to_string(i);
+        EXPECT_TRUE(storage.Put(key, std::string(i % 40, 'v')));
+        if (i % 3 == 1) {
+            storage.Delete("KEY" + std::to_string(i / 2));
+        }
+        EXPECT_TRUE(storage.Get(key, value));
+    }
+    EXPECT_GT(storage.Evictions(), 0);
+}
+
+// Recently used items must survive the flood of new ones much better than random ones would
+TEST(SampledLRUTest, ApproximateLRU) {
+    const std::string value(32, 'v');
+    SampledLRU storage(1000 * SampledLRU::ItemSize(8, value.size()));
+
+    char key[16];
+    for (int i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "old%05d", i);
+        EXPECT_TRUE(storage.Put(key, value));
+    }
+
+    // Access times are coarse, make sure hot items are younger
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::string got;
+    for (int i = 0; i < 100; i++) {
+        snprintf(key, sizeof(key), "old%05d", i * 10);
+        EXPECT_TRUE(storage.Get(key, got));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    for (int i = 0; i < 500; i++) {
+        snprintf(key, sizeof(key), "new%05d", i);
+        EXPECT_TRUE(storage.Put(key, value));
+    }
+
+    int survived = 0;
+    for (int i = 0; i < 100; i++) {
+        snprintf(key, sizeof(key), "old%05d", i * 10);
+        survived += storage.Get(key, got);
+    }
+    EXPECT_GE(survived, 90);
+}
+
+TEST(SampledLRUTest, ConcurrentAccess) {
+    SampledLRU storage(64 * 1024);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, t]() {
+            std::string value;
+            for (int i = 0; i < 20000; i++) {
+                std::string key = "Key " + std::to_string(i % 1500);
+                if (i % 4 == t) {
+                    storage.Put(key, std::string(i % 100, 'a' + t));
+                } else if (storage.Get(key, value)) {
+                    EXPECT_EQ(std::string(value.size(), value.empty() ? 'a' : value[0]), value);
+                }
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    EXPECT_GT(storage.Evictions(), 0);
+}
@@ -0,0 +1,351 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "storage/SimpleLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(SimpleLRUTest, ItemOverheadAccounted) {
+    const size_t item_size = SimpleLRU::ItemSize(4, 4);
+    EXPECT_GT(item_size, 8);
+
+    SimpleLRU storage(2 * item_size);
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+}
+
+TEST(SimpleLRUTest, UpdateInPlaceAndRealloc) {
+    SimpleLRU storage(4096);
+
+    EXPECT_TRUE(storage.Put("KEY1", "long value"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+
+    // Shrink fits into the node, grow reallocates it, both must keep list and index consistent
+    EXPECT_TRUE(storage.Set("KEY1", "short"));
+    EXPECT_TRUE(storage.Set("KEY2", "much longer value"));
+    EXPECT_TRUE(storage.Set("KEY1", "x"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("x", value);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("much longer value", value);
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_TRUE(storage.Delete("KEY2"));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+}
+
+TEST(SimpleLRUTest, SegmentedPromoteOnSecondHit) {
+    const size_t item_size = SimpleLRU::ItemSize(4, 4);
+    SimpleLRU storage(4 * item_size, 0.5);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+    EXPECT_EQ(4 * item_size, storage.ProbationSize());
+    EXPECT_EQ(0, storage.ProtectedSize());
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ(2 * item_size, storage.ProbationSize());
+    EXPECT_EQ(2 * item_size, storage.ProtectedSize());
+
+    // Protected segment is full, KEY1 goes back to probation as its most recent item
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_EQ(2 * item_size, storage.ProtectedSize());
+
+    EXPECT_TRUE(storage.Put("KEY5", "val5"));
+    EXPECT_FALSE(storage.Get("KEY4", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_TRUE(storage.Get("KEY5", value));
+    EXPECT_EQ(4 * item_size, storage.ProbationSize() + storage.ProtectedSize());
+}
+
+TEST(SimpleLRUTest, SegmentedScanResistance) {
+    const size_t item_size = SimpleLRU::ItemSize(5, 3);
+    SimpleLRU storage(10 * item_size, 0.8);
+
+    std::string value;
+    for (int i = 0; i < 4; i++) {
+        std::string key = "HOT_" + std::to_string(i);
+        EXPECT_TRUE(storage.Put(key, "val"));
+        EXPECT_TRUE(storage.Get(key, value));
+    }
+
+    // Keys used once replace each other in probation segment only
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(storage.Put("SCAN" + std::to_string(i % 10), "val"));
+    }
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(storage.Get("HOT_" + std::to_string(i), value));
+    }
+    EXPECT_EQ(4 * item_size, storage.ProtectedSize());
+}
+
+TEST(SimpleLRUTest, SegmentedChurn) {
+    const size_t max_size = 4096;
+    SimpleLRU storage(max_size, 0.8);
+
+    std::string value;
+    for (int i = 0; i < 50000; i++) {
+        std::string key = "KEY" + std::to_string(i % 97);
+        switch (i % 5) {
+        case 0:
+            storage.Delete(key);
+            break;
+        case 1:
+        case 2:
+            storage.Get(key, value);
+            break;
+        default:
+            EXPECT_TRUE(storage.Put(key, std::string(i % 60, 'x')));
+        }
+
+        ASSERT_LE(storage.ProtectedSize(), max_size * 0.8);
+        ASSERT_LE(storage.ProbationSize() + storage.ProtectedSize(), max_size);
+    }
+}
+
+TEST(SimpleLRUTest, ExpireItems) {
+    const size_t item_size = SimpleLRU::ItemSize(8, 3);
+    SimpleLRU storage(100 * item_size);
+
+    for (int i = 0; i < 100; i++) {
+        std::string key = "Key " + std::to_string(i);
+        key.resize(8, ' ');
+        // Odd keys live one second, Put without ttl makes some of them unexpirable back
+        EXPECT_TRUE(storage.PutWithTTL(key, "val", i % 2));
+        if (i % 10 == 1) {
+            EXPECT_TRUE(storage.Put(key, "val"));
+        }
+    }
+    EXPECT_TRUE(storage.PutWithTTL("Ttl key ", "val", 1000));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("Key 1   ", value));
+    EXPECT_TRUE(storage.Get("Key 3   ", value));
+    EXPECT_EQ(1, storage.Evictions());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+
+    // Lazy expiry on access
+    EXPECT_FALSE(storage.Get("Key 3   ", value));
+    EXPECT_FALSE(storage.Set("Key 5   ", "new"));
+    EXPECT_TRUE(storage.PutIfAbsent("Key 7   ", "new"));
+    EXPECT_TRUE(storage.Get("Ttl key ", value));
+
+    // New items take memory of expired ones, live items are not evicted
+    for (int i = 0; i < 38; i++) {
+        std::string key = "New " + std::to_string(i);
+        key.resize(8, ' ');
+        EXPECT_TRUE(storage.Put(key, "val"));
+    }
+    EXPECT_EQ(1, storage.Evictions());
+    EXPECT_EQ(40, storage.Expirations());
+
+    for (int i = 0; i < 100; i++) {
+        std::string key = "Key " + std::to_string(i);
+        key.resize(8, ' ');
+        EXPECT_EQ(i != 0 && (i % 2 == 0 || i % 10 == 1 || i == 7), storage.Get(key, value)) << key;
+    }
+}
+
+TEST(SimpleLRUTest, CompareAndSet) {
+    SimpleLRU storage(1024);
+
+    std::string value;
+    uint64_t version = 42;
+    EXPECT_FALSE(storage.CompareAndSet("KEY1", "val", 0, version));
+    EXPECT_EQ(0, version);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    uint64_t first;
+    EXPECT_TRUE(storage.GetWithVersion("KEY1", value, first));
+    EXPECT_EQ("val1", value);
+    EXPECT_NE(0, first);
+
+    version = first;
+    EXPECT_TRUE(storage.CompareAndSet("KEY1", "val2", 0, version));
+    EXPECT_GT(version, first);
+    uint64_t second;
+    EXPECT_TRUE(storage.GetWithVersion("KEY1", value, second));
+    EXPECT_EQ("val2", value);
+    EXPECT_EQ(version, second);
+
+    // Stale version doesn't change anything
+    version = first;
+    EXPECT_FALSE(storage.CompareAndSet("KEY1", "val3", 0, version));
+    EXPECT_EQ(second, version);
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val2", value);
+
+    // Value too big for the storage
+    version = second;
+    EXPECT_FALSE(storage.CompareAndSet("KEY1", std::string(2048, 'x'), 0, version));
+    EXPECT_EQ(second, version);
+
+    // Key added back never gets old version
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_TRUE(storage.GetWithVersion("KEY1", value, version));
+    EXPECT_GT(version, second);
+}
+
+TEST(SimpleLRUTest, ViewOutlivesItem) {
+    const size_t item_size = SimpleLRU::ItemSize(4, 8);
+    SimpleLRU storage(4 * item_size);
+
+    EXPECT_TRUE(storage.Put("KEY1", "value 01"));
+    Afina::ValueView first, second;
+    EXPECT_TRUE(storage.GetView("KEY1", first));
+    EXPECT_EQ("value 01", first.str());
+
+    // Pinned item is not written in place
+    EXPECT_TRUE(storage.Put("KEY1", "value 02"));
+    EXPECT_EQ("value 01", first.str());
+    EXPECT_TRUE(storage.GetView("KEY1", second));
+    EXPECT_EQ("value 02", second.str());
+
+    // Neither delete nor eviction frees pinned memory
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Put("KEY" + std::to_string(i), "value " + std::to_string(10 + i)));
+    }
+    EXPECT_EQ("value 01", first.str());
+    EXPECT_EQ("value 02", second.str());
+
+    // Not pinned item is updated in place again
+    Afina::ValueView third;
+    EXPECT_TRUE(storage.GetView("KEY9", third));
+    const char *data = third.data();
+    third = Afina::ValueView();
+    EXPECT_TRUE(storage.Put("KEY9", "value 99"));
+    EXPECT_TRUE(storage.GetView("KEY9", third));
+    EXPECT_EQ(data, third.data());
+    EXPECT_EQ("value 99", third.str());
+}
+
+TEST(SimpleLRUTest, AppendPrepend) {
+    SimpleLRU storage(4096);
+
+    EXPECT_FALSE(storage.Append("KEY1", "data"));
+    EXPECT_FALSE(storage.Prepend("KEY1", "data"));
+
+    EXPECT_TRUE(storage.Put("KEY1", "b"));
+    Afina::ValueView pinned;
+    EXPECT_TRUE(storage.GetView("KEY1", pinned));
+    EXPECT_TRUE(storage.Prepend("KEY1", "a"));
+    EXPECT_TRUE(storage.Append("KEY1", "c"));
+    EXPECT_EQ("b", pinned.str());
+
+    std::string value;
+    uint64_t version;
+    EXPECT_TRUE(storage.GetWithVersion("KEY1", value, version));
+    EXPECT_EQ("abc", value);
+    EXPECT_TRUE(storage.Append("KEY1", "d"));
+    uint64_t stale = version;
+    EXPECT_FALSE(storage.CompareAndSet("KEY1", "", 0, stale));
+    EXPECT_NE(version, stale);
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("abcd", value);
+
+    // Too big for the storage, value stays as is
+    EXPECT_FALSE(storage.Append("KEY1", std::string(4096, 'x')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("abcd", value);
+}
+
+TEST(SimpleLRUTest, AppendGrowsWithSpareRoom) {
+    SimpleLRU storage(64 * 1024);
+    EXPECT_TRUE(storage.Put("LOG", ""));
+
+    // Node is reallocated a logarithmic number of times, not on each append
+    Afina::ValueView view;
+    const char *data = nullptr;
+    int reallocs = 0;
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage.Append("LOG", "line " + std::to_string(i % 10) + "\n"));
+        EXPECT_TRUE(storage.GetView("LOG", view));
+        if (view.data() != data) {
+            reallocs++;
+            data = view.data();
+        }
+        view = Afina::ValueView();
+    }
+    EXPECT_LT(reallocs, 25);
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("LOG", value));
+    EXPECT_EQ(7000, value.size());
+    EXPECT_EQ("line 0\nline 1\n", value.substr(0, 14));
+    EXPECT_EQ("line 9\n", value.substr(value.size() - 7));
+
+    // Prepend goes in place as well while there is room
+    EXPECT_TRUE(storage.Put("LOG", "tail"));
+    EXPECT_TRUE(storage.Append("LOG", std::string(100, 'x')));
+    EXPECT_TRUE(storage.GetView("LOG", view));
+    data = view.data();
+    view = Afina::ValueView();
+    EXPECT_TRUE(storage.Prepend("LOG", "head "));
+    EXPECT_TRUE(storage.GetView("LOG", view));
+    EXPECT_EQ(data, view.data());
+    EXPECT_EQ("head tail" + std::string(100, 'x'), view.str());
+}
+
+TEST(SimpleLRUTest, IncrementDecrement) {
+    SimpleLRU storage(4096);
+    uint64_t number;
+
+    EXPECT_FALSE(storage.Increment("KEY1", 1, number));
+    EXPECT_TRUE(storage.Put("KEY1", "text"));
+    EXPECT_THROW(storage.Increment("KEY1", 1, number), std::invalid_argument);
+    EXPECT_TRUE(storage.Put("KEY1", "18446744073709551616"));
+    EXPECT_THROW(storage.Decrement("KEY1", 1, number), std::invalid_argument);
+
+    // Same number of digits is written in place
+    EXPECT_TRUE(storage.Put("KEY1", "10"));
+    Afina::ValueView view;
+    EXPECT_TRUE(storage.GetView("KEY1", view));
+    const char *data = view.data();
+    view = Afina::ValueView();
+    EXPECT_TRUE(storage.Increment("KEY1", 5, number));
+    EXPECT_EQ(15, number);
+    EXPECT_TRUE(storage.Decrement("KEY1", 3, number));
+    EXPECT_EQ(12, number);
+    EXPECT_TRUE(storage.GetView("KEY1", view));
+    EXPECT_EQ(data, view.data());
+    EXPECT_EQ("12", view.str());
+
+    // Longer number doesn't fit, pinned value is not changed
+    EXPECT_TRUE(storage.Increment("KEY1", 88, number));
+    EXPECT_EQ(100, number);
+    EXPECT_EQ("12", view.str());
+
+    std::string value;
+    EXPECT_TRUE(storage.Decrement("KEY1", 1000, number));
+    EXPECT_EQ(0, number);
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("0", value);
+
+    EXPECT_TRUE(storage.Put("KEY1", "18446744073709551615"));
+    EXPECT_TRUE(storage.Increment("KEY1", 2, number));
+    EXPECT_EQ(1, number);
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("1", value);
+}
@@ -0,0 +1,201 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "storage/HashLRU.h"
+#include "storage/SimpleLRU.h"
+#include "storage/Snapshot.h"
+#include "storage/StripedLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+namespace {
+
+std::string snapshot_path(const std::string &name) {
+    return "/tmp/afina_snapshot_" + std::to_string(getpid()) + "_" + name;
+}
+
+// All the parts of the storage dump
+bool dump(Afina::Storage &storage, std::vector<std::vector<Afina::StoredItem>> &parts) {
+    return storage.Dump([&parts](std::vector<Afina::StoredItem> &part) { parts.push_back(std::move(part)); });
+}
+
+// Keys of the storage from the least to the most recently used
+std::vector<std::string> keys_of(Afina::Storage &storage) {
+    std::vector<std::vector<Afina::StoredItem>> parts;
+    EXPECT_TRUE(dump(storage, parts));
+    std::vector<std::string> keys;
+    for (auto &part : parts) {
+        for (auto &item : part) {
+            keys.push_back(item.key.str());
+        }
+    }
+    return keys;
+}
+
+} // namespace
+
+TEST(SnapshotTest, RestoreOrderAndTTL) {
+    const std::string path = snapshot_path("order");
+    auto storage = std::make_shared<SimpleLRU>(64 * 1024);
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(storage->PutWithTTL("Key " + std::to_string(i), "Value " + std::to_string(i), i % 2 * 3600));
+    }
+    std::string value;
+    for (int i = 0; i < 100; i += 10) {
+        ASSERT_TRUE(storage->Get("Key " + std::to_string(i), value));
+    }
+    EXPECT_EQ(100, Snapshot(storage, path).Save());
+
+    auto restored = std::make_shared<SimpleLRU>(64 * 1024);
+    EXPECT_EQ(100, Snapshot(restored, path).Load());
+    EXPECT_EQ(keys_of(*storage), keys_of(*restored));
+
+    std::vector<std::vector<Afina::StoredItem>> parts;
+    ASSERT_TRUE(dump(*restored, parts));
+    for (auto &item : parts[0]) {
+        int i = std::stoi(item.key.str().substr(4));
+        EXPECT_EQ("Value " + std::to_string(i), item.value.str());
+        if (i % 2 == 0) {
+            EXPECT_EQ(0, item.ttl);
+        } else {
+            EXPECT_GE(item.ttl, 3598);
+            EXPECT_LE(item.ttl, 3600);
+        }
+    }
+
+    // Smaller storage keeps the most recently used items
+    auto small = std::make_shared<SimpleLRU>(10 * SimpleLRU::ItemSize(6, 8));
+    EXPECT_EQ(100, Snapshot(small, path).Load());
+    for (int i = 0; i < 100; i += 10) {
+        EXPECT_TRUE(small->Get("Key " + std::to_string(i), value));
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, ParallelLoad) {
+    const std::string path = snapshot_path("parallel");
+    auto storage = std::make_shared<StripedLRU>(8, 8 * 1024 * 1024);
+    for (int i = 0; i < 20000; i++) {
+        ASSERT_TRUE(storage->Put("Key " + std::to_string(i), std::string(i % 300, 'a' + i % 26)));
+    }
+    EXPECT_EQ(20000, Snapshot(storage, path).Save());
+
+    auto restored = std::make_shared<StripedLRU>(4, 8 * 1024 * 1024);
+    EXPECT_EQ(20000, Snapshot(restored, path).Load(4));
+
+    std::string value;
+    for (int i = 0; i < 20000; i++) {
+        ASSERT_TRUE(restored->Get("Key " + std::to_string(i), value));
+        EXPECT_EQ(std::string(i % 300, 'a' + i % 26), value);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, BrokenFile) {
+    const std::string path = snapshot_path("broken");
+    auto storage = std::make_shared<SimpleLRU>(1024 * 1024);
+    EXPECT_EQ(0, Snapshot(storage, path).Load());
+
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(storage->Put("Key " + std::to_string(i), "Value " + std::to_string(i)));
+    }
+    Snapshot(storage, path).Save();
+
+    std::string contents;
+    {
+        std::ifstream in(path, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Damaged byte is caught by the block checksum
+    std::string damaged = contents;
+    damaged[damaged.size() / 2] ^= 1;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << damaged;
+    EXPECT_THROW(Snapshot(std::make_shared<SimpleLRU>(1024 * 1024), path).Load(), std::runtime_error);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << contents.substr(0, contents.size() - 100);
+    EXPECT_THROW(Snapshot(std::make_shared<SimpleLRU>(1024 * 1024), path).Load(), std::runtime_error);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a snapshot at all";
+    EXPECT_THROW(Snapshot(std::make_shared<SimpleLRU>(1024 * 1024), path).Load(), std::runtime_error);
+
+    // Storage without Dump can't be saved, file stays as it is
+    EXPECT_THROW(Snapshot(std::make_shared<HashLRU>(), path).Save(), std::runtime_error);
+    EXPECT_NE(0, access((path + ".tmp").c_str(), F_OK));
+
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, FailedRename) {
+    // Written file can't replace the directory with something in it
+    const std::string path = snapshot_path("directory");
+    const std::string inner = path + "/file";
+    ASSERT_EQ(0, mkdir(path.c_str(), 0755));
+    std::ofstream(inner) << "keeps directory non empty";
+
+    auto storage = std::make_shared<SimpleLRU>(1024 * 1024);
+    ASSERT_TRUE(storage->Put("Key", "Value"));
+    EXPECT_THROW(Snapshot(storage, path).Save(), std::runtime_error);
+    EXPECT_NE(0, access((path + ".tmp").c_str(), F_OK));
+
+    std::remove(inner.c_str());
+    rmdir(path.c_str());
+}
+
+TEST(SnapshotTest, SaveWhileWriting) {
+    const std::string path = snapshot_path("background");
+    auto storage = std::make_shared<StripedLRU>(4, 1024 * 1024);
+
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; t++) {
+        writers.emplace_back([&storage, &stop, t]() {
+            for (int i = 0; !stop; i++) {
+                storage->Put("Key " + std::to_string(i % 2000), std::string(100, 'a' + (i + t) % 26));
+            }
+        });
+    }
+
+    Snapshot snapshot(storage, path);
+    std::atomic<int> saves(0);
+    snapshot.Start(1, [&saves](std::size_t items, const std::string &error) {
+        EXPECT_TRUE(error.empty());
+        saves++;
+    });
+    for (int i = 0; i < 3; i++) {
+        snapshot.Save();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    snapshot.Stop();
+    stop = true;
+    for (auto &t : writers) {
+        t.join();
+    }
+    EXPECT_GE(saves, 1);
+
+    // Each value is whole: it was copied at a single moment
+    auto restored = std::make_shared<StripedLRU>(4, 1024 * 1024);
+    EXPECT_GT(Snapshot(restored, path).Load(2), 0);
+    std::vector<std::vector<Afina::StoredItem>> parts;
+    ASSERT_TRUE(dump(*restored, parts));
+    EXPECT_EQ(4, parts.size());
+    for (auto &part : parts) {
+        for (auto &item : part) {
+            std::string value = item.value.str();
+            EXPECT_EQ(std::string(100, value[0]), value);
+        }
+    }
+
+    std::remove(path.c_str());
+}
@@ -1,197 +1,370 @@
 #include "gtest/gtest.h"
-#include <iomanip>
-#include <iostream>
-#include <set>
-#include <vector>
-
-#include <afina/execute/Add.h>
-#include <afina/execute/Append.h>
-#include <afina/execute/Delete.h>
-#include <afina/execute/Get.h>
-#include <afina/execute/Set.h>
-
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <unistd.h>
+
+#include "storage/ArenaLRU.h"
+#include "storage/ClockLRU.h"
+#include "storage/HashLRU.h"
+#include "storage/MappedLRU.h"
+#include "storage/PolicyStorage.h"
+#include "storage/RcuLRU.h"
+#include "storage/SampledLRU.h"
 #include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
+#include "storage/TinyLFU.h"
+
+#include "Workload.h"
 
 using namespace Afina::Backend;
-using namespace Afina::Execute;
+using namespace Afina::Test;
 using namespace std;
 
+namespace {
 
+// Each factory makes the storage with room for exactly the given number of items of the given size
 
+// Storage that counts its own overhead too, see T::ItemSize
+template <typename T> struct ItemSizeFactory {
+    std::unique_ptr<Afina::Storage> Make(size_t items, size_t key_size, size_t value_size) {
+        return std::unique_ptr<Afina::Storage>(new T(items * T::ItemSize(key_size, value_size)));
+    }
+};
+
+// File of the storage is removed once the test is over
+struct MappedLRUFactory {
+    MappedLRUFactory() : path("/tmp/afina_storage_" + std::to_string(getpid())) {}
+    ~MappedLRUFactory() { std::remove(path.c_str()); }
 
-TEST(StorageTest, PutGet) {
-    SimpleLRU storage;
+    std::unique_ptr<Afina::Storage> Make(size_t items, size_t key_size, size_t value_size) {
+        return std::unique_ptr<Afina::Storage>(new MappedLRU(path, items * MappedLRU::ItemSize(key_size, value_size)));
+    }
 
-    EXPECT_TRUE(storage.Put("KEY1", "val1"));
-    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    const std::string path;
+};
+
+// Storage that counts key and value bytes only
+template <typename T> struct ByteSizeFactory {
+    std::unique_ptr<Afina::Storage> Make(size_t items, size_t key_size, size_t value_size) {
+        return std::unique_ptr<Afina::Storage>(new T(items * (key_size + value_size)));
+    }
+};
+
+// Shards count their items as SimpleLRU does, small storage ends up with fewer of them
+struct StripedLRUFactory {
+    std::unique_ptr<Afina::Storage> Make(size_t items, size_t key_size, size_t value_size) {
+        return std::unique_ptr<Afina::Storage>(new StripedLRU(4, items * SimpleLRU::ItemSize(key_size, value_size)));
+    }
+};
+
+template <typename T> struct ItemCountFactory {
+    std::unique_ptr<Afina::Storage> Make(size_t items, size_t key_size, size_t value_size) {
+        return std::unique_ptr<Afina::Storage>(new T(items));
+    }
+};
+
+// Storage budget is measured in bytes, so an item could be too big for it
+template <typename Factory> struct CountsBytes : std::true_type {};
+template <typename T> struct CountsBytes<ItemCountFactory<T>> : std::false_type {};
+
+template <typename Factory> class StorageTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Afina::Storage> make(size_t items, size_t key_size, size_t value_size) {
+        return _factory.Make(items, key_size, value_size);
+    }
+
+    // Room for a few small items, nothing is evicted
+    std::unique_ptr<Afina::Storage> make() { return make(16, 4, 8); }
+
+private:
+    Factory _factory;
+};
+
+// Basic contract holds for every storage, whatever it evicts
+typedef ::testing::Types<
+    ItemSizeFactory<SimpleLRU>, MappedLRUFactory, ByteSizeFactory<HashLRU>, ItemSizeFactory<ArenaLRU>,
+    ByteSizeFactory<RcuLRU>, ByteSizeFactory<ClockLRU>, ByteSizeFactory<TinyLFU>, StripedLRUFactory,
+    ItemSizeFactory<SampledLRU>,
+    ByteSizeFactory<PolicyStorage<Policy::OrderedIndex, Policy::LruEviction, Policy::NoLock, Policy::ByteSize>>,
+    ByteSizeFactory<PolicyStorage<Policy::HashIndex, Policy::LruEviction, Policy::MutexLock, Policy::ByteSize>>,
+    ByteSizeFactory<PolicyStorage<Policy::HashIndex, Policy::FifoEviction, Policy::NoLock, Policy::ByteSize>>,
+    ByteSizeFactory<PolicyStorage<Policy::OrderedIndex, Policy::ClockEviction, Policy::MutexLock, Policy::ByteSize>>,
+    ItemCountFactory<PolicyStorage<Policy::HashIndex, Policy::ClockEviction, Policy::NoLock, Policy::ItemCount>>>
+    Storages;
+TYPED_TEST_CASE(StorageTest, Storages);
+
+template <typename Factory> class LruStorageTest : public StorageTest<Factory> {};
+
+// Storages that keep exactly as many items as there is room for and evict the least recently added item
+// first if it wasn't used since, every policy appears at least once
+typedef ::testing::Types<
+    ItemSizeFactory<SimpleLRU>, MappedLRUFactory, ByteSizeFactory<HashLRU>, ItemSizeFactory<ArenaLRU>,
+    ByteSizeFactory<RcuLRU>, ByteSizeFactory<ClockLRU>,
+    ByteSizeFactory<PolicyStorage<Policy::OrderedIndex, Policy::LruEviction, Policy::NoLock, Policy::ByteSize>>,
+    ByteSizeFactory<PolicyStorage<Policy::HashIndex, Policy::LruEviction, Policy::MutexLock, Policy::ByteSize>>,
+    ByteSizeFactory<PolicyStorage<Policy::HashIndex, Policy::FifoEviction, Policy::NoLock, Policy::ByteSize>>,
+    ByteSizeFactory<PolicyStorage<Policy::OrderedIndex, Policy::ClockEviction, Policy::MutexLock, Policy::ByteSize>>,
+    ItemCountFactory<PolicyStorage<Policy::HashIndex, Policy::ClockEviction, Policy::NoLock, Policy::ItemCount>>>
+    LruStorages;
+TYPED_TEST_CASE(LruStorageTest, LruStorages);
+
+} // namespace
+
+TYPED_TEST(StorageTest, PutGet) {
+    auto storage = this->make();
+
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+    EXPECT_TRUE(storage->Put("KEY2", "val2"));
 
     std::string value;
-    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage->Get("KEY1", value));
     EXPECT_TRUE(value == "val1");
 
-    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage->Get("KEY2", value));
     EXPECT_TRUE(value == "val2");
 }
 
-TEST(StorageTest, PutOverwrite) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutOverwrite) {
+    auto storage = this->make();
 
-    EXPECT_TRUE(storage.Put("KEY1", "val1"));
-    EXPECT_TRUE(storage.Put("KEY1", "val2"));
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+    EXPECT_TRUE(storage->Put("KEY1", "val2"));
 
     std::string value;
-    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage->Get("KEY1", value));
     EXPECT_TRUE(value == "val2");
 }
 
-TEST(StorageTest, PutIfAbsent) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutIfAbsent) {
+    auto storage = this->make();
 
-    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val1"));
+    EXPECT_TRUE(storage->PutIfAbsent("KEY1", "val1"));
 
-    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_FALSE(storage->PutIfAbsent("KEY1", "val2"));
 
     std::string value;
-    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage->Get("KEY1", value));
     EXPECT_TRUE(value == "val1");
 }
 
-TEST(StorageTest, PutSetGet) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutSetGet) {
+    auto storage = this->make();
 
-    EXPECT_TRUE(storage.Put("KEY1", "val1"));
-    EXPECT_TRUE(storage.Set("KEY1", "val2"));
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+    EXPECT_TRUE(storage->Set("KEY1", "val2"));
 
-    EXPECT_FALSE(storage.Set("KEY2", "val2"));
+    EXPECT_FALSE(storage->Set("KEY2", "val2"));
 
     std::string value;
-    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage->Get("KEY1", value));
     EXPECT_TRUE(value == "val2");
 }
 
-TEST(StorageTest, SetIfAbsent) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, SetIfAbsent) {
+    auto storage = this->make();
 
-    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
 
     std::string value;
-    EXPECT_FALSE(storage.Set("KEY2", "val2"));
-    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage->Set("KEY2", "val2"));
+    EXPECT_TRUE(storage->Get("KEY1", value));
     EXPECT_TRUE(value == "val1");
 }
 
-TEST(StorageTest, PutDeleteGet) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutDeleteGet) {
+    auto storage = this->make();
 
-    EXPECT_TRUE(storage.Put("KEY1", "val1"));
-    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+    EXPECT_TRUE(storage->Put("KEY2", "val2"));
 
-    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_TRUE(storage->Delete("KEY1"));
 
     std::string value;
-    EXPECT_FALSE(storage.Get("KEY1", value));
-    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_FALSE(storage->Get("KEY1", value));
+    EXPECT_TRUE(storage->Get("KEY2", value));
     EXPECT_TRUE(value == "val2");
 }
 
+TYPED_TEST(StorageTest, GetIfAbsent) {
+    auto storage = this->make();
 
-TEST(StorageTest, GetIfAbsent)
-{
-    SimpleLRU storage;
+    std::string value;
+    EXPECT_FALSE(storage->Get("KEY1", value));
 
+    EXPECT_FALSE(storage->Get("KEY2", value));
 
-    std::string value;
-    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage->Get("KEY3", value));
+}
+
+TYPED_TEST(StorageTest, DeleteIfAbsent) {
+    auto storage = this->make();
+    EXPECT_FALSE(storage->Delete("KEY1"));
+
+    EXPECT_FALSE(storage->Delete("KEY2"));
 
-    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_FALSE(storage->Delete("KEY3"));
+}
+
+TYPED_TEST(StorageTest, ValueSizeChanges) {
+    auto storage = this->make();
+
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+    EXPECT_TRUE(storage->Put("KEY2", "val2"));
 
-    EXPECT_FALSE(storage.Get("KEY3", value));
+    std::string value;
+    EXPECT_TRUE(storage->Set("KEY1", "a longer value"));
+    EXPECT_TRUE(storage->Get("KEY1", value));
+    EXPECT_EQ("a longer value", value);
+    EXPECT_TRUE(storage->Put("KEY1", ""));
+    EXPECT_TRUE(storage->Get("KEY1", value));
+    EXPECT_EQ("", value);
+
+    // Deleted key could be added again
+    EXPECT_TRUE(storage->Delete("KEY2"));
+    EXPECT_FALSE(storage->Delete("KEY2"));
+    EXPECT_TRUE(storage->PutIfAbsent("KEY2", "val22"));
+    EXPECT_TRUE(storage->Get("KEY2", value));
+    EXPECT_EQ("val22", value);
 }
 
-TEST(StorageTest, DeleteIfAbsent)
-{
-    SimpleLRU storage;
-    EXPECT_FALSE(storage.Delete("KEY1"));
+TYPED_TEST(StorageTest, TooBigElement) {
+    if (!CountsBytes<TypeParam>::value) {
+        return;
+    }
+    auto storage = this->make();
+    const std::string big(64 * 1024, 'x');
 
-    EXPECT_FALSE(storage.Delete("KEY2"));
+    // Nothing is evicted for the item which can't fit anyway
+    EXPECT_FALSE(storage->Put("KEY", big));
+    EXPECT_TRUE(storage->Put("KEY", "val"));
+    EXPECT_FALSE(storage->Set("KEY", big));
+    EXPECT_FALSE(storage->PutIfAbsent("KEY2", big));
 
-    EXPECT_FALSE(storage.Delete("KEY3"));
+    std::string value;
+    EXPECT_TRUE(storage->Get("KEY", value));
+    EXPECT_EQ("val", value);
 }
 
-TEST(StorageTest, DeleteHeadAndTailNode)
-{
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, ManyKeys) {
+    auto storage = this->make(2000, 8, 8);
 
-    EXPECT_TRUE(storage.Put("KEY1", "val1"));
-    EXPECT_TRUE(storage.Put("KEY2", "val2"));
-    EXPECT_TRUE(storage.Put("KEY3", "val3"));
-    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage->Put("KEY" + std::to_string(i), "val" + std::to_string(i)));
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        EXPECT_TRUE(storage->Set("KEY" + std::to_string(i), "new" + std::to_string(i)));
+        EXPECT_FALSE(storage->PutIfAbsent("KEY" + std::to_string(i), "val"));
+    }
+    for (int i = 0; i < 1000; i += 3) {
+        EXPECT_TRUE(storage->Delete("KEY" + std::to_string(i)));
+    }
 
+    std::string value;
+    for (int i = 0; i < 1000; i++) {
+        std::string key = "KEY" + std::to_string(i);
+        if (i % 3 == 0) {
+            EXPECT_FALSE(storage->Get(key, value));
+        } else {
+            EXPECT_TRUE(storage->Get(key, value));
+            EXPECT_EQ((i % 2 == 0 ? "new" : "val") + std::to_string(i), value);
+        }
+    }
+}
+
+TYPED_TEST(StorageTest, DeleteHeadAndTailNode) {
+    auto storage = this->make();
+
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+    EXPECT_TRUE(storage->Put("KEY2", "val2"));
+    EXPECT_TRUE(storage->Put("KEY3", "val3"));
+    EXPECT_TRUE(storage->Put("KEY4", "val4"));
 
-    EXPECT_TRUE(storage.Set("KEY2", "val22"));
-    EXPECT_TRUE(storage.Set("KEY3", "val23"));
-    EXPECT_TRUE(storage.Set("KEY1", "val21"));
-    EXPECT_TRUE(storage.Set("KEY1", "val31"));
-    EXPECT_TRUE(storage.Set("KEY1", "val41"));
+    EXPECT_TRUE(storage->Set("KEY2", "val22"));
+    EXPECT_TRUE(storage->Set("KEY3", "val23"));
+    EXPECT_TRUE(storage->Set("KEY1", "val21"));
+    EXPECT_TRUE(storage->Set("KEY1", "val31"));
+    EXPECT_TRUE(storage->Set("KEY1", "val41"));
     // After that, KEY1 should be first in the rating.
     // And KEY4 should be the last.
-    EXPECT_TRUE(storage.Delete("KEY4"));
-    EXPECT_TRUE(storage.Delete("KEY1"));
-}
-
-std::string pad_space(const std::string &s, size_t length) {
-    std::string result = s;
-    result.resize(length, ' ');
-    return result;
+    EXPECT_TRUE(storage->Delete("KEY4"));
+    EXPECT_TRUE(storage->Delete("KEY1"));
 }
 
-TEST(StorageTest, BigTest) {
+TYPED_TEST(LruStorageTest, BigTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 100000 * length);
+    auto storage = this->make(100000, length, length);
 
     for (long i = 0; i < 100000; ++i) {
-        auto key = pad_space("Key " + std::to_string(i), length);
-        auto val = pad_space("Val " + std::to_string(i), length);
-        EXPECT_TRUE(storage.Put(key, val));
+        auto key = PadSpace("Key " + std::to_string(i), length);
+        auto val = PadSpace("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage->Put(key, val));
     }
 
     for (long i = 99999; i >= 0; --i) {
-        auto key = pad_space("Key " + std::to_string(i), length);
-        auto val = pad_space("Val " + std::to_string(i), length);
+        auto key = PadSpace("Key " + std::to_string(i), length);
+        auto val = PadSpace("Val " + std::to_string(i), length);
 
         std::string res;
-        EXPECT_TRUE(storage.Get(key, res));
+        EXPECT_TRUE(storage->Get(key, res));
 
         EXPECT_TRUE(val == res);
     }
 }
 
-TEST(StorageTest, MaxTest) {
+TYPED_TEST(LruStorageTest, MaxTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 1000 * length);
-
-    std::stringstream ss;
+    auto storage = this->make(1000, length, length);
 
     for (long i = 0; i < 1100; ++i) {
-        auto key = pad_space("Key " + std::to_string(i), length);
-        auto val = pad_space("Val " + std::to_string(i), length);
-        EXPECT_TRUE(storage.Put(key, val));
+        auto key = PadSpace("Key " + std::to_string(i), length);
+        auto val = PadSpace("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage->Put(key, val));
     }
 
     for (long i = 100; i < 1100; ++i) {
-        auto key = pad_space("Key " + std::to_string(i), length);
-        auto val = pad_space("Val " + std::to_string(i), length);
+        auto key = PadSpace("Key " + std::to_string(i), length);
+        auto val = PadSpace("Val " + std::to_string(i), length);
 
         std::string res;
-        EXPECT_TRUE(storage.Get(key, res));
+        EXPECT_TRUE(storage->Get(key, res));
 
         EXPECT_TRUE(val == res);
     }
 
     for (long i = 0; i < 100; ++i) {
-        auto key = pad_space("Key " + std::to_string(i), length);
+        auto key = PadSpace("Key " + std::to_string(i), length);
 
         std::string res;
-        EXPECT_FALSE(storage.Get(key, res));
+        EXPECT_FALSE(storage->Get(key, res));
+    }
+}
+
+TYPED_TEST(StorageTest, BytesCounted) {
+    auto storage = this->make();
+    auto counters = std::make_shared<Afina::StorageCounters>();
+    storage->SetCounters(counters);
+
+    // Items take at least their key and value bytes, overhead depends on the storage
+    EXPECT_TRUE(storage->Put("KEY1", "val1"));
+    EXPECT_TRUE(storage->Put("KEY2", "val2"));
+    int64_t bytes = counters->Total(Afina::StorageCounters::kBytes);
+    EXPECT_LE(16, bytes);
+    EXPECT_TRUE(storage->Set("KEY1", "value1"));
+    EXPECT_LE(bytes, counters->Total(Afina::StorageCounters::kBytes));
+
+    // Evicted and deleted items give their bytes back
+    for (int i = 0; i < 40; i++) {
+        EXPECT_TRUE(storage->Put("K" + std::to_string(100 + i), "value"));
+    }
+    EXPECT_LT(0, counters->Total(Afina::StorageCounters::kEvictions));
+    storage->Delete("KEY1");
+    storage->Delete("KEY2");
+    for (int i = 0; i < 40; i++) {
+        storage->Delete("K" + std::to_string(100 + i));
     }
+    EXPECT_EQ(0, counters->Total(Afina::StorageCounters::kBytes));
+    EXPECT_EQ(0, counters->Total(Afina::StorageCounters::kItems));
 }
@@ -0,0 +1,257 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/Hash.h"
+#include "storage/StripedLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(WyHashTest, SeedAndLength) {
+    std::string key = "some key of medium length, longer than 48 bytes to go through all the rounds";
+    for (size_t len = 0; len <= key.size(); len++) {
+        EXPECT_EQ(WyHash(key.data(), len, 1), WyHash(key.data(), len, 1));
+        EXPECT_NE(WyHash(key.data(), len, 1), WyHash(key.data(), len, 2));
+        if (len > 0) {
+            EXPECT_NE(WyHash(key.data(), len, 1), WyHash(key.data(), len - 1, 1));
+        }
+    }
+}
+
+TEST(WyHashTest, LowBitsSpread) {
+    // Similar keys must be spread evenly over buckets chosen by the mask
+    const size_t buckets = 16;
+    std::vector<size_t> counts(buckets, 0);
+    for (int i = 0; i < 160000; i++) {
+        counts[WyHash("Key " + std::to_string(i), 42) & (buckets - 1)]++;
+    }
+    for (size_t c : counts) {
+        EXPECT_GT(c, 9000);
+        EXPECT_LT(c, 11000);
+    }
+}
+
+TEST(StripedLRUTest, ShardsNumber) {
+    EXPECT_EQ(4, StripedLRU(3, 8 * 1024 * 1024).ShardsNumber());
+    EXPECT_EQ(16, StripedLRU(16, 8 * 1024 * 1024).ShardsNumber());
+
+    // Small storage gets fewer shards instead of failing
+    EXPECT_EQ(2, StripedLRU(16, 2 * StripedLRU::kMinShardSize).ShardsNumber());
+    EXPECT_EQ(1, StripedLRU(16, 1024).ShardsNumber());
+
+    size_t automatic = StripedLRU(0, 1024 * 1024 * 1024).ShardsNumber();
+    EXPECT_GE(automatic, 1);
+    EXPECT_EQ(0, automatic & (automatic - 1));
+}
+
+TEST(StripedLRUTest, ConcurrentAccess) {
+    StripedLRU storage(4, 4 * 1024 * 1024);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, t]() {
+            std::string value;
+            for (int i = 0; i < 20000; i++) {
+                std::string key = "T" + std::to_string(t) + "_" + std::to_string(i / 2 % 500);
+                if (i % 2 == 0) {
+                    storage.Put(key, std::to_string(i));
+                } else {
+                    EXPECT_TRUE(storage.Get(key, value));
+                    EXPECT_EQ(std::to_string(i - 1), value);
+                }
+            }
+        });
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+}
+
+TEST(StripedLRUTest, RebalanceToBusyShard) {
+    const size_t budget = 4 * 256 * 1024;
+    StripedLRU storage(4, budget);
+    ASSERT_EQ(4, storage.ShardsNumber());
+
+    // Working set of the first shard is twice its share but fits into the whole budget
+    const std::string value(1000, 'v');
+    std::vector<std::string> keys;
+    for (int i = 0; keys.size() < 512; i++) {
+        std::string key = "Key " + std::to_string(i);
+        if (storage.ShardOf(key) == 0) {
+            keys.push_back(key);
+        }
+    }
+
+    // Memory is moved by small parts, no request shrinks the donor much
+    const size_t chunk = budget / 4 / 16 / 16;
+    std::string out;
+    size_t hits = 0;
+    for (int round = 0; round < 100; round++) {
+        for (auto &key : keys) {
+            size_t before = storage.ShardCapacity(0);
+            if (storage.Get(key, out)) {
+                hits++;
+            } else {
+                ASSERT_LE(storage.ShardCapacity(0), before + chunk);
+                before = storage.ShardCapacity(0);
+                storage.Put(key, value);
+            }
+            ASSERT_LE(storage.ShardCapacity(0), before + chunk);
+        }
+    }
+
+    EXPECT_GT(storage.ShardCapacity(0), 2 * budget / 4);
+    EXPECT_GT(hits, 0);
+
+    size_t total = 0;
+    for (size_t i = 0; i < storage.ShardsNumber(); i++) {
+        total += storage.ShardCapacity(i);
+        EXPECT_GE(storage.ShardCapacity(i), budget / 4 / 4);
+    }
+    EXPECT_EQ(budget, total);
+}
+
+TEST(StripedLRUTest, ConcurrentCompareAndSet) {
+    StripedLRU storage(4, 4 * 1024 * 1024);
+    const int counters = 3, increments = 2000;
+    for (int c = 0; c < counters; c++) {
+        ASSERT_TRUE(storage.Put("Counter " + std::to_string(c), "0"));
+    }
+
+    // Read-modify-write without any lock but cas
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, counters, increments]() {
+            std::string value;
+            uint64_t version;
+            for (int i = 0; i < increments; i++) {
+                std::string key = "Counter " + std::to_string(i % counters);
+                do {
+                    ASSERT_TRUE(storage.GetWithVersion(key, value, version));
+                } while (!storage.CompareAndSet(key, std::to_string(std::stoi(value) + 1), 0, version));
+            }
+        });
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+
+    std::string value;
+    int total = 0;
+    for (int c = 0; c < counters; c++) {
+        ASSERT_TRUE(storage.Get("Counter " + std::to_string(c), value));
+        total += std::stoi(value);
+    }
+    EXPECT_EQ(4 * increments, total);
+}
+
+TEST(StripedLRUTest, ConcurrentViews) {
+    StripedLRU storage(2, 256 * 1024);
+
+    // Writers overwrite and evict values while readers still look at them
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, t]() {
+            Afina::ValueView view;
+            for (int i = 0; i < 20000; i++) {
+                std::string key = "Key " + std::to_string(i % 3000);
+                if (t % 2 == 0) {
+                    storage.Put(key, std::string(64, 'a' + i % 26));
+                } else if (storage.GetView(key, view)) {
+                    std::string value = view.str();
+                    EXPECT_EQ(std::string(64, value[0]), value);
+                }
+            }
+        });
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+}
+
+TEST(StripedLRUTest, MultiGet) {
+    StripedLRU storage(8, 8 * 1024 * 1024);
+    for (int i = 0; i < 1000; i += 2) {
+        ASSERT_TRUE(storage.Put("Key " + std::to_string(i), "Value " + std::to_string(i)));
+    }
+
+    // Keys of all the shards mixed, with repeats and misses
+    std::vector<std::string> keys;
+    for (int i = 0; i < 300; i++) {
+        keys.push_back("Key " + std::to_string(i * 7 % 1000));
+    }
+    keys.push_back(keys.front());
+
+    std::vector<Afina::ValueView> values;
+    EXPECT_EQ(151, storage.MultiGet(keys, values));
+    ASSERT_EQ(keys.size(), values.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        int n = std::stoi(keys[i].substr(4));
+        if (n % 2 == 0) {
+            ASSERT_TRUE(values[i].valid());
+            EXPECT_EQ("Value " + std::to_string(n), values[i].str());
+        } else {
+            EXPECT_FALSE(values[i].valid());
+        }
+    }
+
+    EXPECT_EQ(0, storage.MultiGet(std::vector<std::string>(), values));
+    EXPECT_TRUE(values.empty());
+}
+
+TEST(StripedLRUTest, ConcurrentAppend) {
+    StripedLRU storage(4, 4 * 1024 * 1024);
+    ASSERT_TRUE(storage.Put("Log", ""));
+
+    // No append is lost, each record stays whole
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, t]() {
+            for (int i = 0; i < 2000; i++) {
+                if (i % 2 == 0) {
+                    EXPECT_TRUE(storage.Append("Log", std::string(4, 'a' + t)));
+                } else {
+                    EXPECT_TRUE(storage.Prepend("Log", std::string(4, 'A' + t)));
+                }
+            }
+        });
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+
+    std::string value;
+    ASSERT_TRUE(storage.Get("Log", value));
+    ASSERT_EQ(4 * 2000 * 4, value.size());
+    for (size_t i = 0; i < value.size(); i += 4) {
+        EXPECT_EQ(std::string(4, value[i]), value.substr(i, 4));
+    }
+}
+
+TEST(StripedLRUTest, ConcurrentIncrement) {
+    StripedLRU storage(4, 4 * 1024 * 1024);
+    ASSERT_TRUE(storage.Put("Counter", "5000"));
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, t]() {
+            uint64_t number;
+            for (int i = 0; i < 5000; i++) {
+                if (t % 2 == 0) {
+                    EXPECT_TRUE(storage.Increment("Counter", 3, number));
+                } else {
+                    EXPECT_TRUE(storage.Decrement("Counter", 1, number));
+                }
+            }
+        });
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+
+    std::string value;
+    ASSERT_TRUE(storage.Get("Counter", value));
+    EXPECT_EQ(std::to_string(5000 + 2 * 5000 * 3 - 2 * 5000), value);
+}
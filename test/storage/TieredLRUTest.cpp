@@ -0,0 +1,207 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "storage/TieredLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+namespace {
+
+// Directory of the file tier, removed once the test is over
+struct temp_dir {
+    explicit temp_dir(const std::string &name) : path("/tmp/afina_tier_" + std::to_string(getpid()) + "_" + name) {}
+    ~temp_dir() { rmdir(path.c_str()); }
+
+    const std::string path;
+};
+
+std::string value_of(long i) { return std::string(100 + i % 50, 'a' + i % 26); }
+
+// Puts the item and waits for the disk now and then, evicted items are dropped once it falls behind
+void put(TieredLRU &storage, const std::string &key, long i) {
+    EXPECT_TRUE(storage.Put(key, value_of(i)));
+    if (i % 256 == 255) {
+        storage.File().Flush();
+    }
+}
+
+} // namespace
+
+TEST(TieredLRUTest, SpillAndPromote) {
+    temp_dir dir("spill");
+    TieredLRU storage(dir.path, 1, 64 * 1024, 16 * 1024 * 1024, false, 256 * 1024, 16 * 1024);
+    storage.Start();
+
+    // Ten times more than fits into memory
+    for (long i = 0; i < 5000; i++) {
+        put(storage, "Key " + std::to_string(i), i);
+    }
+    EXPECT_GT(storage.File().Items(), 4000);
+
+    std::string value;
+    for (long i = 0; i < 5000; i++) {
+        ASSERT_TRUE(storage.Get("Key " + std::to_string(i), value));
+        EXPECT_EQ(value_of(i), value);
+    }
+
+    // Item taken from the file is in memory now
+    storage.File().Flush();
+    EXPECT_TRUE(storage.Memory().Get("Key 4999", value));
+    EXPECT_FALSE(storage.File().Contains("Key 4999"));
+    storage.Stop();
+}
+
+TEST(TieredLRUTest, WritesHideFileRecords) {
+    temp_dir dir("writes");
+    TieredLRU storage(dir.path, 1, 64 * 1024, 16 * 1024 * 1024, false, 256 * 1024, 16 * 1024);
+    storage.Start();
+
+    for (long i = 0; i < 2000; i++) {
+        put(storage, "Key " + std::to_string(i), i);
+    }
+    ASSERT_TRUE(storage.File().Contains("Key 0"));
+    ASSERT_TRUE(storage.File().Contains("Key 1"));
+    ASSERT_TRUE(storage.File().Contains("Key 2"));
+    ASSERT_TRUE(storage.File().Contains("Key 3"));
+    ASSERT_TRUE(storage.File().Contains("Key 4"));
+
+    EXPECT_FALSE(storage.PutIfAbsent("Key 0", "new"));
+    EXPECT_TRUE(storage.Set("Key 1", "new"));
+    EXPECT_TRUE(storage.Put("Key 2", "new"));
+    EXPECT_TRUE(storage.Delete("Key 3"));
+    EXPECT_TRUE(storage.Append("Key 4", "+"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("Key 0", value));
+    EXPECT_EQ(value_of(0), value);
+    EXPECT_TRUE(storage.Get("Key 1", value));
+    EXPECT_EQ("new", value);
+    EXPECT_TRUE(storage.Get("Key 2", value));
+    EXPECT_EQ("new", value);
+    EXPECT_FALSE(storage.Get("Key 3", value));
+    EXPECT_TRUE(storage.Get("Key 4", value));
+    EXPECT_EQ(value_of(4) + "+", value);
+
+    std::vector<std::string> keys = {"Key 5", "Key 3", "Key 1999", "Key 6"};
+    std::vector<Afina::ValueView> values;
+    EXPECT_EQ(3, storage.MultiGet(keys, values));
+    EXPECT_EQ(value_of(5), values[0].str());
+    EXPECT_FALSE(values[1].valid());
+    EXPECT_EQ(value_of(1999), values[2].str());
+    EXPECT_EQ(value_of(6), values[3].str());
+    storage.Stop();
+}
+
+TEST(TieredLRUTest, AsyncReads) {
+    temp_dir dir("async");
+    TieredLRU storage(dir.path, 1, 64 * 1024, 16 * 1024 * 1024, true, 256 * 1024, 16 * 1024);
+    storage.Start();
+
+    for (long i = 0; i < 2000; i++) {
+        put(storage, "Key " + std::to_string(i), i);
+    }
+    storage.File().Flush();
+    ASSERT_TRUE(storage.File().Contains("Key 7"));
+
+    // Items are moved to memory on the reader thread, ready is called once for all of them unless the reads
+    // are over before Prepare returns
+    std::atomic<int> ready(0);
+    int expected = storage.Prepare({"Key 7", "Key 8", "Key 1999", "Key none", "Key 7"}, [&ready]() { ready++; });
+    for (int i = 0; i < 100 && ready.load() != expected; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(expected, ready.load());
+    std::string value;
+    EXPECT_TRUE(storage.Memory().Get("Key 7", value));
+    EXPECT_EQ(value_of(7), value);
+    EXPECT_TRUE(storage.Memory().Get("Key 8", value));
+    EXPECT_EQ(value_of(8), value);
+    EXPECT_FALSE(storage.File().Contains("Key 7"));
+
+    // Nothing to read
+    EXPECT_FALSE(storage.Prepare({"Key 7", "Key none"}, [&ready]() { ready++; }));
+
+    // File tier hit is never a miss, even if it wasn't prepared
+    ASSERT_TRUE(storage.File().Contains("Key 9"));
+    EXPECT_TRUE(storage.Get("Key 9", value));
+    EXPECT_EQ(value_of(9), value);
+    storage.Stop();
+    EXPECT_EQ(expected, ready.load());
+}
+
+TEST(TieredLRUTest, Compaction) {
+    temp_dir dir("compaction");
+    TieredLRU storage(dir.path, 1, 64 * 1024, 16 * 1024 * 1024, false, 64 * 1024, 8 * 1024);
+    storage.Start();
+
+    // Keys are overwritten over and over, most of the file records get dead
+    for (long i = 0; i < 30000; i++) {
+        put(storage, "Key " + std::to_string(i % 3000), i);
+    }
+    storage.File().Flush();
+    for (int i = 0; i < 100 && storage.File().Bytes() > 1024 * 1024; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_GT(storage.File().Compactions(), 0);
+    EXPECT_LT(storage.File().Bytes(), 1024 * 1024);
+
+    std::string value;
+    for (long i = 27000; i < 30000; i++) {
+        ASSERT_TRUE(storage.Get("Key " + std::to_string(i % 3000), value));
+        EXPECT_EQ(value_of(i), value);
+    }
+    storage.Stop();
+}
+
+TEST(TieredLRUTest, FileLimit) {
+    temp_dir dir("limit");
+    TieredLRU storage(dir.path, 1, 64 * 1024, 512 * 1024, false, 64 * 1024, 8 * 1024);
+    storage.Start();
+
+    for (long i = 0; i < 20000; i++) {
+        put(storage, "Key " + std::to_string(i), i);
+    }
+    storage.File().Flush();
+    for (int i = 0; i < 100 && storage.File().Bytes() > 512 * 1024; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_LE(storage.File().Bytes(), 512 * 1024);
+
+    // The oldest items are gone, the newest are still there
+    std::string value;
+    EXPECT_FALSE(storage.Get("Key 0", value));
+    EXPECT_TRUE(storage.Get("Key 19000", value));
+    EXPECT_EQ(value_of(19000), value);
+    storage.Stop();
+}
+
+TEST(TieredLRUTest, ConcurrentAccess) {
+    temp_dir dir("concurrent");
+    TieredLRU storage(dir.path, 4, 256 * 1024, 64 * 1024 * 1024, false, 256 * 1024, 16 * 1024);
+    storage.Start();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, t]() {
+            std::string value;
+            for (long i = 0; i < 5000; i++) {
+                std::string key = "Key " + std::to_string(t) + " " + std::to_string(i);
+                put(storage, key, i);
+                long back = i * 7 % (i + 1);
+                EXPECT_TRUE(storage.Get("Key " + std::to_string(t) + " " + std::to_string(back), value));
+                EXPECT_EQ(value_of(back), value);
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    storage.Stop();
+}
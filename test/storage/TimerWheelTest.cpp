@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include <random>
+#include <vector>
+
+#include "storage/TimerWheel.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+namespace {
+
+struct timer : public TimerWheel::entry {
+    uint32_t due = 0;
+    uint32_t fired_at = 0;
+};
+
+} // namespace
+
+TEST(TimerWheelTest, FireInTime) {
+    TimerWheel wheel(1000);
+
+    // Timers of all levels, including the ones beyond the last level
+    std::vector<uint32_t> delays = {0, 1, 63, 64, 65, 4095, 4096, 4097, 300000, 1 << 24, (1 << 24) + 5000};
+    std::vector<timer> timers(delays.size());
+    for (size_t i = 0; i < delays.size(); i++) {
+        timers[i].due = 1000 + delays[i];
+        wheel.Schedule(timers[i], timers[i].due);
+    }
+    EXPECT_EQ(delays.size(), wheel.Size());
+
+    uint32_t now = 1000;
+    auto fire = [&now](TimerWheel::entry &e) { static_cast<timer &>(e).fired_at = now; };
+    while (wheel.Size() > 0) {
+        wheel.Advance(now, 1000, fire);
+        // Large steps to check several seconds passed by one call
+        now += 7;
+    }
+
+    for (auto &t : timers) {
+        EXPECT_GE(t.fired_at, t.due);
+        EXPECT_LT(t.fired_at, t.due + 7);
+        EXPECT_EQ(0, t.expire);
+    }
+}
+
+TEST(TimerWheelTest, CancelAndLimit) {
+    TimerWheel wheel(0);
+
+    std::vector<timer> timers(100);
+    for (auto &t : timers) {
+        wheel.Schedule(t, 10);
+    }
+    for (size_t i = 0; i < timers.size(); i += 2) {
+        wheel.Cancel(timers[i]);
+    }
+    EXPECT_EQ(50, wheel.Size());
+
+    size_t fired = 0;
+    auto fire = [&fired](TimerWheel::entry &e) { fired++; };
+    EXPECT_EQ(0, wheel.Advance(9, 100, fire));
+    EXPECT_EQ(20, wheel.Advance(10, 20, fire));
+    EXPECT_EQ(30, wheel.Advance(100, 100, fire));
+    EXPECT_EQ(50, fired);
+    EXPECT_EQ(0, wheel.Size());
+}
+
+TEST(TimerWheelTest, RandomOrder) {
+    TimerWheel wheel(12345);
+    std::mt19937 random(42);
+    std::uniform_int_distribution<uint32_t> delay(1, 20000);
+
+    std::vector<timer> timers(10000);
+    for (auto &t : timers) {
+        t.due = 12345 + delay(random);
+        wheel.Schedule(t, t.due);
+    }
+
+    uint32_t now = 12345;
+    uint32_t last = 0;
+    auto fire = [&](TimerWheel::entry &e) {
+        timer &t = static_cast<timer &>(e);
+        EXPECT_EQ(now, t.due);
+        EXPECT_LE(last, t.due);
+        last = t.due;
+    };
+    while (wheel.Size() > 0) {
+        wheel.Advance(++now, timers.size(), fire);
+    }
+}
@@ -0,0 +1,131 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+#include "storage/SimpleLRU.h"
+#include "storage/TinyLFU.h"
+
+#include "Workload.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(TinyLFUTest, ItemTakesWholeStorage) {
+    TinyLFU storage(16);
+
+    // Item used as often as the one it would evict is not admitted
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY", "val"));
+    EXPECT_TRUE(storage.Put("KEY2", std::string(12, 'x')));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY", value));
+
+    // Used more often it takes whole storage
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Put("KEY2", std::string(12, 'x')));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_FALSE(storage.Get("KEY", value));
+}
+
+TEST(TinyLFUTest, BiggerThanWindow) {
+    TinyLFU storage(20000);
+
+    std::string out;
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 500; i++) {
+            std::string key = "hot" + std::to_string(i);
+            if (!storage.Get(key, out)) {
+                EXPECT_TRUE(storage.Put(key, std::string(32, 'v')));
+            }
+        }
+    }
+
+    std::vector<std::string> stored;
+    for (int i = 0; i < 500; i++) {
+        std::string key = "hot" + std::to_string(i);
+        if (storage.Get(key, out)) {
+            stored.push_back(key);
+        }
+    }
+
+    // Item doesn't fit the window, so it competes with hot keys at once and loses
+    const std::string big(5000, 'b');
+    EXPECT_TRUE(storage.Put("big", big));
+    EXPECT_FALSE(storage.Get("big", out));
+    for (auto &key : stored) {
+        EXPECT_TRUE(storage.Get(key, out));
+    }
+
+    // Once it is asked for more often than any hot key, it gets in and is not dropped by the admission of the
+    // next one
+    for (int round = 0; round < 20; round++) {
+        storage.Get("big", out);
+    }
+    EXPECT_TRUE(storage.Put("big", big));
+    EXPECT_TRUE(storage.Put("small", "val"));
+    EXPECT_TRUE(storage.Get("big", out));
+    EXPECT_EQ(big, out);
+}
+
+TEST(TinyLFUTest, HotKeysSurviveScan) {
+    const std::string value(32, 'v');
+    TinyLFU storage(200 * (8 + value.size()));
+
+    std::string out;
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 50; i++) {
+            std::string key = "hot" + std::to_string(i);
+            if (!storage.Get(key, out)) {
+                EXPECT_TRUE(storage.Put(key, value));
+            }
+        }
+    }
+
+    // Each key of the scan is seen once and must not push hot keys out
+    for (int i = 0; i < 2000; i++) {
+        std::string key = "scan" + std::to_string(i);
+        if (!storage.Get(key, out)) {
+            EXPECT_TRUE(storage.Put(key, value));
+        }
+    }
+
+    for (int i = 0; i < 50; i++) {
+        EXPECT_TRUE(storage.Get("hot" + std::to_string(i), out));
+    }
+}
+
+TEST(TinyLFUTest, ChurnKeepsBudget) {
+    TinyLFU storage(1000);
+
+    std::string out;
+    for (int i = 0; i < 100000; i++) {
+        std::string key = "KEY" + std::to_string(i % 777);
+        std::string value(i % 50, 'a' + i % 26);
+        if (i % 5 == 0) {
+            storage.Delete(key);
+        } else if (!storage.Get(key, out)) {
+            // Item bigger than the window could be rejected right away, but never leaves the stale value
+            EXPECT_TRUE(storage.Put(key, value));
+            if (storage.Get(key, out)) {
+                EXPECT_EQ(value, out);
+            }
+        }
+    }
+}
+
+// Compares with the exact LRU on the trace with scans, both keep the same number of items
+TEST(TinyLFUTest, CompareWithLRU) {
+    const size_t items = 1000;
+    const std::string value(32, 'v');
+    auto trace = Afina::Test::ZipfTrace(300000, 20000, 0.9, 42, 5000, 2000);
+
+    SimpleLRU lru(items * SimpleLRU::ItemSize(8, value.size()));
+    TinyLFU lfu(items * (8 + value.size()));
+
+    auto lru_result = Afina::Test::Replay(lru, trace, value);
+    auto lfu_result = Afina::Test::Replay(lfu, trace, value);
+    Afina::Test::PrintReplay("SimpleLRU", lru_result);
+    Afina::Test::PrintReplay("TinyLFU", lfu_result);
+
+    EXPECT_GT(lfu_result.HitRatio(), lru_result.HitRatio() + 0.05);
+}
@@ -0,0 +1,90 @@
+#ifndef AFINA_TEST_STORAGE_WORKLOAD_H
+#define AFINA_TEST_STORAGE_WORKLOAD_H
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Test {
+
+// Key or value of the fixed length
+inline std::string PadSpace(const std::string &s, std::size_t length) {
+    std::string result = s;
+    result.resize(length, ' ');
+    return result;
+}
+
+/**
+ * Trace of keys with Zipf distributed popularity: key of rank i is requested with probability
+ * proportional to 1 / i^skew. Every scan_every requests trace gets a scan of scan_length keys that are
+ * never seen again, the pattern LRU handles worst
+ */
+inline std::vector<std::string> ZipfTrace(std::size_t requests, std::size_t keys, double skew, unsigned seed,
+                                          std::size_t scan_every = 0, std::size_t scan_length = 0) {
+    std::vector<double> weights(keys);
+    for (std::size_t i = 0; i < keys; i++) {
+        weights[i] = 1.0 / std::pow(double(i + 1), skew);
+    }
+
+    std::mt19937 rnd(seed);
+    std::discrete_distribution<std::size_t> rank(weights.begin(), weights.end());
+
+    std::vector<std::string> trace;
+    trace.reserve(requests);
+    std::size_t scanned = 0;
+    while (trace.size() < requests) {
+        if (scan_every > 0 && trace.size() % scan_every == scan_every - 1) {
+            for (std::size_t i = 0; i < scan_length && trace.size() < requests; i++) {
+                trace.push_back("scan" + std::to_string(scanned++));
+            }
+            continue;
+        }
+        trace.push_back("key" + std::to_string(rank(rnd)));
+    }
+    return trace;
+}
+
+struct ReplayResult {
+    std::size_t requests;
+    std::size_t hits;
+    double seconds;
+
+    double HitRatio() const { return requests == 0 ? 0 : double(hits) / requests; }
+    double Throughput() const { return seconds == 0 ? 0 : requests / seconds; }
+};
+
+/**
+ * Replays trace as a read-through cache: Get and Put of the value on miss
+ */
+inline ReplayResult Replay(Afina::Storage &storage, const std::vector<std::string> &trace, const std::string &value) {
+    ReplayResult result{trace.size(), 0, 0};
+    std::string out;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string &key : trace) {
+        if (storage.Get(key, out)) {
+            result.hits++;
+        } else {
+            storage.Put(key, value);
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+inline void PrintReplay(const std::string &name, const ReplayResult &result) {
+    std::cout << std::left << std::setw(12) << name << " hit ratio " << std::fixed << std::setprecision(4)
+              << result.HitRatio() << ", " << std::setprecision(0) << result.Throughput() << " ops/s" << std::endl;
+}
+
+} // namespace Test
+} // namespace Afina
+
+#endif // AFINA_TEST_STORAGE_WORKLOAD_H